@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Builds and delegates each model once with the given AccelerationPolicyManager configs, so
+ * that the GPU serialization, NNAPI compilation and delegate decision caches they name are
+ * filled before the first real run (e.g. at installation or right after an OTA update).
+ *
+ * usage: auto-delegation-warm-cache --model MODEL --config CONFIG [--config CONFIG]...
+ *                                   [--model MODEL --config CONFIG...]...
+ *
+ * Each CONFIG is a JSON file in the format AccelerationPolicyManager(const std::string&)
+ * accepts, and applies to the MODEL given before it.
+ */
+
+#include <AutoDelegateSelector.h>
+#include <ModelLoader.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <dirent.h>
+
+using namespace aif;
+
+namespace
+{
+    typedef struct Job
+    {
+        std::string model;
+        std::string configPath;
+    } Job;
+
+    bool readFile(const std::string &path, std::string &content)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        content = ss.str();
+        return true;
+    }
+
+    // number of entries in dir whose name contains token, -1 if dir can not be read
+    int countCacheFiles(const std::string &dir, const std::string &token)
+    {
+        if (dir.empty())
+        {
+            return -1;
+        }
+        DIR *d = opendir(dir.c_str());
+        if (d == nullptr)
+        {
+            return -1;
+        }
+        int count = 0;
+        struct dirent *entry;
+        while ((entry = readdir(d)) != nullptr)
+        {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+                continue;
+            if (token.empty() || strstr(entry->d_name, token.c_str()) != nullptr)
+                count++;
+        }
+        closedir(d);
+        return count;
+    }
+
+    void printCacheState(const char *name, const std::string &dir, const std::string &token, int before)
+    {
+        if (dir.empty())
+        {
+            return;
+        }
+        int after = countCacheFiles(dir, token);
+        std::cout << "  " << name << " " << dir << " (" << token << "): ";
+        if (after < 0)
+            std::cout << "not readable" << std::endl;
+        else if (after > before)
+            std::cout << (after - (before < 0 ? 0 : before)) << " file(s) written" << std::endl;
+        else
+            std::cout << (after > 0 ? "already warm" : "nothing written") << std::endl;
+    }
+
+    bool warm(const Job &job)
+    {
+        std::cout << job.model << " with " << job.configPath << std::endl;
+
+        std::string config;
+        if (!readFile(job.configPath, config))
+        {
+            std::cerr << "  failed to read " << job.configPath << std::endl;
+            return false;
+        }
+        rapidjson::Document d;
+        d.Parse(config.c_str());
+        if (d.HasParseError() || !d.IsObject())
+        {
+            std::cerr << "  " << job.configPath << " is not a JSON object" << std::endl;
+            return false;
+        }
+        AccelerationPolicyManager apm(config);
+
+        std::shared_ptr<tflite::FlatBufferModel> model = ModelLoader::load(job.model, apm);
+        if (model == nullptr)
+        {
+            std::cerr << "  failed to load the model" << std::endl;
+            return false;
+        }
+
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        if (tflite::InterpreterBuilder(*model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+        {
+            std::cerr << "  failed to build the interpreter" << std::endl;
+            return false;
+        }
+
+        // the tokens selectDelegate() will derive, so the right cache files are reported
+        AutoDelegateSelector::resolveModelTokens(apm, *model);
+        const auto &gpuCache = apm.getCache();
+        const auto &nnapiCache = apm.getNnapiCache();
+        std::string gpuDir = gpuCache.useCache ? gpuCache.serialization_dir : "";
+        int gpuBefore = countCacheFiles(gpuDir, gpuCache.model_token);
+        int nnapiBefore = countCacheFiles(nnapiCache.cache_dir, nnapiCache.model_token);
+
+        // Delegation writes the GPU serialization and NNAPI compilation caches, and the first
+        // Invoke() makes sure every kernel has been compiled.
+        AutoDelegateSelector ads;
+        if (!ads.selectDelegate(*interpreter, apm, *model))
+        {
+            std::cerr << "  selectDelegate failed" << std::endl;
+            return false;
+        }
+        if (interpreter->AllocateTensors() != kTfLiteOk || interpreter->Invoke() != kTfLiteOk)
+        {
+            std::cerr << "  failed to run the delegated model" << std::endl;
+            return false;
+        }
+
+        std::cout << "  backends:";
+        const auto &decision = ads.getLastDecision();
+        if (decision.backends.empty())
+            std::cout << " CPU";
+        for (const auto &backend : decision.backends)
+            std::cout << " " << backend;
+        std::cout << std::endl;
+
+        printCacheState("serialization", gpuDir, gpuCache.model_token, gpuBefore);
+        printCacheState("caching", nnapiCache.cache_dir, nnapiCache.model_token, nnapiBefore);
+        if (!apm.getDecisionCachePath().empty())
+        {
+            std::cout << "  decision_cache " << apm.getDecisionCachePath() << std::endl;
+        }
+        return true;
+    }
+
+    void printUsage(const char *name)
+    {
+        std::cerr << "usage: " << name << " --model MODEL --config CONFIG [--config CONFIG]... [--model MODEL --config CONFIG...]..." << std::endl;
+    }
+
+    bool parseOptions(int argc, char **argv, std::vector<Job> &jobs)
+    {
+        std::string model;
+        bool hasConfig = false;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool hasValue = (i + 1 < argc);
+            if (arg == "--model" && hasValue)
+            {
+                if (!model.empty() && !hasConfig)
+                {
+                    std::cerr << model << " has no config" << std::endl;
+                    return false;
+                }
+                model = argv[++i];
+                hasConfig = false;
+            }
+            else if (arg == "--config" && hasValue)
+            {
+                if (model.empty())
+                {
+                    std::cerr << "--config must follow --model" << std::endl;
+                    return false;
+                }
+                jobs.push_back({model, argv[++i]});
+                hasConfig = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !jobs.empty() && hasConfig;
+    }
+} // end of anonymous namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<Job> jobs;
+    if (!parseOptions(argc, argv, jobs))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    for (const auto &job : jobs)
+    {
+        if (!warm(job))
+        {
+            failed++;
+        }
+    }
+
+    std::cout << (jobs.size() - failed) << "/" << jobs.size() << " warmed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
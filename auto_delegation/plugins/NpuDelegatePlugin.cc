@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegatePlugin.h"
+
+#include <aif/npu/npu_delegate.h>
+
+// The webOS NPU delegate as a DelegateRegistry plugin, so that only processes running an
+// NPU compiled model load the NPU driver stack.
+namespace
+{
+    TfLiteDelegate *create(const char *options)
+    {
+        (void)options;
+        webos::npu::tflite::NpuDelegateOptions npuOptions = webos::npu::tflite::NpuDelegateOptions();
+        return webos::npu::tflite::TfLiteNpuDelegateCreate(npuOptions);
+    }
+
+    void destroy(TfLiteDelegate *delegate)
+    {
+        webos::npu::tflite::TfLiteNpuDelegateDelete(delegate);
+    }
+
+    const AifDelegatePlugin s_plugin = {
+        AIF_DELEGATE_PLUGIN_ABI_VERSION,
+        "NPU",
+        create,
+        destroy,
+    };
+} // end of anonymous namespace
+
+extern "C" __attribute__((visibility("default"))) const AifDelegatePlugin *aif_delegate_plugin_get(void)
+{
+    return &s_plugin;
+}
@@ -5,9 +5,154 @@
 #include "AccelerationPolicyManager.h"
 #include "tools/Logger.h"
 
+#include <algorithm>
+
+#include "rapidjson/error/en.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#ifndef AIF_DELEGATE_PLUGIN_DIR
+#define AIF_DELEGATE_PLUGIN_DIR "/usr/lib/aif/delegate-plugins"
+#endif
+
 namespace
 {
     static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    enum FieldType
+    {
+        kFieldString = 0,
+        kFieldInt,
+        kFieldIntOrAuto,    // an integer, or "auto"
+        kFieldNumber,
+        kFieldBool,
+        kFieldObject,
+        kFieldPolicy,
+        kFieldSection,      // an object checked against the fields of the section of the same name
+    };
+
+    typedef struct Field
+    {
+        const char *name;
+        FieldType type;
+        std::vector<std::string> values;    // allowed values of a string, any if empty
+    } Field;
+
+    // what AccelerationPolicyManager(const rapidjson::Value &) reads, checked by load() and validate()
+    const std::vector<Field> kConfigFields = {
+        {"policy", kFieldPolicy, {}},
+        {"cpu_fallback_percentage", kFieldInt, {}},
+        {"max_memory_mb", kFieldInt, {}},
+        {"serialization", kFieldSection, {}},
+        {"caching", kFieldSection, {}},
+        {"xnnpack", kFieldSection, {}},
+        {"auto_tune", kFieldSection, {}},
+        {"threads", kFieldSection, {}},
+        {"partition_limits", kFieldSection, {}},
+        {"profiling", kFieldSection, {}},
+        {"model_loading", kFieldSection, {}},
+        {"cache_manager", kFieldSection, {}},
+        {"adaptive_fallback", kFieldSection, {}},
+        {"pool", kFieldSection, {}},
+        {"pipeline", kFieldSection, {}},
+        {"batching", kFieldSection, {}},
+        {"delegate_plugins", kFieldSection, {}},
+        {"decision_cache", kFieldSection, {}},
+    };
+
+    const std::map<std::string, std::vector<Field>> kSectionFields = {
+        {"serialization", {{"dir_path", kFieldString, {}}, {"model_token", kFieldString, {}}}},
+        {"caching", {{"cache_dir", kFieldString, {}}, {"model_token", kFieldString, {}}, {"disallow_nnapi_cpu", kFieldBool, {}},
+                     {"max_number_delegated_partitions", kFieldInt, {}}, {"accelerator_name", kFieldString, {}}}},
+        {"xnnpack", {{"num_threads", kFieldInt, {}}, {"enable_qs8", kFieldBool, {}}, {"enable_qu8", kFieldBool, {}},
+                     {"force_fp16", kFieldBool, {}}}},
+        {"auto_tune", {{"warmup_runs", kFieldInt, {}}, {"runs", kFieldInt, {}}}},
+        {"threads", {{"cluster", kFieldString, {"big", "little", "all"}}, {"num_threads", kFieldIntOrAuto, {}}}},
+        {"partition_limits", {{"max_delegated_partitions", kFieldInt, {}}, {"min_delegated_node_ratio", kFieldNumber, {}}}},
+        {"profiling", {{"enabled", kFieldBool, {}}, {"report_path", kFieldString, {}}}},
+        {"model_loading", {{"populate", kFieldBool, {}}, {"verify", kFieldBool, {}},
+                           {"advice", kFieldString, {"normal", "sequential", "random", "willneed"}}}},
+        {"cache_manager", {{"enabled", kFieldBool, {}}, {"max_mb", kFieldInt, {}}}},
+        {"adaptive_fallback", {{"enabled", kFieldBool, {}}, {"step", kFieldInt, {}}, {"window", kFieldInt, {}},
+                               {"hysteresis", kFieldNumber, {}}, {"redelegation_budget", kFieldNumber, {}}}},
+        {"pool", {{"size", kFieldIntOrAuto, {}}}},
+        {"pipeline", {{"max_stages", kFieldInt, {}}, {"queue_size", kFieldInt, {}}}},
+        {"batching", {{"max_batch_size", kFieldInt, {}}, {"window_ms", kFieldInt, {}}}},
+        {"delegate_plugins", {{"dir", kFieldString, {}}, {"options", kFieldObject, {}}}},
+        {"decision_cache", {{"path", kFieldString, {}}}},
+    };
+
+    bool validateFields(const rapidjson::Value &object, const std::vector<Field> &fields, const std::string &path,
+                        std::vector<std::string> &errors)
+    {
+        bool valid = true;
+        for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it)
+        {
+            std::string name = it->name.GetString();
+            std::string fieldPath = path.empty() ? name : path + "." + name;
+            auto field = std::find_if(fields.begin(), fields.end(), [&name](const Field &f) { return name == f.name; });
+            if (field == fields.end())
+            {
+                errors.push_back(fieldPath + ": unknown option");
+                valid = false;
+                continue;
+            }
+
+            const rapidjson::Value &value = it->value;
+            std::string error;
+            switch (field->type)
+            {
+            case kFieldString:
+                if (!value.IsString())
+                    error = "must be a string";
+                else if (!field->values.empty() &&
+                         std::find(field->values.begin(), field->values.end(), value.GetString()) == field->values.end())
+                    error = std::string("\"") + value.GetString() + "\" is not one of the allowed values";
+                break;
+            case kFieldInt:
+                if (!value.IsInt())
+                    error = "must be an integer";
+                break;
+            case kFieldIntOrAuto:
+                if (!value.IsInt() && !(value.IsString() && std::string(value.GetString()) == "auto"))
+                    error = "must be an integer or \"auto\"";
+                break;
+            case kFieldNumber:
+                if (!value.IsNumber())
+                    error = "must be a number";
+                break;
+            case kFieldBool:
+                if (!value.IsBool())
+                    error = "must be a boolean";
+                break;
+            case kFieldObject:
+                if (!value.IsObject())
+                    error = "must be an object";
+                break;
+            case kFieldPolicy:
+            {
+                aif::AccelerationPolicyManager::Policy policy;
+                if (!value.IsString())
+                    error = "must be a string";
+                else if (!aif::AccelerationPolicyManager::stringToPolicy(value.GetString(), policy))
+                    error = std::string("\"") + value.GetString() + "\" is not a policy";
+                break;
+            }
+            case kFieldSection:
+                if (!value.IsObject())
+                    error = "must be an object";
+                else if (!validateFields(value, kSectionFields.at(name), fieldPath, errors))
+                    valid = false;
+                break;
+            }
+            if (!error.empty())
+            {
+                errors.push_back(fieldPath + ": " + error);
+                valid = false;
+            }
+        }
+        return valid;
+    }
 } // end of anonymous namespace
 
 namespace aif
@@ -20,22 +165,65 @@ namespace aif
     {
         rapidjson::Document d;
         d.Parse(config.c_str());
+        if (d.HasParseError())
+        {
+            PmLogError(s_pmlogCtx, "APM", 0, "config is not valid JSON at offset %zu: %s", d.GetErrorOffset(),
+                       rapidjson::GetParseError_En(d.GetParseError()));
+            return;
+        }
+        load(d);
+    }
 
-        if (!d.HasParseError() && d.FindMember("policy") != d.MemberEnd())
+    AccelerationPolicyManager::AccelerationPolicyManager(const rapidjson::Value &config)
+    {
+        load(config);
+    }
+
+    void AccelerationPolicyManager::load(const rapidjson::Value &d)
+    {
+        if (!d.IsObject())
         {
-            Policy policy = stringToPolicy(d["policy"].GetString());
-            setPolicy(policy);
+            PmLogError(s_pmlogCtx, "APM", 0, "config is not a JSON object");
+            return;
+        }
 
-            if (d.FindMember("cpu_fallback_percentage") != d.MemberEnd())
+        // The options read below are checked against the same table as validate(), so an
+        // option that is unknown or of the wrong type is reported rather than silently ignored.
+        std::vector<std::string> errors;
+        validateFields(d, kConfigFields, "", errors);
+        for (const auto &error : errors)
+        {
+            PmLogWarning(s_pmlogCtx, "APM", 0, "%s", error.c_str());
+        }
+
+        if (d.HasMember("policy"))
+        {
+            if (d["policy"].IsString())
+            {
+                Policy policy = stringToPolicy(d["policy"].GetString());
+                setPolicy(policy);
+
+                if (d.HasMember("cpu_fallback_percentage"))
+                {
+                    if (d["cpu_fallback_percentage"].IsInt())
+                    {
+                        setCPUFallbackPercentage(d["cpu_fallback_percentage"].GetInt());
+                    }
+                    else
+                    {
+                        PmLogError(s_pmlogCtx, "APM", 0, "cpu_fallback_percentage is invalid");
+                    }
+                }
+            }
+            else
             {
-                int cpuFallbackPercentage = d["cpu_fallback_percentage"].GetInt();
-                setCPUFallbackPercentage(cpuFallbackPercentage);
+                PmLogError(s_pmlogCtx, "APM", 0, "policy is invalid");
             }
         }
 
-        if (!d.HasParseError() && d.HasMember("serialization"))
+        if (d.HasMember("serialization"))
         {
-            if (d["serialization"].HasMember("dir_path") && d["serialization"].HasMember("model_token"))
+            if (d["serialization"].IsObject() && d["serialization"].HasMember("dir_path") && d["serialization"].HasMember("model_token"))
             {
                 Caching cache;
 
@@ -50,9 +238,9 @@ namespace aif
             }
         }
 
-        if (!d.HasParseError() && d.HasMember("caching"))
+        if (d.HasMember("caching"))
         {
-            if (d["caching"].HasMember("cache_dir") && d["caching"].HasMember("model_token"))
+            if (d["caching"].IsObject() && d["caching"].HasMember("cache_dir") && d["caching"].HasMember("model_token"))
             {
                 std::string cache_dir = "";
                 std::string model_token = "";
@@ -84,6 +272,380 @@ namespace aif
                 PmLogError(s_pmlogCtx, "APM", 0, "cache_dir or model_token is invalid");
             }
         }
+
+        if (d.HasMember("xnnpack"))
+        {
+            if (d["xnnpack"].IsObject())
+            {
+                XnnpackOptions options = {0, false, false, false};
+                const auto &xnnpack = d["xnnpack"];
+
+                if (xnnpack.HasMember("num_threads"))
+                {
+                    options.num_threads = xnnpack["num_threads"].IsInt() ? xnnpack["num_threads"].GetInt() : 0;
+                }
+                if (xnnpack.HasMember("enable_qs8"))
+                {
+                    options.enable_qs8 = xnnpack["enable_qs8"].IsBool() ? xnnpack["enable_qs8"].GetBool() : false;
+                }
+                if (xnnpack.HasMember("enable_qu8"))
+                {
+                    options.enable_qu8 = xnnpack["enable_qu8"].IsBool() ? xnnpack["enable_qu8"].GetBool() : false;
+                }
+                if (xnnpack.HasMember("force_fp16"))
+                {
+                    options.force_fp16 = xnnpack["force_fp16"].IsBool() ? xnnpack["force_fp16"].GetBool() : false;
+                }
+
+                setXnnpackOptions(std::move(options));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "xnnpack options are invalid");
+            }
+        }
+
+        if (d.HasMember("auto_tune"))
+        {
+            if (d["auto_tune"].IsObject())
+            {
+                AutoTuning tuning = getAutoTuning();
+                const auto &autoTune = d["auto_tune"];
+
+                if (autoTune.HasMember("warmup_runs"))
+                {
+                    tuning.warmup_runs = autoTune["warmup_runs"].IsInt() ? autoTune["warmup_runs"].GetInt() : tuning.warmup_runs;
+                }
+                if (autoTune.HasMember("runs"))
+                {
+                    tuning.runs = autoTune["runs"].IsInt() ? autoTune["runs"].GetInt() : tuning.runs;
+                }
+
+                setAutoTuning(std::move(tuning));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "auto_tune options are invalid");
+            }
+        }
+
+        if (d.HasMember("threads"))
+        {
+            if (d["threads"].IsObject())
+            {
+                ThreadPolicy threadPolicy = {-1, kClusterAuto};
+                const auto &threads = d["threads"];
+
+                if (threads.HasMember("cluster") && threads["cluster"].IsString())
+                {
+                    std::string cluster = threads["cluster"].GetString();
+                    threadPolicy.num_threads = 0;
+                    if (cluster.compare("big") == 0)
+                        threadPolicy.cluster = kClusterBig;
+                    else if (cluster.compare("little") == 0)
+                        threadPolicy.cluster = kClusterLittle;
+                    else if (cluster.compare("all") == 0)
+                        threadPolicy.cluster = kClusterAll;
+                    else
+                        PmLogError(s_pmlogCtx, "APM", 0, "threads cluster %s is invalid", cluster.c_str());
+                }
+                if (threads.HasMember("num_threads"))
+                {
+                    if (threads["num_threads"].IsInt())
+                    {
+                        threadPolicy.num_threads = threads["num_threads"].GetInt();
+                    }
+                    else if (threads["num_threads"].IsString() &&
+                             std::string(threads["num_threads"].GetString()).compare("auto") == 0)
+                    {
+                        threadPolicy.num_threads = 0;
+                        threadPolicy.cluster = kClusterAuto;
+                    }
+                    else
+                    {
+                        PmLogError(s_pmlogCtx, "APM", 0, "threads num_threads is invalid");
+                    }
+                }
+
+                setThreadPolicy(std::move(threadPolicy));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "threads options are invalid");
+            }
+        }
+
+        if (d.HasMember("partition_limits"))
+        {
+            if (d["partition_limits"].IsObject())
+            {
+                PartitionLimits limits = getPartitionLimits();
+                const auto &partitionLimits = d["partition_limits"];
+
+                if (partitionLimits.HasMember("max_delegated_partitions"))
+                {
+                    limits.max_delegated_partitions = partitionLimits["max_delegated_partitions"].IsInt() ?
+                                                      partitionLimits["max_delegated_partitions"].GetInt() : limits.max_delegated_partitions;
+                }
+                if (partitionLimits.HasMember("min_delegated_node_ratio"))
+                {
+                    limits.min_delegated_node_ratio = partitionLimits["min_delegated_node_ratio"].IsNumber() ?
+                                                      partitionLimits["min_delegated_node_ratio"].GetDouble() : limits.min_delegated_node_ratio;
+                }
+
+                setPartitionLimits(std::move(limits));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "partition_limits options are invalid");
+            }
+        }
+
+        if (d.HasMember("max_memory_mb"))
+        {
+            if (d["max_memory_mb"].IsInt())
+            {
+                setMaxMemoryMB(d["max_memory_mb"].GetInt());
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "max_memory_mb is invalid");
+            }
+        }
+
+        if (d.HasMember("profiling"))
+        {
+            if (d["profiling"].IsObject())
+            {
+                Profiling profiling = {true, ""};
+                const auto &profilingConfig = d["profiling"];
+
+                if (profilingConfig.HasMember("enabled"))
+                {
+                    profiling.enabled = profilingConfig["enabled"].IsBool() ? profilingConfig["enabled"].GetBool() : true;
+                }
+                if (profilingConfig.HasMember("report_path") && profilingConfig["report_path"].IsString())
+                {
+                    profiling.report_path = profilingConfig["report_path"].GetString();
+                }
+
+                setProfiling(std::move(profiling));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "profiling options are invalid");
+            }
+        }
+
+        if (d.HasMember("model_loading"))
+        {
+            if (d["model_loading"].IsObject())
+            {
+                ModelLoading loading = getModelLoading();
+                const auto &loadingConfig = d["model_loading"];
+
+                if (loadingConfig.HasMember("populate"))
+                {
+                    loading.populate = loadingConfig["populate"].IsBool() ? loadingConfig["populate"].GetBool() : loading.populate;
+                }
+                if (loadingConfig.HasMember("verify"))
+                {
+                    loading.verify = loadingConfig["verify"].IsBool() ? loadingConfig["verify"].GetBool() : loading.verify;
+                }
+                if (loadingConfig.HasMember("advice") && loadingConfig["advice"].IsString())
+                {
+                    std::string advice = loadingConfig["advice"].GetString();
+                    if (advice.compare("normal") == 0)
+                        loading.advice = kAdviceNormal;
+                    else if (advice.compare("sequential") == 0)
+                        loading.advice = kAdviceSequential;
+                    else if (advice.compare("random") == 0)
+                        loading.advice = kAdviceRandom;
+                    else if (advice.compare("willneed") == 0)
+                        loading.advice = kAdviceWillNeed;
+                    else
+                        PmLogError(s_pmlogCtx, "APM", 0, "model_loading advice %s is invalid", advice.c_str());
+                }
+
+                setModelLoading(std::move(loading));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "model_loading options are invalid");
+            }
+        }
+
+        if (d.HasMember("cache_manager"))
+        {
+            if (d["cache_manager"].IsObject())
+            {
+                CacheManagement management = {true, 0};
+                const auto &managerConfig = d["cache_manager"];
+
+                if (managerConfig.HasMember("enabled"))
+                {
+                    management.enabled = managerConfig["enabled"].IsBool() ? managerConfig["enabled"].GetBool() : true;
+                }
+                if (managerConfig.HasMember("max_mb"))
+                {
+                    if (managerConfig["max_mb"].IsInt())
+                        management.max_mb = managerConfig["max_mb"].GetInt();
+                    else
+                        PmLogError(s_pmlogCtx, "APM", 0, "cache_manager max_mb is invalid");
+                }
+
+                setCacheManagement(std::move(management));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "cache_manager options are invalid");
+            }
+        }
+
+        if (d.HasMember("adaptive_fallback"))
+        {
+            if (d["adaptive_fallback"].IsObject())
+            {
+                AdaptiveFallback adaptiveFallback = getAdaptiveFallback();
+                adaptiveFallback.enabled = true;
+                const auto &fallbackConfig = d["adaptive_fallback"];
+
+                if (fallbackConfig.HasMember("enabled"))
+                {
+                    adaptiveFallback.enabled = fallbackConfig["enabled"].IsBool() ? fallbackConfig["enabled"].GetBool() : true;
+                }
+                if (fallbackConfig.HasMember("step") && fallbackConfig["step"].IsInt())
+                {
+                    adaptiveFallback.step = fallbackConfig["step"].GetInt();
+                }
+                if (fallbackConfig.HasMember("window") && fallbackConfig["window"].IsInt())
+                {
+                    adaptiveFallback.window = fallbackConfig["window"].GetInt();
+                }
+                if (fallbackConfig.HasMember("hysteresis") && fallbackConfig["hysteresis"].IsNumber())
+                {
+                    adaptiveFallback.hysteresis = fallbackConfig["hysteresis"].GetDouble();
+                }
+                if (fallbackConfig.HasMember("redelegation_budget") && fallbackConfig["redelegation_budget"].IsNumber())
+                {
+                    adaptiveFallback.redelegation_budget = fallbackConfig["redelegation_budget"].GetDouble();
+                }
+
+                setAdaptiveFallback(std::move(adaptiveFallback));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "adaptive_fallback options are invalid");
+            }
+        }
+
+        if (d.HasMember("pool"))
+        {
+            if (d["pool"].IsObject() && d["pool"].HasMember("size") && d["pool"]["size"].IsInt())
+            {
+                setPoolSize(d["pool"]["size"].GetInt());
+            }
+            else if (d["pool"].IsObject() && d["pool"].HasMember("size") && d["pool"]["size"].IsString() &&
+                     std::string(d["pool"]["size"].GetString()).compare("auto") == 0)
+            {
+                setPoolSize(0);
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "pool size is invalid");
+            }
+        }
+
+        if (d.HasMember("pipeline"))
+        {
+            if (d["pipeline"].IsObject())
+            {
+                Pipeline pipeline = getPipeline();
+                const auto &pipelineConfig = d["pipeline"];
+
+                if (pipelineConfig.HasMember("max_stages") && pipelineConfig["max_stages"].IsInt())
+                {
+                    pipeline.max_stages = pipelineConfig["max_stages"].GetInt();
+                }
+                if (pipelineConfig.HasMember("queue_size") && pipelineConfig["queue_size"].IsInt())
+                {
+                    pipeline.queue_size = pipelineConfig["queue_size"].GetInt();
+                }
+
+                setPipeline(std::move(pipeline));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "pipeline options are invalid");
+            }
+        }
+
+        if (d.HasMember("batching"))
+        {
+            if (d["batching"].IsObject())
+            {
+                Batching batching = getBatching();
+                const auto &batchingConfig = d["batching"];
+
+                if (batchingConfig.HasMember("max_batch_size") && batchingConfig["max_batch_size"].IsInt())
+                {
+                    batching.max_batch_size = batchingConfig["max_batch_size"].GetInt();
+                }
+                if (batchingConfig.HasMember("window_ms") && batchingConfig["window_ms"].IsInt())
+                {
+                    batching.window_ms = batchingConfig["window_ms"].GetInt();
+                }
+
+                setBatching(std::move(batching));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "batching options are invalid");
+            }
+        }
+
+        if (d.HasMember("delegate_plugins"))
+        {
+            if (d["delegate_plugins"].IsObject())
+            {
+                DelegatePlugins plugins = getDelegatePlugins();
+                const auto &pluginsConfig = d["delegate_plugins"];
+
+                if (pluginsConfig.HasMember("dir") && pluginsConfig["dir"].IsString())
+                {
+                    plugins.dir = pluginsConfig["dir"].GetString();
+                }
+                if (pluginsConfig.HasMember("options") && pluginsConfig["options"].IsObject())
+                {
+                    const auto &options = pluginsConfig["options"];
+                    for (auto it = options.MemberBegin(); it != options.MemberEnd(); ++it)
+                    {
+                        rapidjson::StringBuffer buffer;
+                        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+                        it->value.Accept(writer);
+                        plugins.options[it->name.GetString()] = buffer.GetString();
+                    }
+                }
+
+                setDelegatePlugins(std::move(plugins));
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "delegate_plugins options are invalid");
+            }
+        }
+
+        if (d.HasMember("decision_cache"))
+        {
+            if (d["decision_cache"].IsObject() && d["decision_cache"].HasMember("path") && d["decision_cache"]["path"].IsString())
+            {
+                setDecisionCachePath(d["decision_cache"]["path"].GetString());
+            }
+            else
+            {
+                PmLogError(s_pmlogCtx, "APM", 0, "decision_cache path is invalid");
+            }
+        }
     }
 
     AccelerationPolicyManager::~AccelerationPolicyManager()
@@ -117,6 +679,9 @@ namespace aif
         case kMinLatencyMinRes:
             PmLogInfo(s_pmlogCtx, "APM", 0, "Set Acceleration Policy: Min Latency Min Res");
             break;
+        case kAutoTune:
+            PmLogInfo(s_pmlogCtx, "APM", 0, "Set Acceleration Policy: Auto Tune");
+            break;
         default:
             break;
         }
@@ -151,6 +716,199 @@ namespace aif
         return m_nnapi_cache;
     }
 
+    void AccelerationPolicyManager::setXnnpackOptions(AccelerationPolicyManager::XnnpackOptions options)
+    {
+        if (options.num_threads < 0)
+            options.num_threads = 0;
+
+        m_xnnpack_options = std::move(options);
+    }
+
+    const AccelerationPolicyManager::XnnpackOptions& AccelerationPolicyManager::getXnnpackOptions()
+    {
+        return m_xnnpack_options;
+    }
+
+    void AccelerationPolicyManager::setAutoTuning(AccelerationPolicyManager::AutoTuning tuning)
+    {
+        if (tuning.warmup_runs < 0)
+            tuning.warmup_runs = 0;
+        if (tuning.runs < 1)
+            tuning.runs = 1;
+
+        m_auto_tuning = std::move(tuning);
+    }
+
+    const AccelerationPolicyManager::AutoTuning& AccelerationPolicyManager::getAutoTuning()
+    {
+        return m_auto_tuning;
+    }
+
+    void AccelerationPolicyManager::setThreadPolicy(AccelerationPolicyManager::ThreadPolicy threadPolicy)
+    {
+        if (threadPolicy.num_threads < -1)
+            threadPolicy.num_threads = -1;
+
+        m_thread_policy = std::move(threadPolicy);
+    }
+
+    const AccelerationPolicyManager::ThreadPolicy& AccelerationPolicyManager::getThreadPolicy()
+    {
+        return m_thread_policy;
+    }
+
+    void AccelerationPolicyManager::setPartitionLimits(AccelerationPolicyManager::PartitionLimits limits)
+    {
+        if (limits.max_delegated_partitions < 0)
+            limits.max_delegated_partitions = 0;
+        if (limits.min_delegated_node_ratio < 0.0)
+            limits.min_delegated_node_ratio = 0.0;
+        else if (limits.min_delegated_node_ratio > 1.0)
+            limits.min_delegated_node_ratio = 1.0;
+
+        m_partition_limits = std::move(limits);
+    }
+
+    const AccelerationPolicyManager::PartitionLimits& AccelerationPolicyManager::getPartitionLimits()
+    {
+        return m_partition_limits;
+    }
+
+    void AccelerationPolicyManager::setMaxMemoryMB(int maxMemoryMB)
+    {
+        if (maxMemoryMB < 0)
+            maxMemoryMB = 0;
+
+        m_max_memory_mb = maxMemoryMB;
+    }
+
+    int AccelerationPolicyManager::getMaxMemoryMB()
+    {
+        return m_max_memory_mb;
+    }
+
+    void AccelerationPolicyManager::setProfiling(AccelerationPolicyManager::Profiling profiling)
+    {
+        m_profiling = std::move(profiling);
+    }
+
+    const AccelerationPolicyManager::Profiling& AccelerationPolicyManager::getProfiling()
+    {
+        return m_profiling;
+    }
+
+    void AccelerationPolicyManager::setModelLoading(AccelerationPolicyManager::ModelLoading loading)
+    {
+        m_model_loading = std::move(loading);
+    }
+
+    const AccelerationPolicyManager::ModelLoading& AccelerationPolicyManager::getModelLoading()
+    {
+        return m_model_loading;
+    }
+
+    void AccelerationPolicyManager::setCacheManagement(AccelerationPolicyManager::CacheManagement management)
+    {
+        if (management.max_mb < 0)
+            management.max_mb = 0;
+
+        m_cache_management = std::move(management);
+    }
+
+    const AccelerationPolicyManager::CacheManagement& AccelerationPolicyManager::getCacheManagement()
+    {
+        return m_cache_management;
+    }
+
+    void AccelerationPolicyManager::setAdaptiveFallback(AccelerationPolicyManager::AdaptiveFallback adaptiveFallback)
+    {
+        if (adaptiveFallback.step < 1)
+            adaptiveFallback.step = 1;
+        else if (adaptiveFallback.step > 100)
+            adaptiveFallback.step = 100;
+        if (adaptiveFallback.window < 1)
+            adaptiveFallback.window = 1;
+        if (adaptiveFallback.hysteresis < 0.0)
+            adaptiveFallback.hysteresis = 0.0;
+        if (adaptiveFallback.redelegation_budget < 0.0)
+            adaptiveFallback.redelegation_budget = 0.0;
+
+        m_adaptive_fallback = std::move(adaptiveFallback);
+    }
+
+    const AccelerationPolicyManager::AdaptiveFallback& AccelerationPolicyManager::getAdaptiveFallback()
+    {
+        return m_adaptive_fallback;
+    }
+
+    void AccelerationPolicyManager::setPoolSize(int size)
+    {
+        if (size < 0)
+            size = 0;
+
+        m_pool_size = size;
+    }
+
+    int AccelerationPolicyManager::getPoolSize()
+    {
+        return m_pool_size;
+    }
+
+    void AccelerationPolicyManager::setPipeline(AccelerationPolicyManager::Pipeline pipeline)
+    {
+        if (pipeline.max_stages < 0)
+            pipeline.max_stages = 0;
+        if (pipeline.queue_size < 1)
+            pipeline.queue_size = 1;
+
+        m_pipeline = std::move(pipeline);
+    }
+
+    const AccelerationPolicyManager::Pipeline& AccelerationPolicyManager::getPipeline()
+    {
+        return m_pipeline;
+    }
+
+    void AccelerationPolicyManager::setBatching(AccelerationPolicyManager::Batching batching)
+    {
+        if (batching.max_batch_size < 1)
+            batching.max_batch_size = 1;
+        if (batching.window_ms < 0)
+            batching.window_ms = 0;
+
+        m_batching = std::move(batching);
+    }
+
+    const AccelerationPolicyManager::Batching& AccelerationPolicyManager::getBatching()
+    {
+        return m_batching;
+    }
+
+    void AccelerationPolicyManager::setDelegatePlugins(AccelerationPolicyManager::DelegatePlugins plugins)
+    {
+        m_delegate_plugins = std::move(plugins);
+    }
+
+    const AccelerationPolicyManager::DelegatePlugins& AccelerationPolicyManager::getDelegatePlugins()
+    {
+        return m_delegate_plugins;
+    }
+
+    const char* AccelerationPolicyManager::getDefaultDelegatePluginDir()
+    {
+        return AIF_DELEGATE_PLUGIN_DIR;
+    }
+
+    void AccelerationPolicyManager::setDecisionCachePath(std::string path)
+    {
+        m_decision_cache_path = std::move(path);
+    }
+
+    const std::string& AccelerationPolicyManager::getDecisionCachePath()
+    {
+        return m_decision_cache_path;
+    }
+
     bool AccelerationPolicyManager::setCPUFallbackPercentage(int percentage)
     {
         if (percentage < 0)
@@ -170,10 +928,25 @@ namespace aif
         return m_cpuFallbackPercentage;
     }
 
-    AccelerationPolicyManager::Policy AccelerationPolicyManager::stringToPolicy(const std::string &policyStr)
+    bool AccelerationPolicyManager::validate(const rapidjson::Value &config, const std::string &path, std::vector<std::string> &errors)
     {
+        if (!config.IsObject())
+        {
+            errors.push_back((path.empty() ? std::string("config") : path) + ": must be an object");
+            return false;
+        }
+        return validateFields(config, kConfigFields, path, errors);
+    }
 
+    AccelerationPolicyManager::Policy AccelerationPolicyManager::stringToPolicy(const std::string &policyStr)
+    {
         AccelerationPolicyManager::Policy policy = AccelerationPolicyManager::Policy::kCPUOnly;
+        stringToPolicy(policyStr, policy);
+        return policy;
+    }
+
+    bool AccelerationPolicyManager::stringToPolicy(const std::string &policyStr, AccelerationPolicyManager::Policy &policy)
+    {
         if (policyStr.compare("CPU_ONLY") == 0)
             policy = AccelerationPolicyManager::Policy::kCPUOnly;
         else if (policyStr.compare("MAX_PRECISION") == 0)
@@ -188,7 +961,11 @@ namespace aif
             policy = AccelerationPolicyManager::Policy::kMinRes;
         else if (policyStr.compare("MIN_LATENCY_MIN_RES") == 0)
             policy = AccelerationPolicyManager::Policy::kMinLatencyMinRes;
+        else if (policyStr.compare("AUTO_TUNE") == 0)
+            policy = AccelerationPolicyManager::Policy::kAutoTune;
+        else
+            return false;
 
-        return policy;
+        return true;
     }
 } // end of namespace aif
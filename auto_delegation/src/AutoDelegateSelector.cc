@@ -3,103 +3,1200 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "AutoDelegateSelector.h"
+#include "CacheManager.h"
+#include "DelegateCache.h"
+#include "DelegateRegistry.h"
+#include "DeviceCapabilities.h"
+#include "XnnpackDelegateOptions.h"
+#include "tools/Hash.h"
+#include "tools/PartitionAnalyzer.h"
 #include "tools/Logger.h"
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include <tensorflow/lite/version.h>
+
+#ifndef AUTO_DELEGATION_VERSION
+#define AUTO_DELEGATION_VERSION "unknown"
+#endif
+
 namespace
 {
     static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    // An accelerator that leaves at most this share of the nodes on CPU has taken the bulk of the graph.
+    const double kAcceleratedCPUNodeRatio = 0.1;
+
+    // model_token value that asks for AutoDelegateSelector::deriveModelToken()
+    const char *kAutoModelToken = "auto";
+
+    // Turns off the caches whose model_token is still "auto", so that nothing is cached
+    // under that name, which would be the same for every model.
+    void disableAutoModelTokens(aif::AccelerationPolicyManager &apm)
+    {
+        aif::AccelerationPolicyManager::Caching gpuCache = apm.getCache();
+        if (gpuCache.useCache && gpuCache.model_token == kAutoModelToken)
+        {
+            gpuCache.useCache = false;
+            apm.setCache(std::move(gpuCache));
+        }
+        aif::AccelerationPolicyManager::NnapiCaching nnapiCache = apm.getNnapiCache();
+        if (nnapiCache.model_token == kAutoModelToken)
+        {
+            apm.setNnapiCache("", "", nnapiCache.disallow_nnapi_cpu, nnapiCache.max_number_delegated_partitions,
+                              nnapiCache.accelerator_name);
+        }
+    }
+
+    // decisions name plugins apart from the built-in backends, e.g. "plugin:NPU"
+    const std::string kPluginPrefix = "plugin:";
+
+    std::string pluginToString(const std::string &plugin)
+    {
+        return kPluginPrefix + plugin;
+    }
+
+    bool stringToPlugin(const std::string &backendStr, std::string &plugin)
+    {
+        if (backendStr.compare(0, kPluginPrefix.size(), kPluginPrefix) != 0)
+        {
+            return false;
+        }
+        plugin = backendStr.substr(kPluginPrefix.size());
+        return true;
+    }
+
+    bool hasDelegateNode(tflite::Interpreter &interpreter)
+    {
+        const tflite::Subgraph &subgraph = interpreter.primary_subgraph();
+        const auto &nodes = subgraph.nodes_and_registration();
+        for (int index : subgraph.execution_plan())
+        {
+            if (nodes[index].second.builtin_code == tflite::BuiltinOperator_DELEGATE)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // everything but the model content that goes into a derived model_token
+    std::string getModelTokenOptions(aif::AutoDelegateSelector::Backend backend, aif::AccelerationPolicyManager &apm)
+    {
+        std::string options = std::string(AUTO_DELEGATION_VERSION) + ";" + TFLITE_VERSION_STRING + ";" +
+                              aif::DelegateDecisionCache::getDeviceFingerprint() + ";" +
+                              aif::AutoDelegateSelector::backendToString(backend) + ";" +
+                              std::to_string(apm.getPolicy()) + ";" +
+                              std::to_string(apm.getPartitionLimits().max_delegated_partitions) + ";";
+        if (backend == aif::AutoDelegateSelector::kBackendGPU)
+        {
+            options += std::to_string(apm.getCPUFallbackPercentage()) + ";";
+#ifdef GPU_DELEGATE_ONLY_GL
+            options += "gl;";
+#elif GPU_DELEGATE_ONLY_CL
+            options += "cl;";
+#endif
+        }
+        else if (backend == aif::AutoDelegateSelector::kBackendNNAPI)
+        {
+            const auto &cache = apm.getNnapiCache();
+            options += cache.accelerator_name + ";" + std::to_string(cache.disallow_nnapi_cpu) + ";" +
+                       std::to_string(cache.max_number_delegated_partitions) + ";";
+        }
+        return options;
+    }
+
+    template <typename T, typename Generator>
+    void fillTensor(TfLiteTensor *tensor, Generator &&generator)
+    {
+        T *data = reinterpret_cast<T *>(tensor->data.raw);
+        size_t count = tensor->bytes / sizeof(T);
+        for (size_t i = 0; i < count; i++)
+        {
+            data[i] = static_cast<T>(generator());
+        }
+    }
+
+    // Same value range as GraphTester::fillRandomInputTensor(), but for every input tensor.
+    void fillRandomInputs(tflite::Interpreter &interpreter)
+    {
+        std::mt19937 gen(0);
+        std::uniform_int_distribution<> dist(0, 255);
+        auto pixel = [&]() { return dist(gen); };
+        auto normalized = [&]() { return static_cast<float>(dist(gen)) / 256.0f; };
+        auto signedPixel = [&]() { return dist(gen) - 128; };
+
+        for (int index : interpreter.inputs())
+        {
+            TfLiteTensor *tensor = interpreter.tensor(index);
+            if (tensor == nullptr || tensor->data.raw == nullptr)
+                continue;
+
+            switch (tensor->type)
+            {
+            case kTfLiteFloat32:
+                fillTensor<float>(tensor, normalized);
+                break;
+            case kTfLiteFloat64:
+                fillTensor<double>(tensor, normalized);
+                break;
+            case kTfLiteInt8:
+                fillTensor<int8_t>(tensor, signedPixel);
+                break;
+            case kTfLiteUInt8:
+                fillTensor<uint8_t>(tensor, pixel);
+                break;
+            case kTfLiteInt16:
+                fillTensor<int16_t>(tensor, pixel);
+                break;
+            case kTfLiteInt32:
+                fillTensor<int32_t>(tensor, pixel);
+                break;
+            case kTfLiteUInt32:
+                fillTensor<uint32_t>(tensor, pixel);
+                break;
+            case kTfLiteInt64:
+                fillTensor<int64_t>(tensor, pixel);
+                break;
+            case kTfLiteUInt64:
+                fillTensor<uint64_t>(tensor, pixel);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+#if defined(USE_GPU) || defined(USE_NNAPI)
+    // The NNAPI delegate compiles, and so writes its cache, when its kernel is prepared. The
+    // staged files are only complete after AllocateTensors(), so it runs before publishing.
+    void publishCache(tflite::Interpreter &interpreter, aif::CacheManager &cacheManager, const std::string &token)
+    {
+        if (interpreter.AllocateTensors() != kTfLiteOk)
+        {
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "AllocateTensors failed, %s is not published", token.c_str());
+            return;
+        }
+        cacheManager.publish(token);
+    }
+#endif
 } // end of anonymous namespace
 
-namespace aif
-{
-    AutoDelegateSelector::AutoDelegateSelector()
-    {
+namespace aif
+{
+    AutoDelegateSelector::AutoDelegateSelector()
+    {
+    }
+
+    bool AutoDelegateSelector::selectDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int originalNodeNum = interpreter.primary_subgraph().execution_plan().size();
+        attachProfiler(interpreter, apm);
+
+        m_decision = {{}, {}, -1, false};
+        m_decision.result = selectDelegateByPolicy(interpreter, apm);
+
+        applyThreadPolicy(interpreter, apm, originalNodeNum);
+        recordStats(interpreter, originalNodeNum, start);
+        return m_decision.result;
+    }
+
+    bool AutoDelegateSelector::selectDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int originalNodeNum = interpreter.primary_subgraph().execution_plan().size();
+        attachProfiler(interpreter, apm);
+
+        AccelerationPolicyManager resolvedApm = apm;
+        if (!resolveModelTokens(resolvedApm, model))
+        {
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "model_token auto could not be derived, delegate caches are disabled");
+            disableAutoModelTokens(resolvedApm);
+        }
+        bool result = selectDelegateWithModel(interpreter, resolvedApm, model);
+
+        applyThreadPolicy(interpreter, apm, originalNodeNum);
+        recordStats(interpreter, originalNodeNum, start);
+        return result;
+    }
+
+    bool AutoDelegateSelector::selectDelegateWithModel(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model)
+    {
+        const std::string &cachePath = apm.getDecisionCachePath();
+        DelegateDecisionCache cache(cachePath);
+        std::string key;
+        if (!cachePath.empty())
+        {
+            cache.load();
+            key = DelegateDecisionCache::makeKey(model, apm);
+        }
+
+        DelegateDecisionCache::Decision decision;
+        if (!key.empty() && cache.lookup(key, decision))
+        {
+            if (replayDecision(interpreter, apm, decision))
+            {
+                return decision.result;
+            }
+
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "stored delegate decision could not be applied. It is removed from %s", cachePath.c_str());
+            cache.erase(key);
+            cache.save();
+            // TFLite undoes every delegate when one fails to prepare, so the graph is normally
+            // back to the plain CPU one. If it is not, it cannot be delegated again.
+            if (hasDelegateNode(interpreter))
+            {
+                PmLogError(s_pmlogCtx, "ADS", 0, "interpreter is partly delegated by the stored decision. Rebuild it and select again");
+                return false;
+            }
+        }
+
+        m_decision = {{}, {}, -1, false};
+        m_footprint = {{0, 0, 0, 0}, -1};
+        if (apm.getPolicy() == AccelerationPolicyManager::kAutoTune)
+        {
+            m_decision.result = autoTune(interpreter, apm, model);
+        }
+        else if (apm.getMaxMemoryMB() > 0)
+        {
+            m_decision.result = selectDelegateWithinBudget(interpreter, apm, model);
+        }
+        else
+        {
+            m_decision.result = selectDelegateByPolicy(interpreter, apm);
+        }
+
+        // a failed selection may succeed next time, e.g. after a driver update, so it is not replayed
+        if (!key.empty() && m_decision.result)
+        {
+            cache.store(key, m_decision);
+            cache.save();
+        }
+        return m_decision.result;
+    }
+
+    bool AutoDelegateSelector::selectDelegateByPolicy(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm)
+    {
+        if (apm.getPolicy() == AccelerationPolicyManager::kAutoTune)
+        {
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "AUTO_TUNE policy needs the model to build trial interpreters. "
+                                               "CPU Only policy is used instead.");
+            AccelerationPolicyManager cpuApm = apm;
+            cpuApm.setPolicy(AccelerationPolicyManager::kCPUOnly);
+            return selectDelegateByPolicy(interpreter, cpuApm);
+        }
+
+        if (apm.getCPUFallbackPercentage() != 0)
+        {
+            if (apm.getPolicy() != AccelerationPolicyManager::kEnableLoadBalancing &&
+                apm.getPolicy() != AccelerationPolicyManager::kPytorchModelGPU)
+            {
+                PmLogInfo(s_pmlogCtx, "ADS", 0, "current policy does not use load balancing but a non-zero value"
+                                                "is set to cpu fallback percentage. So, the value set for cpu fallback percentage is ignored.");
+            }
+        }
+
+        Backend customOpBackend = kBackendCPU;
+        std::string customOpPlugin;
+        if (!findCustomOpBackend(interpreter, apm, customOpBackend, customOpPlugin))
+        {
+            return false;
+        }
+        if (customOpBackend != kBackendCPU && !applyBackend(interpreter, customOpBackend, apm))
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting %s delegate", backendToString(customOpBackend));
+            return false;
+        }
+        if (!customOpPlugin.empty() && !applyPlugin(interpreter, customOpPlugin, apm))
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting %s plugin delegate", customOpPlugin.c_str());
+            return false;
+        }
+
+        // A plugin that serves the policy comes before the built-in accelerators. If it fails,
+        // the built-in ones are tried as if it was not installed.
+        const std::string &pluginDir = apm.getDelegatePlugins().dir;
+        DelegateRegistry::Manifest policyPlugin;
+        if (!pluginDir.empty() && DelegateRegistry::getInstance().findByPolicy(pluginDir, apm.getPolicy(), policyPlugin) &&
+            applyPlugin(interpreter, policyPlugin.name, apm))
+        {
+            return true;
+        }
+
+        bool useGPU = (apm.getPolicy() != AccelerationPolicyManager::kCPUOnly);
+#ifdef USE_NNAPI
+        if (apm.getPolicy() == AccelerationPolicyManager::kMinRes) {
+            if (isDelegationProfitable(interpreter, kBackendNNAPI, apm))
+                return applyBackend(interpreter, kBackendNNAPI, apm);
+            // minimum resource does not trade NNAPI for GPU, only for CPU
+            useGPU = false;
+        }
+        else if(apm.getPolicy() == AccelerationPolicyManager::kMinLatencyMinRes) {
+            if (isDelegationProfitable(interpreter, kBackendNNAPI, apm) && !applyBackend(interpreter, kBackendNNAPI, apm)) {
+                PmLogError(s_pmlogCtx, "ADS", 0, "Fail to get Policy while using NNAPI");
+                return false;
+            }
+        }
+#endif
+#ifdef USE_GPU
+        if (useGPU && isDelegationProfitable(interpreter, kBackendGPU, apm))
+            return applyBackend(interpreter, kBackendGPU, apm);
+#endif
+#ifdef USE_XNNPACK
+        // CPU is the remaining target here, so run what is left of the graph on XNNPACK
+        // instead of the built-in kernels.
+        return applyBackend(interpreter, kBackendXNNPack, apm);
+#endif
+        return true;
+    }
+
+    bool AutoDelegateSelector::selectDelegateWithinBudget(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model)
+    {
+        size_t budget = static_cast<size_t>(apm.getMaxMemoryMB()) * 1024 * 1024;
+
+        Backend customOpBackend = kBackendCPU;
+        std::string customOpPlugin;
+        if (!findCustomOpBackend(interpreter, apm, customOpBackend, customOpPlugin))
+        {
+            return false;
+        }
+
+        // What the policy picks comes first, then the CPU configurations from the fastest to
+        // the one that needs the least memory. XNNPACK packs its own copy of the weights.
+        std::vector<std::vector<std::string>> cheaperBackends;
+#ifdef USE_XNNPACK
+        cheaperBackends.push_back({backendToString(kBackendXNNPack)});
+#endif
+        cheaperBackends.push_back({});
+        if (!customOpPlugin.empty())
+        {
+            for (auto &backends : cheaperBackends)
+                backends.insert(backends.begin(), pluginToString(customOpPlugin));
+        }
+        if (customOpBackend != kBackendCPU)
+        {
+            for (auto &backends : cheaperBackends)
+                backends.insert(backends.begin(), backendToString(customOpBackend));
+        }
+
+        std::vector<std::function<bool(AutoDelegateSelector &, tflite::Interpreter &)>> candidates;
+        candidates.push_back([&apm](AutoDelegateSelector &trialAds, tflite::Interpreter &trial) {
+            return trialAds.selectDelegateByPolicy(trial, apm);
+        });
+        for (const auto &backends : cheaperBackends)
+        {
+            DelegateDecisionCache::Decision cheaper = {backends, {}, -1, true};
+            candidates.push_back([&apm, cheaper](AutoDelegateSelector &trialAds, tflite::Interpreter &trial) {
+                return trialAds.replayDecision(trial, apm, cheaper);
+            });
+        }
+
+        bool found = false;
+        bool fits = false;
+        size_t chosenIndex = 0;
+        size_t chosenCost = 0;
+        DelegateDecisionCache::Decision chosen;
+        std::vector<std::vector<std::string>> measured;
+        for (size_t i = 0; i < candidates.size() && !fits; i++)
+        {
+            DelegateDecisionCache::Decision decision;
+            MemoryUsage::Footprint footprint;
+            if (!measureFootprint(model, candidates[i], decision, footprint))
+            {
+                PmLogWarning(s_pmlogCtx, "ADS", 0, "memory budget: candidate %zu could not run the model", i);
+                continue;
+            }
+            if (std::find(measured.begin(), measured.end(), decision.backends) != measured.end())
+            {
+                continue;
+            }
+            measured.push_back(decision.backends);
+
+            size_t cost = MemoryUsage::getCost(footprint);
+            PmLogInfo(s_pmlogCtx, "ADS", 0, "memory budget: candidate %zu with %zu backends needs %zu KB (arena %zu KB, RSS %+ld KB)",
+                      i, decision.backends.size(), cost / 1024, footprint.tensors.arena_bytes / 1024, footprint.rss_delta_bytes / 1024);
+
+            fits = (cost <= budget);
+            if (!found || fits || cost < chosenCost)
+            {
+                found = true;
+                chosen = decision;
+                chosenIndex = i;
+                chosenCost = cost;
+                m_footprint = footprint;
+            }
+        }
+
+        if (!found)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "memory budget: no configuration could run the model");
+            return false;
+        }
+        if (!fits)
+        {
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "memory budget: no configuration fits in %d MB. The smallest one (%zu KB) is used",
+                         apm.getMaxMemoryMB(), chosenCost / 1024);
+        }
+        if (chosenIndex != 0 && m_stats != nullptr)
+        {
+            // the policy's own choice did not fit or did not run
+            m_stats->recordFallback();
+        }
+
+        return replayDecision(interpreter, apm, chosen);
+    }
+
+    bool AutoDelegateSelector::measureFootprint(const tflite::FlatBufferModel &model, const std::function<bool(AutoDelegateSelector &, tflite::Interpreter &)> &delegate,
+                                                DelegateDecisionCache::Decision &decision, MemoryUsage::Footprint &footprint)
+    {
+        std::unique_ptr<tflite::Interpreter> trial;
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        if (tflite::InterpreterBuilder(model, resolver)(&trial) != kTfLiteOk || trial == nullptr)
+        {
+            return false;
+        }
+
+        AutoDelegateSelector trialAds;
+        trialAds.m_decision.gpuVendorIMG = m_decision.gpuVendorIMG;
+
+        long before = MemoryUsage::getResidentBytes();
+        if (!delegate(trialAds, *trial) || trial->AllocateTensors() != kTfLiteOk)
+        {
+            return false;
+        }
+        long after = MemoryUsage::getResidentBytes();
+
+        footprint.tensors = MemoryUsage::getTensorMemory(*trial);
+        footprint.rss_delta_bytes = (before < 0 || after < 0) ? -1 : after - before;
+
+        decision = trialAds.m_decision;
+        decision.result = true;
+        m_decision.gpuVendorIMG = trialAds.m_decision.gpuVendorIMG;
+        return true;
+    }
+
+    const MemoryUsage::Footprint& AutoDelegateSelector::getLastFootprint()
+    {
+        return m_footprint;
+    }
+
+    const DelegateDecisionCache::Decision& AutoDelegateSelector::getLastDecision()
+    {
+        return m_decision;
+    }
+
+    bool AutoDelegateSelector::applyDecision(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const DelegateDecisionCache::Decision &decision)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int originalNodeNum = interpreter.primary_subgraph().execution_plan().size();
+        attachProfiler(interpreter, apm);
+
+        bool result = replayDecision(interpreter, apm, decision) && decision.result;
+
+        applyThreadPolicy(interpreter, apm, originalNodeNum);
+        recordStats(interpreter, originalNodeNum, start);
+        return result;
+    }
+
+    std::future<bool> AutoDelegateSelector::selectDelegateAsync(std::shared_ptr<tflite::Interpreter> interpreter, AccelerationPolicyManager apm,
+                                                                std::shared_ptr<const tflite::FlatBufferModel> model)
+    {
+        if (interpreter == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "interpreter is null");
+            std::promise<bool> failed;
+            failed.set_value(false);
+            return failed.get_future();
+        }
+
+        return std::async(std::launch::async, [interpreter, apm, model]() mutable {
+            AutoDelegateSelector ads;
+            if (model != nullptr)
+            {
+                return ads.selectDelegate(*interpreter, apm, *model);
+            }
+            return ads.selectDelegate(*interpreter, apm);
+        });
+    }
+
+    const char* AutoDelegateSelector::backendToString(AutoDelegateSelector::Backend backend)
+    {
+        switch (backend)
+        {
+        case kBackendCPU:
+            return "CPU";
+        case kBackendXNNPack:
+            return "XNNPACK";
+        case kBackendGPU:
+            return "GPU";
+        case kBackendNNAPI:
+            return "NNAPI";
+        case kBackendNPU:
+            return "NPU";
+        case kBackendEdgeTPU:
+            return "EDGETPU";
+        default:
+            return "UNKNOWN";
+        }
+    }
+
+    bool AutoDelegateSelector::stringToBackend(const std::string &backendStr, AutoDelegateSelector::Backend &backend)
+    {
+        for (auto candidate : {kBackendCPU, kBackendXNNPack, kBackendGPU, kBackendNNAPI, kBackendNPU, kBackendEdgeTPU})
+        {
+            if (backendStr.compare(backendToString(candidate)) == 0)
+            {
+                backend = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool AutoDelegateSelector::resolveModelTokens(AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model)
+    {
+        AccelerationPolicyManager::Caching gpuCache = apm.getCache();
+        const auto &nnapiCache = apm.getNnapiCache();
+        bool gpuAuto = gpuCache.useCache && gpuCache.model_token == kAutoModelToken;
+        bool nnapiAuto = !nnapiCache.cache_dir.empty() && nnapiCache.model_token == kAutoModelToken;
+        if (!gpuAuto && !nnapiAuto)
+        {
+            return true;
+        }
+
+        const tflite::Allocation *allocation = model.allocation();
+        if (allocation == nullptr || allocation->base() == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "model buffer is not available to derive model_token");
+            return false;
+        }
+
+        // The model is read once, and each backend only hashes its own options on top of it.
+        auto start = std::chrono::steady_clock::now();
+        Hash64 content;
+        content.update(allocation->base(), allocation->bytes());
+
+        if (gpuAuto)
+        {
+            Hash64 hash = content;
+            hash.update(getModelTokenOptions(kBackendGPU, apm));
+            gpuCache.model_token = hashToString(hash.digest());
+            apm.setCache(gpuCache);
+        }
+        if (nnapiAuto)
+        {
+            Hash64 hash = content;
+            hash.update(getModelTokenOptions(kBackendNNAPI, apm));
+            apm.setNnapiCache(nnapiCache.cache_dir, hashToString(hash.digest()), nnapiCache.disallow_nnapi_cpu,
+                              nnapiCache.max_number_delegated_partitions, nnapiCache.accelerator_name);
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        PmLogInfo(s_pmlogCtx, "ADS", 0, "model_token derived from %zu bytes in %lld us", allocation->bytes(),
+                  static_cast<long long>(elapsed));
+        return true;
+    }
+
+    std::string AutoDelegateSelector::deriveModelToken(const tflite::FlatBufferModel &model, AutoDelegateSelector::Backend backend,
+                                                       AccelerationPolicyManager &apm)
+    {
+        const tflite::Allocation *allocation = model.allocation();
+        if (allocation == nullptr || allocation->base() == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "model buffer is not available to derive model_token");
+            return "";
+        }
+
+        Hash64 hash;
+        hash.update(allocation->base(), allocation->bytes());
+        hash.update(getModelTokenOptions(backend, apm));
+        return hashToString(hash.digest());
+    }
+
+    bool AutoDelegateSelector::findCustomOpBackend(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm,
+                                                   AutoDelegateSelector::Backend &backend, std::string &plugin)
+    {
+        backend = kBackendCPU;
+        plugin.clear();
+        const std::string &pluginDir = apm.getDelegatePlugins().dir;
+        tflite::Subgraph &subgraph = interpreter.primary_subgraph();
+
+        auto plan = subgraph.execution_plan();
+        auto nodes = subgraph.nodes_and_registration();
+        for (int i = 0; i < plan.size(); i++)
+        {
+            int idx = plan[i];
+            if (idx < 0 || idx >= nodes.size())
+            {
+                PmLogError(s_pmlogCtx, "ADS", 0, "Execution plan index error");
+                return false;
+            }
+            const auto &registration = nodes[idx].second;
+
+            if (registration.custom_name != nullptr)
+            {
+#ifdef USE_NPU
+                // check if the model is NPU compiled
+                if (strcmp(registration.custom_name, "lgnpu_custom_op") == 0)
+                {
+                    backend = kBackendNPU;
+                    return true;
+                }
+#endif
+#ifdef USE_EDGETPU
+                if (strcmp(registration.custom_name, "edgetpu-custom-op") == 0)
+                {
+                    backend = kBackendEdgeTPU;
+                    return true;
+                }
+#endif
+                DelegateRegistry::Manifest manifest;
+                if (!pluginDir.empty() && DelegateRegistry::getInstance().findByCustomOp(pluginDir, registration.custom_name, manifest))
+                {
+                    plugin = manifest.name;
+                    return true;
+                }
+            }
+        }
+        return true;
+    }
+
+    std::vector<AutoDelegateSelector::Backend> AutoDelegateSelector::getAvailableBackends()
+    {
+        std::vector<Backend> backends = {kBackendCPU};
+#ifdef USE_XNNPACK
+        backends.push_back(kBackendXNNPack);
+#endif
+#ifdef USE_GPU
+        backends.push_back(kBackendGPU);
+#endif
+#ifdef USE_NNAPI
+        backends.push_back(kBackendNNAPI);
+#endif
+        return backends;
+    }
+
+    bool AutoDelegateSelector::setBackendDelegate(tflite::Interpreter &interpreter, AutoDelegateSelector::Backend backend, AccelerationPolicyManager &apm)
+    {
+        // AUTO_TUNE itself says nothing about delegate options, so each candidate uses
+        // the policy that is meant for it.
+        bool isAutoTune = (apm.getPolicy() == AccelerationPolicyManager::kAutoTune);
+
+        switch (backend)
+        {
+        case kBackendCPU:
+            return true;
+#ifdef USE_XNNPACK
+        case kBackendXNNPack:
+            return setXNNPackDelegate(interpreter, apm);
+#endif
+#ifdef USE_GPU
+        case kBackendGPU:
+            if (isAutoTune)
+            {
+                AccelerationPolicyManager gpuApm = apm;
+                gpuApm.setPolicy(AccelerationPolicyManager::kMinimumLatency);
+                return setTfLiteGPUDelegate(interpreter, gpuApm);
+            }
+            return setTfLiteGPUDelegate(interpreter, apm);
+#endif
+#ifdef USE_NNAPI
+        case kBackendNNAPI:
+            if (isAutoTune)
+            {
+                AccelerationPolicyManager nnapiApm = apm;
+                nnapiApm.setPolicy(AccelerationPolicyManager::kMinRes);
+                return setNNAPIDelegate(interpreter, nnapiApm);
+            }
+            return setNNAPIDelegate(interpreter, apm);
+#endif
+#ifdef USE_NPU
+        case kBackendNPU:
+            return setWebOSNPUDelegate(interpreter);
+#endif
+#ifdef USE_EDGETPU
+        case kBackendEdgeTPU:
+            return setEdgeTPUDelegate(interpreter);
+#endif
+        default:
+            PmLogError(s_pmlogCtx, "ADS", 0, "%s backend is not supported in this build", backendToString(backend));
+            return false;
+        }
+    }
+
+    bool AutoDelegateSelector::applyBackend(tflite::Interpreter &interpreter, AutoDelegateSelector::Backend backend, AccelerationPolicyManager &apm)
+    {
+        if (!setBackendDelegate(interpreter, backend, apm))
+        {
+            m_decision.failedBackends.push_back(backendToString(backend));
+            if (m_stats != nullptr)
+            {
+                m_stats->recordFallback();
+            }
+            return false;
+        }
+        m_decision.backends.push_back(backendToString(backend));
+        return true;
+    }
+
+    bool AutoDelegateSelector::setPluginDelegate(tflite::Interpreter &interpreter, const std::string &plugin, AccelerationPolicyManager &apm)
+    {
+        const auto &plugins = apm.getDelegatePlugins();
+        DelegateRegistry::Manifest manifest;
+        if (plugins.dir.empty() || !DelegateRegistry::getInstance().find(plugins.dir, plugin, manifest))
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "%s plugin is not installed in %s", plugin.c_str(), plugins.dir.c_str());
+            return false;
+        }
+
+        auto option = plugins.options.find(plugin);
+        auto delegate = DelegateRegistry::getInstance().createDelegate(manifest, option != plugins.options.end() ? option->second : "{}");
+        if (delegate == nullptr)
+        {
+            return false;
+        }
+        if (interpreter.ModifyGraphWithDelegate(std::move(delegate)) != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting %s plugin delegate", plugin.c_str());
+            return false;
+        }
+        PmLogInfo(s_pmlogCtx, "ADS", 0, "%s plugin delegate is set", plugin.c_str());
+        return true;
+    }
+
+    bool AutoDelegateSelector::applyPlugin(tflite::Interpreter &interpreter, const std::string &plugin, AccelerationPolicyManager &apm)
+    {
+        if (!setPluginDelegate(interpreter, plugin, apm))
+        {
+            m_decision.failedBackends.push_back(pluginToString(plugin));
+            if (m_stats != nullptr)
+            {
+                m_stats->recordFallback();
+            }
+            return false;
+        }
+        m_decision.backends.push_back(pluginToString(plugin));
+        return true;
+    }
+
+    bool AutoDelegateSelector::isDelegationProfitable(tflite::Interpreter &interpreter, AutoDelegateSelector::Backend backend, AccelerationPolicyManager &apm)
+    {
+        PartitionAnalyzer::Target target;
+        switch (backend)
+        {
+        case kBackendGPU:
+            target = PartitionAnalyzer::kTargetGPU;
+            break;
+        case kBackendNNAPI:
+            target = PartitionAnalyzer::kTargetNNAPI;
+            break;
+        default:
+            // XNNPACK runs on the same cores as the built-in kernels, and NPU/EdgeTPU models
+            // are compiled into a single custom op, so there is nothing to predict for them.
+            return true;
+        }
+
+        int maxPartitions = getMaxDelegatedPartitions(backend, apm);
+        auto prediction = PartitionAnalyzer::predict(interpreter.primary_subgraph(), target, maxPartitions);
+        PmLogInfo(s_pmlogCtx, "ADS", 0, "%s: %d partitions predicted, %d delegated with %d of %d nodes (%.1f%%)",
+                  backendToString(backend), prediction.partition_num, prediction.delegated_partition_num,
+                  prediction.delegated_node_num, prediction.node_num, prediction.delegated_node_ratio * 100.0);
+
+        double minRatio = apm.getPartitionLimits().min_delegated_node_ratio;
+        if (prediction.delegated_node_ratio < minRatio)
+        {
+            PmLogInfo(s_pmlogCtx, "ADS", 0, "%s delegate is skipped because %.1f%% of the nodes is under the limit %.1f%%",
+                      backendToString(backend), prediction.delegated_node_ratio * 100.0, minRatio * 100.0);
+            if (m_stats != nullptr)
+            {
+                m_stats->recordFallback();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    int AutoDelegateSelector::getMaxDelegatedPartitions(AutoDelegateSelector::Backend backend, AccelerationPolicyManager &apm)
+    {
+        int maxPartitions = apm.getPartitionLimits().max_delegated_partitions;
+        switch (backend)
+        {
+#ifdef USE_GPU
+        case kBackendGPU:
+            return maxPartitions > 0 ? maxPartitions : TfLiteGpuDelegateOptionsV2Default().max_delegated_partitions;
+#endif
+#ifdef USE_NNAPI
+        case kBackendNNAPI:
+            // the value from the nnapi options is more specific than the common limit
+            if (apm.getNnapiCache().max_number_delegated_partitions != 0)
+                return apm.getNnapiCache().max_number_delegated_partitions;
+            return maxPartitions > 0 ? maxPartitions : tflite::StatefulNnApiDelegate::Options().max_number_delegated_partitions;
+#endif
+        default:
+            return maxPartitions;
+        }
+    }
+
+    bool AutoDelegateSelector::replayDecision(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const DelegateDecisionCache::Decision &decision)
+    {
+        m_decision = {{}, {}, decision.gpuVendorIMG, decision.result};
+
+        // everything is checked before the first delegate is applied, so a decision from another
+        // build or plugin set leaves the interpreter as it was
+        std::vector<Backend> available = getAvailableBackends();
+        for (const auto &backendStr : decision.backends)
+        {
+            Backend backend;
+            std::string plugin;
+            DelegateRegistry::Manifest manifest;
+            if (stringToPlugin(backendStr, plugin))
+            {
+                const auto &plugins = apm.getDelegatePlugins();
+                if (plugins.dir.empty() || !DelegateRegistry::getInstance().find(plugins.dir, plugin, manifest))
+                {
+                    PmLogWarning(s_pmlogCtx, "ADS", 0, "%s plugin of the stored decision is not installed", plugin.c_str());
+                    return false;
+                }
+            }
+            else if (!stringToBackend(backendStr, backend) ||
+                     std::find(available.begin(), available.end(), backend) == available.end())
+            {
+                PmLogWarning(s_pmlogCtx, "ADS", 0, "%s backend of the stored decision is not available", backendStr.c_str());
+                return false;
+            }
+        }
+
+        for (const auto &backendStr : decision.backends)
+        {
+            Backend backend;
+            std::string plugin;
+            if (stringToPlugin(backendStr, plugin))
+            {
+                if (!applyPlugin(interpreter, plugin, apm))
+                {
+                    return false;
+                }
+            }
+            else if (!stringToBackend(backendStr, backend) || !applyBackend(interpreter, backend, apm))
+            {
+                return false;
+            }
+        }
+
+        m_decision.failedBackends = decision.failedBackends;
+        for (const auto &backendStr : decision.failedBackends)
+        {
+            PmLogInfo(s_pmlogCtx, "ADS", 0, "%s backend is skipped because it failed before on this device", backendStr.c_str());
+        }
+        return true;
     }
 
-    bool AutoDelegateSelector::selectDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm)
+    bool AutoDelegateSelector::autoTune(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model)
     {
-        if (apm.getCPUFallbackPercentage() != 0)
+        Backend bestBackend = kBackendCPU;
+        double bestLatency = -1.0;
+        size_t budget = static_cast<size_t>(apm.getMaxMemoryMB()) * 1024 * 1024;
+        // used only if no backend fits in the memory budget
+        bool hasSmallest = false;
+        Backend smallestBackend = kBackendCPU;
+        size_t smallestCost = 0;
+        MemoryUsage::Footprint smallestFootprint = {{0, 0, 0, 0}, -1};
+
+        for (auto backend : getAvailableBackends())
         {
-            if (apm.getPolicy() != AccelerationPolicyManager::kEnableLoadBalancing &&
-                apm.getPolicy() != AccelerationPolicyManager::kPytorchModelGPU)
+            if (!isDelegationProfitable(interpreter, backend, apm))
             {
-                PmLogInfo(s_pmlogCtx, "ADS", 0, "current policy does not use load balancing but a non-zero value"
-                                                "is set to cpu fallback percentage. So, the value set for cpu fallback percentage is ignored.");
+                continue;
+            }
+
+            MemoryUsage::Footprint footprint = {{0, 0, 0, 0}, -1};
+            double latency = measureBackendLatency(model, backend, apm, footprint);
+            if (latency < 0.0)
+            {
+                PmLogWarning(s_pmlogCtx, "ADS", 0, "AUTO_TUNE: %s backend could not run the model", backendToString(backend));
+                m_decision.failedBackends.push_back(backendToString(backend));
+                continue;
+            }
+
+            size_t cost = MemoryUsage::getCost(footprint);
+            PmLogInfo(s_pmlogCtx, "ADS", 0, "AUTO_TUNE: %s backend median latency %.3f ms, %zu KB", backendToString(backend), latency, cost / 1024);
+            if (!hasSmallest || cost < smallestCost)
+            {
+                hasSmallest = true;
+                smallestBackend = backend;
+                smallestCost = cost;
+                smallestFootprint = footprint;
+            }
+            if (budget > 0 && cost > budget)
+            {
+                PmLogInfo(s_pmlogCtx, "ADS", 0, "AUTO_TUNE: %s backend exceeds the memory budget of %d MB", backendToString(backend), apm.getMaxMemoryMB());
+                continue;
+            }
+
+            if (bestLatency < 0.0 || latency < bestLatency)
+            {
+                bestBackend = backend;
+                bestLatency = latency;
+                m_footprint = footprint;
             }
         }
 
-        tflite::Subgraph &subgraph = interpreter.primary_subgraph();
+        if (bestLatency < 0.0 && hasSmallest)
+        {
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "AUTO_TUNE: no backend fits in %d MB. The smallest one is used", apm.getMaxMemoryMB());
+            bestBackend = smallestBackend;
+            m_footprint = smallestFootprint;
+            if (m_stats != nullptr)
+            {
+                m_stats->recordFallback();
+            }
+        }
+        else if (bestLatency < 0.0)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "AUTO_TUNE: no backend could run the model");
+            return false;
+        }
 
-        auto plan = subgraph.execution_plan();
-        auto nodes = subgraph.nodes_and_registration();
-        for (int i = 0; i < plan.size(); i++)
+        PmLogInfo(s_pmlogCtx, "ADS", 0, "AUTO_TUNE: %s backend is selected", backendToString(bestBackend));
+        Backend customOpBackend = kBackendCPU;
+        std::string customOpPlugin;
+        if (!findCustomOpBackend(interpreter, apm, customOpBackend, customOpPlugin))
         {
-            int idx = plan[i];
-            if (idx < 0 || idx >= nodes.size())
+            return false;
+        }
+        if (customOpBackend != kBackendCPU && !applyBackend(interpreter, customOpBackend, apm))
+        {
+            return false;
+        }
+        if (!customOpPlugin.empty() && !applyPlugin(interpreter, customOpPlugin, apm))
+        {
+            return false;
+        }
+        return applyBackend(interpreter, bestBackend, apm);
+    }
+
+    double AutoDelegateSelector::measureBackendLatency(const tflite::FlatBufferModel &model, AutoDelegateSelector::Backend backend, AccelerationPolicyManager &apm,
+                                                       MemoryUsage::Footprint &footprint)
+    {
+        // The trial interpreter is built the way callers usually build theirs, so the CPU
+        // candidate also includes whatever default delegate TFLite applies on its own.
+        std::unique_ptr<tflite::Interpreter> trial;
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        if (tflite::InterpreterBuilder(model, resolver)(&trial) != kTfLiteOk || trial == nullptr)
+        {
+            return -1.0;
+        }
+
+        long before = MemoryUsage::getResidentBytes();
+        Backend customOpBackend = kBackendCPU;
+        std::string customOpPlugin;
+        if (!findCustomOpBackend(*trial, apm, customOpBackend, customOpPlugin) ||
+            (customOpBackend != kBackendCPU && !setBackendDelegate(*trial, customOpBackend, apm)) ||
+            (!customOpPlugin.empty() && !setPluginDelegate(*trial, customOpPlugin, apm)) ||
+            !setBackendDelegate(*trial, backend, apm))
+        {
+            return -1.0;
+        }
+
+        if (trial->AllocateTensors() != kTfLiteOk)
+        {
+            return -1.0;
+        }
+        long after = MemoryUsage::getResidentBytes();
+        footprint.tensors = MemoryUsage::getTensorMemory(*trial);
+        footprint.rss_delta_bytes = (before < 0 || after < 0) ? -1 : after - before;
+        fillRandomInputs(*trial);
+
+        const auto &tuning = apm.getAutoTuning();
+        for (int i = 0; i < tuning.warmup_runs; i++)
+        {
+            if (trial->Invoke() != kTfLiteOk)
             {
-                PmLogError(s_pmlogCtx, "ADS", 0, "Execution plan index error");
-                return false;
+                return -1.0;
             }
-            const auto &registration = nodes[idx].second;
+        }
 
-            if (registration.custom_name != nullptr)
+        std::vector<double> latencies;
+        latencies.reserve(tuning.runs);
+        for (int i = 0; i < tuning.runs; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (trial->Invoke() != kTfLiteOk)
             {
-#ifdef USE_NPU
-                // check if the model is NPU compiled
-                if (strcmp(registration.custom_name, "lgnpu_custom_op") == 0)
-                {
-                    if (setWebOSNPUDelegate(interpreter) == true)
-                    {
-                        break;
-                    }
-                    else
-                    {
-                        PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting webOSNPU delegate");
-                        return false;
-                    }
-                }
-#endif
-#ifdef USE_EDGETPU
-                if (strcmp(registration.custom_name, "edgetpu-custom-op") == 0)
-                {
-                    if (setEdgeTPUDelegate(interpreter) == true)
-                    {
-                        break;
-                    }
-                    else
-                    {
-                        PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting EdgeTPU delegate");
-                        return false;
-                    }
-                }
+                return -1.0;
+            }
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        auto median = latencies.begin() + latencies.size() / 2;
+        std::nth_element(latencies.begin(), median, latencies.end());
+        return *median;
+    }
+
+    int AutoDelegateSelector::getThreadNum(AccelerationPolicyManager &apm, bool isCPUBound)
+    {
+        const auto &threadPolicy = apm.getThreadPolicy();
+        if (threadPolicy.num_threads != 0)
+        {
+            return threadPolicy.num_threads;
+        }
+
+        DeviceCapabilities &capabilities = DeviceCapabilities::getInstance();
+        switch (threadPolicy.cluster)
+        {
+        case AccelerationPolicyManager::kClusterAll:
+            return capabilities.getCpuCoreNum();
+        case AccelerationPolicyManager::kClusterBig:
+            return capabilities.getBigCoreNum();
+        case AccelerationPolicyManager::kClusterLittle:
+            return capabilities.getLittleCoreNum();
+        case AccelerationPolicyManager::kClusterAuto:
+        default:
+            // CPU threads only compete with the accelerator driver when there is little left to run on CPU.
+            return isCPUBound ? capabilities.getBigCoreNum() : 1;
+        }
+    }
+
+    int AutoDelegateSelector::getMaxCPUThreadNum(AccelerationPolicyManager &apm)
+    {
+        int numThreads = std::max(getThreadNum(apm, true), 1);
+#ifdef USE_XNNPACK
+        // setXNNPackDelegate() falls back to getThreadNum() without num_threads of its own
+        numThreads = std::max(numThreads, apm.getXnnpackOptions().num_threads);
 #endif
+        return numThreads;
+    }
+
+    void AutoDelegateSelector::applyThreadPolicy(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, int originalNodeNum)
+    {
+        if (apm.getThreadPolicy().num_threads < 0)
+        {
+            return;
+        }
+
+        const tflite::Subgraph &subgraph = interpreter.primary_subgraph();
+        const auto &plan = subgraph.execution_plan();
+        const auto &nodes = subgraph.nodes_and_registration();
+        int cpuNodeNum = 0;
+        for (int idx : plan)
+        {
+            if (nodes[idx].second.builtin_code != tflite::BuiltinOperator_DELEGATE)
+            {
+                cpuNodeNum++;
             }
         }
-#ifdef USE_NNAPI
-        if (apm.getPolicy() == AccelerationPolicyManager::kMinRes) {
-            return setNNAPIDelegate(interpreter, apm);
+
+        bool isCPUBound = !isAcceleratorApplied() || originalNodeNum <= 0 ||
+                          static_cast<double>(cpuNodeNum) / originalNodeNum > kAcceleratedCPUNodeRatio;
+        int numThreads = getThreadNum(apm, isCPUBound);
+        if (numThreads <= 0)
+        {
+            return;
         }
-        else if(apm.getPolicy() == AccelerationPolicyManager::kMinLatencyMinRes) {
-            if (!setNNAPIDelegate(interpreter, apm)) {
-                PmLogError(s_pmlogCtx, "ADS", 0, "Fail to get Policy while using NNAPI");
-                return false;
+
+        if (interpreter.SetNumThreads(numThreads) != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "Failed to set the number of threads to %d", numThreads);
+            return;
+        }
+        PmLogInfo(s_pmlogCtx, "ADS", 0, "Number of threads: %d (%d of %d nodes on CPU)", numThreads, cpuNodeNum, originalNodeNum);
+    }
+
+    bool AutoDelegateSelector::isAcceleratorApplied()
+    {
+        for (const auto &backend : m_decision.backends)
+        {
+            if (backend != backendToString(kBackendXNNPack) && backend != backendToString(kBackendCPU))
+            {
+                return true;
             }
         }
-#endif
-#ifdef USE_GPU
-        if (apm.getPolicy() != AccelerationPolicyManager::kCPUOnly)
-            return setTfLiteGPUDelegate(interpreter, apm);
-#endif
-        return true;
+        return false;
+    }
+
+    void AutoDelegateSelector::recordStats(tflite::Interpreter &interpreter, int originalNodeNum, std::chrono::steady_clock::time_point start)
+    {
+        if (m_stats == nullptr)
+        {
+            return;
+        }
+
+        DelegationStats::Delegation delegation = {0, 0, 0, originalNodeNum, 0, 0, 0, isAcceleratorApplied(), m_decision.result};
+        delegation.delegation_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        Backend backend;
+        for (const auto &backendStr : m_decision.backends)
+        {
+            if (stringToBackend(backendStr, backend))
+                delegation.backend_mask |= (1u << backend);
+        }
+        for (const auto &backendStr : m_decision.failedBackends)
+        {
+            if (stringToBackend(backendStr, backend))
+                delegation.failed_backend_mask |= (1u << backend);
+        }
+
+        // partitions are counted the way GraphTester::getTotalPartitionNum() does
+        const tflite::Subgraph &subgraph = interpreter.primary_subgraph();
+        const auto &nodes = subgraph.nodes_and_registration();
+        bool isPrevDelegated = false;
+        bool isFirst = true;
+        for (int idx : subgraph.execution_plan())
+        {
+            bool isDelegated = (nodes[idx].second.builtin_code == tflite::BuiltinOperator_DELEGATE);
+            if (isDelegated)
+            {
+                delegation.partition_num++;
+                delegation.delegated_partition_num++;
+            }
+            else
+            {
+                delegation.cpu_node_num++;
+                if (isFirst || isPrevDelegated)
+                    delegation.partition_num++;
+            }
+            isPrevDelegated = isDelegated;
+            isFirst = false;
+        }
+
+        m_stats->recordDelegation(delegation);
+    }
+
+    void AutoDelegateSelector::setStats(std::shared_ptr<DelegationStats> stats)
+    {
+        m_stats = std::move(stats);
     }
 
+    void AutoDelegateSelector::attachProfiler(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm)
+    {
+        const auto &profiling = apm.getProfiling();
+        if (!profiling.enabled)
+        {
+            return;
+        }
+        if (interpreter.GetProfiler() != nullptr)
+        {
+            PmLogInfo(s_pmlogCtx, "ADS", 0, "interpreter already has a profiler. OpProfiler is not attached");
+            return;
+        }
+
+        interpreter.SetProfiler(std::unique_ptr<tflite::Profiler>(new OpProfiler(interpreter, profiling.report_path)));
+    }
 
 #ifdef USE_GPU
     bool AutoDelegateSelector::setTfLiteGPUDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm)
     {
         bool isIMG = false;
 #ifdef GPU_DELEGATE_ONLY_CL
-        isIMG = isCLDeviceVendorIMG();
+        if (m_decision.gpuVendorIMG < 0)
+        {
+            m_decision.gpuVendorIMG = DeviceCapabilities::getInstance().isGpuVendorIMG() ? 1 : 0;
+        }
+        isIMG = (m_decision.gpuVendorIMG == 1);
 #endif
         auto policy = apm.getPolicy();
         TfLiteGpuDelegateOptionsV2 gpu_opts = TfLiteGpuDelegateOptionsV2Default();
@@ -142,12 +1239,30 @@ namespace aif
             gpu_opts.inference_priority3 = TfLiteGpuInferencePriority::TFLITE_GPU_INFERENCE_PRIORITY_AUTO;
         }
 
+        gpu_opts.max_delegated_partitions = getMaxDelegatedPartitions(kBackendGPU, apm);
+
         const auto &cache = apm.getCache();
-        if (cache.useCache)
+        const auto &management = apm.getCacheManagement();
+        CacheManager cacheManager(cache.serialization_dir, static_cast<long long>(management.max_mb) * 1024 * 1024);
+        bool staged = false;
+        if (cache.useCache && cache.model_token == kAutoModelToken)
+        {
+            PmLogWarning(s_pmlogCtx, "ADS", 0, "model_token auto needs the model, serialization is disabled");
+        }
+        else if (cache.useCache)
         {
             gpu_opts.experimental_flags |= TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION;
             gpu_opts.serialization_dir = cache.serialization_dir.c_str();
             gpu_opts.model_token = cache.model_token.c_str();
+            if (management.enabled && cacheManager.open())
+            {
+                const char *stagingDir = cacheManager.stage(cache.model_token);
+                if (stagingDir != nullptr)
+                {
+                    gpu_opts.serialization_dir = stagingDir;
+                    staged = true;
+                }
+            }
         }
 
 #ifdef GPU_DELEGATE_ONLY_GL
@@ -156,80 +1271,23 @@ namespace aif
         gpu_opts.experimental_flags |= TFLITE_GPU_EXPERIMENTAL_FLAGS_CL_ONLY;
 #endif
 
-        auto deleter = [](TfLiteDelegate* delegate) {
-                TfLiteGpuDelegateV2Delete(delegate);
-        };
-
-        TfLiteDelegate* raw_delegate = TfLiteGpuDelegateV2Create(&gpu_opts);
-        std::unique_ptr<TfLiteDelegate, decltype(deleter)> delegate(raw_delegate, deleter);
-        if (interpreter.ModifyGraphWithDelegate(std::move(delegate)) != kTfLiteOk)
+        // the GPU delegate builds the inference context of the one graph it is applied to
+        auto delegate = DelegateCache::getInstance().acquire(
+            backendToString(kBackendGPU), false,
+            [&gpu_opts]() { return TfLiteGpuDelegateV2Create(&gpu_opts); }, TfLiteGpuDelegateV2Delete);
+        if (delegate == nullptr || interpreter.ModifyGraphWithDelegate(std::move(delegate)) != kTfLiteOk)
         {
             PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting TfLiteGPU delegate");
             return false;
         }
-
-        return true;
-    }
-
-#ifdef GPU_DELEGATE_ONLY_CL
-    bool AutoDelegateSelector::isCLDeviceVendorIMG()
-    {
-        cl_uint platformCount;
-        if (clGetPlatformIDs(0, nullptr, &platformCount) != CL_SUCCESS)
-        {
-            PmLogError(s_pmlogCtx, "ADS", 0, "Error: clGetPlatformIDs failed.");
-            return false;
-        }
-
-        std::vector<cl_platform_id> platforms(platformCount);
-        if (clGetPlatformIDs(platformCount, platforms.data(), nullptr) != CL_SUCCESS)
-        {
-            PmLogError(s_pmlogCtx, "ADS", 0, "Error: clGetPlatformIDs failed.");
-            return false;
-        }
-
-        if (platformCount == 0)
-        {
-            PmLogWarning(s_pmlogCtx, "ADS", 0, "Warning: Expected exactly one OpenCL platform, but found no platform.");
-            return false;
-        }
-        else if (platformCount != 1)
-        {
-
-            PmLogWarning(s_pmlogCtx, "ADS", 0, "Warning: Expected exactly one OpenCL platform, but found %d platforms.", platformCount);
-        }
-
-        cl_uint deviceCount;
-        clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_ALL, 0, nullptr, &deviceCount);
-
-        std::vector<cl_device_id> devices(deviceCount);
-        clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_ALL, deviceCount, devices.data(), nullptr);
-
-        if (deviceCount == 0)
-        {
-            PmLogWarning(s_pmlogCtx, "ADS", 0, "Warning: Expected exactly one OpenCL device, but found no device.");
-            return false;
-        }
-        else if (deviceCount != 1)
-        {
-
-            PmLogWarning(s_pmlogCtx, "ADS", 0, "Warning: Expected exactly one OpenCL device, but found %d devices.", deviceCount);
-        }
-
-        char buffer[256];
-        if (clGetDeviceInfo(devices[0], CL_DEVICE_VENDOR, sizeof(buffer), buffer, nullptr) != CL_SUCCESS)
+        if (staged)
         {
-            PmLogError(s_pmlogCtx, "ADS", 0, "Error: clGetDeviceInfo failed.");
-            return false;
+            publishCache(interpreter, cacheManager, cache.model_token);
         }
-        PmLogInfo(s_pmlogCtx, "ADS", 0, "CL Device Vendor: %s", buffer);
 
-        const std::string img_vendor_name = "Imagination Technologies";
-
-        return std::string(buffer) == img_vendor_name ? true : false;
+        return true;
     }
 #endif
-#endif
 
 #ifdef USE_NPU
     bool AutoDelegateSelector::setWebOSNPUDelegate(tflite::Interpreter &interpreter)
@@ -253,12 +1311,28 @@ namespace aif
         auto policy = apm.getPolicy();
         tflite::StatefulNnApiDelegate::Options nnapi_opts = tflite::StatefulNnApiDelegate::Options();
         const auto& cache = apm.getNnapiCache();
+        const auto &management = apm.getCacheManagement();
+        CacheManager cacheManager(cache.cache_dir, static_cast<long long>(management.max_mb) * 1024 * 1024);
+        bool staged = false;
 
         if(policy == AccelerationPolicyManager::kMinRes || policy == AccelerationPolicyManager::kMinLatencyMinRes) {
-            if (cache.cache_dir != "" && cache.model_token != "")
+            if (cache.model_token == kAutoModelToken)
+            {
+                PmLogWarning(s_pmlogCtx, "ADS", 0, "model_token auto needs the model, caching is disabled");
+            }
+            else if (cache.cache_dir != "" && cache.model_token != "")
             {
                 nnapi_opts.cache_dir   = cache.cache_dir.c_str();
                 nnapi_opts.model_token = cache.model_token.c_str();
+                if (management.enabled && cacheManager.open())
+                {
+                    const char *stagingDir = cacheManager.stage(cache.model_token);
+                    if (stagingDir != nullptr)
+                    {
+                        nnapi_opts.cache_dir = stagingDir;
+                        staged = true;
+                    }
+                }
             }
             else{
                 PmLogError(s_pmlogCtx, "ADS", 0, "cache_dir or model_token is invalid");
@@ -285,16 +1359,77 @@ namespace aif
                 PmLogError(s_pmlogCtx, "ADS", 0, "accelerator_name is invalid");
             }
         }
+        nnapi_opts.max_number_delegated_partitions = getMaxDelegatedPartitions(kBackendNNAPI, apm);
 
-        auto deleter = [](TfLiteDelegate* delegate) { delete delegate; };
-
-        TfLiteDelegate* nnapi_delegate = new tflite::StatefulNnApiDelegate(nnapi_opts);
-        std::unique_ptr<TfLiteDelegate, decltype(deleter)> delegatePtr(nnapi_delegate, deleter);
-        if (interpreter.ModifyGraphWithDelegate(std::move(delegatePtr)) != kTfLiteOk)
+        // StatefulNnApiDelegate keeps the NNAPI model compiled for the graph it is applied to
+        auto delegatePtr = DelegateCache::getInstance().acquire(
+            backendToString(kBackendNNAPI), false,
+            [&nnapi_opts]() -> TfLiteDelegate * { return new tflite::StatefulNnApiDelegate(nnapi_opts); },
+            [](TfLiteDelegate *delegate) { delete static_cast<tflite::StatefulNnApiDelegate *>(delegate); });
+        if (delegatePtr == nullptr || interpreter.ModifyGraphWithDelegate(std::move(delegatePtr)) != kTfLiteOk)
         {
             PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting TfLite NNAPI delegate");
             return false;
         }
+        if (staged)
+        {
+            publishCache(interpreter, cacheManager, cache.model_token);
+        }
+        return true;
+    }
+#endif
+
+#ifdef USE_XNNPACK
+    TfLiteXNNPackDelegateOptions makeXnnpackDelegateOptions(AccelerationPolicyManager &apm, int defaultNumThreads)
+    {
+        const auto &options = apm.getXnnpackOptions();
+        TfLiteXNNPackDelegateOptions xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
+
+        int numThreads = options.num_threads > 0 ? options.num_threads : defaultNumThreads;
+        if (numThreads > 0)
+        {
+            xnnpack_opts.num_threads = numThreads;
+        }
+        if (options.enable_qs8)
+        {
+            xnnpack_opts.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_QS8;
+        }
+        if (options.enable_qu8)
+        {
+            xnnpack_opts.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_QU8;
+        }
+        if (options.force_fp16)
+        {
+            if (apm.getPolicy() == AccelerationPolicyManager::kMaximumPrecision)
+            {
+                PmLogInfo(s_pmlogCtx, "ADS", 0, "force_fp16 is ignored because current policy is Maximum Precision");
+            }
+            else
+            {
+                xnnpack_opts.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16;
+            }
+        }
+        return xnnpack_opts;
+    }
+
+    bool AutoDelegateSelector::setXNNPackDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm)
+    {
+        TfLiteXNNPackDelegateOptions xnnpack_opts = makeXnnpackDelegateOptions(apm, getThreadNum(apm, true));
+
+        auto deleter = [](TfLiteDelegate* delegate) {
+                TfLiteXNNPackDelegateDelete(delegate);
+        };
+
+        TfLiteDelegate* raw_delegate = TfLiteXNNPackDelegateCreate(&xnnpack_opts);
+        std::unique_ptr<TfLiteDelegate, decltype(deleter)> delegate(raw_delegate, deleter);
+        if (interpreter.ModifyGraphWithDelegate(std::move(delegate)) != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting XNNPACK delegate");
+            return false;
+        }
+
+        PmLogInfo(s_pmlogCtx, "ADS", 0, "XNNPACK delegate is set (num_threads: %d, flags: 0x%x)",
+                  xnnpack_opts.num_threads, xnnpack_opts.flags);
         return true;
     }
 #endif
@@ -302,10 +1437,16 @@ namespace aif
 #ifdef USE_EDGETPU
     bool AutoDelegateSelector::setEdgeTPUDelegate(tflite::Interpreter &interpreter)
     {
-        auto delegate_options = TfLiteExternalDelegateOptionsDefault(EDGETPU_LIB_PATH.c_str());
-
-        auto external_delegate = TfLiteExternalDelegateCreate(&delegate_options);
-        if (interpreter.ModifyGraphWithDelegate(external_delegate) != kTfLiteOk)
+        // One EdgeTPU delegate holds the opened device and serves every interpreter, so the
+        // library is loaded and the device is opened once, for the first interpreter.
+        auto delegate = DelegateCache::getInstance().acquire(
+            std::string(backendToString(kBackendEdgeTPU)) + ";" + EDGETPU_LIB_PATH, true,
+            [this]() {
+                auto delegate_options = TfLiteExternalDelegateOptionsDefault(EDGETPU_LIB_PATH.c_str());
+                return TfLiteExternalDelegateCreate(&delegate_options);
+            },
+            TfLiteExternalDelegateDelete);
+        if (delegate == nullptr || interpreter.ModifyGraphWithDelegate(std::move(delegate)) != kTfLiteOk)
         {
             PmLogError(s_pmlogCtx, "ADS", 0, "Something went wrong while setting TPU delegate");
             return false;
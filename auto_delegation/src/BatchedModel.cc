@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "BatchedModel.h"
+#include "AutoDelegateSelector.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    // a model_token AutoDelegateSelector still has to derive from the model
+    const char *kAutoModelToken = "auto";
+
+    bool hasBatchDimension(const TfLiteTensor *tensor)
+    {
+        return tensor != nullptr && tensor->dims != nullptr && tensor->dims->size > 0 && tensor->dims->data[0] == 1;
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    BatchedModel::BatchedModel(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm)
+        : m_model(std::move(model))
+        , m_apm(std::move(apm))
+        , m_stats(std::make_shared<DelegationStats>())
+        , m_stopping(false)
+        , m_requestCount(0)
+    {
+    }
+
+    BatchedModel::~BatchedModel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_arrived.notify_all();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        for (Request *request : m_requests)
+        {
+            request->done.set_value(false);
+        }
+        m_requests.clear();
+    }
+
+    bool BatchedModel::init()
+    {
+        if (!m_interpreters.empty())
+        {
+            return true;
+        }
+        if (m_model == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "model is null");
+            return false;
+        }
+
+        // Tokens are derived from the model once, and the buckets get suffixes of their own.
+        // A token left "auto" gets no suffix, so the selector disables its cache.
+        if (!AutoDelegateSelector::resolveModelTokens(m_apm, *m_model))
+        {
+            PmLogWarning(s_pmlogCtx, "BM", 0, "model_token auto could not be derived, delegate caches are disabled");
+        }
+
+        std::vector<int> buckets = makeBuckets(m_apm.getBatching().max_batch_size);
+        std::vector<std::unique_ptr<tflite::Interpreter>> interpreters;
+        for (int batchSize : buckets)
+        {
+            std::unique_ptr<tflite::Interpreter> interpreter = buildInterpreter(batchSize);
+            if (interpreter == nullptr)
+            {
+                return false;
+            }
+
+            if (batchSize == 1)
+            {
+                m_inputBytes.clear();
+                m_outputBytes.clear();
+                for (int index : interpreter->inputs())
+                {
+                    if (!hasBatchDimension(interpreter->tensor(index)))
+                    {
+                        PmLogError(s_pmlogCtx, "BM", 0, "input %d has no batch dimension of 1", index);
+                        return false;
+                    }
+                    m_inputBytes.push_back(interpreter->tensor(index)->bytes);
+                }
+                for (int index : interpreter->outputs())
+                {
+                    if (!hasBatchDimension(interpreter->tensor(index)))
+                    {
+                        PmLogError(s_pmlogCtx, "BM", 0, "output %d has no batch dimension of 1", index);
+                        return false;
+                    }
+                    m_outputBytes.push_back(interpreter->tensor(index)->bytes);
+                }
+            }
+            else
+            {
+                // a model that does not scale with the batch dimension can not be scattered back
+                for (size_t i = 0; i < m_outputBytes.size(); i++)
+                {
+                    if (interpreter->tensor(interpreter->outputs()[i])->bytes != m_outputBytes[i] * batchSize)
+                    {
+                        PmLogError(s_pmlogCtx, "BM", 0, "output %zu does not grow with the batch size %d", i, batchSize);
+                        return false;
+                    }
+                }
+            }
+            interpreters.push_back(std::move(interpreter));
+        }
+
+        m_buckets = std::move(buckets);
+        m_interpreters = std::move(interpreters);
+        m_thread = std::thread(&BatchedModel::run, this);
+
+        PmLogInfo(s_pmlogCtx, "BM", 0, "batching up to %d requests within %d ms", m_buckets.back(), m_apm.getBatching().window_ms);
+        return true;
+    }
+
+    bool BatchedModel::infer(const Buffers &inputs, Buffers &outputs)
+    {
+        if (m_interpreters.empty())
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "init() has not succeeded");
+            return false;
+        }
+        if (inputs.size() != m_inputBytes.size())
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "%zu inputs are given for %zu input tensors", inputs.size(), m_inputBytes.size());
+            return false;
+        }
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (inputs[i].size() != m_inputBytes[i])
+            {
+                PmLogError(s_pmlogCtx, "BM", 0, "input %zu has %zu bytes instead of %zu", i, inputs[i].size(), m_inputBytes[i]);
+                return false;
+            }
+        }
+
+        Request request;
+        request.inputs = &inputs;
+        request.outputs = &outputs;
+        request.arrival = std::chrono::steady_clock::now();
+        std::future<bool> done = request.done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping)
+            {
+                return false;
+            }
+            m_requests.push_back(&request);
+            m_requestCount++;
+        }
+        m_arrived.notify_one();
+        return done.get();
+    }
+
+    const std::vector<int>& BatchedModel::getBuckets() const
+    {
+        return m_buckets;
+    }
+
+    std::shared_ptr<const DelegationStats> BatchedModel::getStats()
+    {
+        return m_stats;
+    }
+
+    uint64_t BatchedModel::getRequestCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requestCount;
+    }
+
+    std::vector<int> BatchedModel::makeBuckets(int maxBatchSize)
+    {
+        std::vector<int> buckets;
+        for (int size = 1; size < maxBatchSize; size *= 2)
+        {
+            buckets.push_back(size);
+        }
+        buckets.push_back(maxBatchSize > 1 ? maxBatchSize : 1);
+        return buckets;
+    }
+
+    std::unique_ptr<tflite::Interpreter> BatchedModel::buildInterpreter(int batchSize)
+    {
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        if (tflite::InterpreterBuilder(*m_model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "failed to build the interpreter of batch size %d", batchSize);
+            return nullptr;
+        }
+
+        AccelerationPolicyManager apm = m_apm;
+        if (batchSize > 1)
+        {
+            for (int index : interpreter->inputs())
+            {
+                const TfLiteTensor *tensor = interpreter->tensor(index);
+                if (!hasBatchDimension(tensor))
+                {
+                    PmLogError(s_pmlogCtx, "BM", 0, "input %d has no batch dimension of 1", index);
+                    return nullptr;
+                }
+                std::vector<int> dims(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+                dims[0] = batchSize;
+                if (interpreter->ResizeInputTensor(index, dims) != kTfLiteOk)
+                {
+                    PmLogError(s_pmlogCtx, "BM", 0, "failed to resize input %d to batch size %d", index, batchSize);
+                    return nullptr;
+                }
+            }
+
+            // GPU serializations and NNAPI compilations are only valid for the shape they were
+            // made for, and a decision stored for the model is one for batch size 1
+            std::string suffix = "_b" + std::to_string(batchSize);
+            AccelerationPolicyManager::Caching cache = apm.getCache();
+            if (!cache.model_token.empty() && cache.model_token != kAutoModelToken)
+            {
+                cache.model_token += suffix;
+                apm.setCache(cache);
+            }
+            AccelerationPolicyManager::NnapiCaching nnapiCache = apm.getNnapiCache();
+            if (!nnapiCache.model_token.empty() && nnapiCache.model_token != kAutoModelToken)
+            {
+                apm.setNnapiCache(nnapiCache.cache_dir, nnapiCache.model_token + suffix, nnapiCache.disallow_nnapi_cpu,
+                                  nnapiCache.max_number_delegated_partitions, nnapiCache.accelerator_name);
+            }
+            apm.setDecisionCachePath("");
+        }
+
+        // the delegate is selected after the resize, for the shape this interpreter serves
+        AutoDelegateSelector ads;
+        ads.setStats(m_stats);
+        if (!ads.selectDelegate(*interpreter, apm, *m_model))
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "failed to select a delegate for batch size %d", batchSize);
+            return nullptr;
+        }
+#ifdef GPU_DELEGATE_ONLY_GL
+        const auto &backends = ads.getLastDecision().backends;
+        const char *gpu = AutoDelegateSelector::backendToString(AutoDelegateSelector::kBackendGPU);
+        if (std::find(backends.begin(), backends.end(), gpu) != backends.end())
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "the GL delegate only runs on the thread that created it, "
+                                            "so a model delegated to GPU can not be batched");
+            return nullptr;
+        }
+#endif
+
+        if (interpreter->AllocateTensors() != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "BM", 0, "failed to allocate tensors for batch size %d", batchSize);
+            return nullptr;
+        }
+        return interpreter;
+    }
+
+    bool BatchedModel::runBatch(const std::vector<Request *> &requests)
+    {
+        size_t bucket = 0;
+        while (m_buckets[bucket] < static_cast<int>(requests.size()))
+        {
+            bucket++;
+        }
+        tflite::Interpreter &interpreter = *m_interpreters[bucket];
+        int batchSize = m_buckets[bucket];
+        int requestNum = requests.size();
+
+        for (size_t i = 0; i < m_inputBytes.size(); i++)
+        {
+            size_t bytes = m_inputBytes[i];
+            uint8_t *data = reinterpret_cast<uint8_t *>(interpreter.tensor(interpreter.inputs()[i])->data.raw);
+            if (data == nullptr)
+            {
+                return false;
+            }
+            for (int j = 0; j < requestNum; j++)
+            {
+                memcpy(data + j * bytes, (*requests[j]->inputs)[i].data(), bytes);
+            }
+            memset(data + requestNum * bytes, 0, (batchSize - requestNum) * bytes);
+        }
+
+        if (m_stats->invoke(interpreter) != kTfLiteOk)
+        {
+            PmLogWarning(s_pmlogCtx, "BM", 0, "batch of %d requests failed to invoke", requestNum);
+            return false;
+        }
+
+        for (Request *request : requests)
+        {
+            request->outputs->assign(m_outputBytes.size(), std::vector<uint8_t>());
+        }
+        for (size_t i = 0; i < m_outputBytes.size(); i++)
+        {
+            int index = interpreter.outputs()[i];
+            if (interpreter.EnsureTensorDataIsReadable(index) != kTfLiteOk)
+            {
+                return false;
+            }
+            size_t bytes = m_outputBytes[i];
+            const uint8_t *data = reinterpret_cast<const uint8_t *>(interpreter.tensor(index)->data.raw);
+            for (int j = 0; j < requestNum; j++)
+            {
+                (*requests[j]->outputs)[i].assign(data + j * bytes, data + (j + 1) * bytes);
+            }
+        }
+        return true;
+    }
+
+    void BatchedModel::run()
+    {
+        size_t maxBatchSize = m_buckets.back();
+        auto window = std::chrono::milliseconds(m_apm.getBatching().window_ms);
+        while (true)
+        {
+            std::vector<Request *> batch;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_arrived.wait(lock, [this]() { return m_stopping || !m_requests.empty(); });
+                // the window starts with the oldest request, which may have waited for the last batch already
+                m_arrived.wait_until(lock, m_requests.empty() ? std::chrono::steady_clock::now() : m_requests.front()->arrival + window,
+                                     [this, maxBatchSize]() { return m_stopping || m_requests.size() >= maxBatchSize; });
+                if (m_stopping)
+                {
+                    break;
+                }
+                while (!m_requests.empty() && batch.size() < maxBatchSize)
+                {
+                    batch.push_back(m_requests.front());
+                    m_requests.pop_front();
+                }
+            }
+
+            bool result = runBatch(batch);
+            for (Request *request : batch)
+            {
+                request->done.set_value(result);
+            }
+        }
+    }
+} // end of namespace aif
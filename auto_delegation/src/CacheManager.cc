@@ -0,0 +1,595 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "CacheManager.h"
+#include "tools/Hash.h"
+#include "tools/Logger.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    const int kCacheIndexVersion = 1;
+    const char *kIndexName = "index.json";
+    const char *kLockName = ".lock";
+    const char *kStagingPrefix = ".staging.";
+    // writeIndex() writes index.json.tmp.<pid> and renames it
+    const char *kTmpInfix = ".tmp.";
+
+    std::mutex s_mutex;
+    // directories validated by this process
+    std::set<std::string> s_validatedDirs;
+    // Staging paths handed to delegates. Delegates may keep the pointer (the GPU delegate
+    // does), so the strings are never freed. There is one per directory and process.
+    std::set<std::string> s_stagingDirs;
+
+    const char *internStagingDir(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        return s_stagingDirs.insert(path).first->c_str();
+    }
+
+    std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return "";
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    bool hashFile(const std::string &path, long long &bytes, std::string &hash)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        bytes = static_cast<long long>(content.size());
+        hash = aif::hashToString(aif::hash64(content.data(), content.size()));
+        return true;
+    }
+
+    bool statFile(const std::string &path, long long &bytes, long long &mtime)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            return false;
+        }
+        bytes = static_cast<long long>(st.st_size);
+        mtime = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        return true;
+    }
+
+    bool copyFile(const std::string &from, const std::string &to)
+    {
+        std::ifstream in(from, std::ios::binary);
+        std::ofstream out(to, std::ios::binary | std::ios::trunc);
+        if (!in.is_open() || !out.is_open())
+        {
+            return false;
+        }
+        out << in.rdbuf();
+        return out.good();
+    }
+
+    bool isDirectory(const std::string &path)
+    {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+
+    // names of the entries of dir, without "." and ".."
+    std::vector<std::string> listDir(const std::string &dir)
+    {
+        std::vector<std::string> names;
+        DIR *d = opendir(dir.c_str());
+        if (d == nullptr)
+        {
+            return names;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(d)) != nullptr)
+        {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..")
+            {
+                names.push_back(std::move(name));
+            }
+        }
+        closedir(d);
+        return names;
+    }
+
+    void removeAll(const std::string &path)
+    {
+        if (isDirectory(path))
+        {
+            for (const auto &name : listDir(path))
+            {
+                removeAll(path + "/" + name);
+            }
+            rmdir(path.c_str());
+        }
+        else
+        {
+            unlink(path.c_str());
+        }
+    }
+
+    bool makeDir(const std::string &path)
+    {
+        return mkdir(path.c_str(), 0755) == 0 || (errno == EEXIST && isDirectory(path));
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    CacheManager::CacheManager(const std::string &dir, long long maxBytes)
+        : m_dir(dir)
+        , m_maxBytes(maxBytes < 0 ? 0 : maxBytes)
+        , m_lockFd(-1)
+        , m_stagingDir(nullptr)
+    {
+        while (m_dir.size() > 1 && m_dir.back() == '/')
+        {
+            m_dir.pop_back();
+        }
+    }
+
+    CacheManager::~CacheManager()
+    {
+        if (m_stagingDir != nullptr)
+        {
+            removeAll(m_stagingDir);
+        }
+        if (m_lockFd >= 0)
+        {
+            flock(m_lockFd, LOCK_UN);
+            close(m_lockFd);
+        }
+    }
+
+    bool CacheManager::open()
+    {
+        if (m_lockFd >= 0)
+        {
+            return true;
+        }
+        if (m_dir.empty() || !makeDir(m_dir))
+        {
+            PmLogError(s_pmlogCtx, "CM", 0, "cache directory %s is not available", m_dir.c_str());
+            return false;
+        }
+
+        std::string lockPath = m_dir + "/" + kLockName;
+        m_lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (m_lockFd < 0)
+        {
+            PmLogError(s_pmlogCtx, "CM", 0, "failed to open %s (errno %d)", lockPath.c_str(), errno);
+            return false;
+        }
+        // Held until destruction, which covers the whole delegation. Another process preparing
+        // the same cache waits here, and then finds the entry already published.
+        if (flock(m_lockFd, LOCK_EX) != 0)
+        {
+            PmLogError(s_pmlogCtx, "CM", 0, "failed to lock %s (errno %d)", lockPath.c_str(), errno);
+            close(m_lockFd);
+            m_lockFd = -1;
+            return false;
+        }
+
+        readIndex();
+
+        bool validated = false;
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            validated = !s_validatedDirs.insert(m_dir).second;
+        }
+        if (!validated)
+        {
+            validate();
+        }
+        return true;
+    }
+
+    bool CacheManager::readIndex()
+    {
+        m_entries.clear();
+        std::string content = readFile(m_dir + "/" + kIndexName);
+        if (content.empty())
+        {
+            return false;
+        }
+
+        rapidjson::Document d;
+        d.Parse(content.c_str());
+        if (d.HasParseError() || !d.IsObject() || !d.HasMember("version") || !d["version"].IsInt() ||
+            d["version"].GetInt() != kCacheIndexVersion || !d.HasMember("entries") || !d["entries"].IsObject())
+        {
+            PmLogWarning(s_pmlogCtx, "CM", 0, "index of %s is corrupted and will be rebuilt", m_dir.c_str());
+            return false;
+        }
+
+        const auto &entries = d["entries"];
+        for (auto it = entries.MemberBegin(); it != entries.MemberEnd(); ++it)
+        {
+            const auto &value = it->value;
+            if (!value.IsObject() || !value.HasMember("files") || !value["files"].IsArray())
+            {
+                continue;
+            }
+
+            Entry entry = {{}, 0};
+            if (value.HasMember("last_use") && value["last_use"].IsInt64())
+            {
+                entry.last_use = value["last_use"].GetInt64();
+            }
+            for (auto file = value["files"].Begin(); file != value["files"].End(); ++file)
+            {
+                if (!file->IsObject() || !file->HasMember("name") || !(*file)["name"].IsString() ||
+                    !file->HasMember("bytes") || !(*file)["bytes"].IsInt64() ||
+                    !file->HasMember("hash") || !(*file)["hash"].IsString())
+                {
+                    continue;
+                }
+                long long mtime = 0;
+                if (file->HasMember("mtime") && (*file)["mtime"].IsInt64())
+                {
+                    mtime = (*file)["mtime"].GetInt64();
+                }
+                entry.files.push_back({(*file)["name"].GetString(), (*file)["bytes"].GetInt64(), (*file)["hash"].GetString(), mtime});
+            }
+            m_entries[it->name.GetString()] = std::move(entry);
+        }
+        return true;
+    }
+
+    bool CacheManager::writeIndex()
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.Key("version");
+        writer.Int(kCacheIndexVersion);
+        writer.Key("entries");
+        writer.StartObject();
+        for (const auto &entry : m_entries)
+        {
+            writer.Key(entry.first.c_str());
+            writer.StartObject();
+            writer.Key("last_use");
+            writer.Int64(entry.second.last_use);
+            writer.Key("files");
+            writer.StartArray();
+            for (const auto &file : entry.second.files)
+            {
+                writer.StartObject();
+                writer.Key("name");
+                writer.String(file.name.c_str());
+                writer.Key("bytes");
+                writer.Int64(file.bytes);
+                writer.Key("hash");
+                writer.String(file.hash.c_str());
+                writer.Key("mtime");
+                writer.Int64(file.mtime);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndObject();
+        writer.EndObject();
+
+        std::string path = m_dir + "/" + kIndexName;
+        std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream file(tmpPath, std::ios::trunc);
+            if (!file.is_open())
+            {
+                PmLogError(s_pmlogCtx, "CM", 0, "failed to open %s", tmpPath.c_str());
+                return false;
+            }
+            file << buffer.GetString();
+            if (!file.good())
+            {
+                file.close();
+                std::remove(tmpPath.c_str());
+                PmLogError(s_pmlogCtx, "CM", 0, "failed to write %s", tmpPath.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            PmLogError(s_pmlogCtx, "CM", 0, "failed to publish %s", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void CacheManager::validate()
+    {
+        // Drop entries with a missing, truncated or modified file. A file that still has the size
+        // and modification time it was published with is trusted without reading it.
+        std::set<std::string> knownFiles;
+        std::set<std::string> droppedFiles;
+        int droppedNum = 0;
+        int hashedNum = 0;
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            bool valid = !it->second.files.empty();
+            for (auto &file : it->second.files)
+            {
+                std::string path = m_dir + "/" + file.name;
+                long long bytes = 0;
+                long long mtime = 0;
+                if (file.name.find('/') != std::string::npos || !statFile(path, bytes, mtime) || bytes != file.bytes)
+                {
+                    valid = false;
+                    break;
+                }
+                if (mtime == file.mtime)
+                {
+                    continue;
+                }
+
+                std::string hash;
+                hashedNum++;
+                if (!hashFile(path, bytes, hash) || bytes != file.bytes || hash != file.hash)
+                {
+                    valid = false;
+                    break;
+                }
+                file.mtime = mtime;
+            }
+
+            if (valid)
+            {
+                for (const auto &file : it->second.files)
+                {
+                    knownFiles.insert(file.name);
+                }
+                ++it;
+            }
+            else
+            {
+                PmLogWarning(s_pmlogCtx, "CM", 0, "cache of %s in %s is corrupted", it->first.c_str(), m_dir.c_str());
+                for (const auto &file : it->second.files)
+                {
+                    if (file.name.find('/') == std::string::npos)
+                    {
+                        droppedFiles.insert(file.name);
+                    }
+                }
+                droppedNum++;
+                it = m_entries.erase(it);
+            }
+        }
+
+        // The files of dropped entries, and what interrupted writes of this class left over.
+        // The lock is held, so no staging directory is in use. Anything else in the directory
+        // belongs to someone else and is left alone.
+        int removedNum = 0;
+        for (const auto &name : listDir(m_dir))
+        {
+            bool leftover = name.compare(0, strlen(kStagingPrefix), kStagingPrefix) == 0 ||
+                            (name.compare(0, strlen(kIndexName), kIndexName) == 0 && name.find(kTmpInfix) != std::string::npos);
+            bool dropped = droppedFiles.count(name) > 0 && knownFiles.count(name) == 0;
+            if (leftover || dropped)
+            {
+                removeAll(m_dir + "/" + name);
+                removedNum++;
+            }
+        }
+
+        if (droppedNum > 0 || removedNum > 0)
+        {
+            PmLogInfo(s_pmlogCtx, "CM", 0, "%s: dropped %d entries and removed %d files", m_dir.c_str(), droppedNum, removedNum);
+        }
+        PmLogDebug(s_pmlogCtx, "%s: %d files were hashed to validate %d entries", m_dir.c_str(), hashedNum, getEntryNum());
+        evict("");
+        writeIndex();
+    }
+
+    const char *CacheManager::stage(const std::string &token)
+    {
+        if (m_lockFd < 0 || token.empty())
+        {
+            return nullptr;
+        }
+
+        std::string stagingDir = m_dir + "/" + kStagingPrefix + std::to_string(getpid());
+        removeAll(stagingDir);
+        if (!makeDir(stagingDir))
+        {
+            PmLogError(s_pmlogCtx, "CM", 0, "failed to create %s", stagingDir.c_str());
+            return nullptr;
+        }
+        m_stagingDir = internStagingDir(stagingDir);
+        m_stagedToken = token;
+
+        auto it = m_entries.find(token);
+        if (it != m_entries.end())
+        {
+            for (const auto &file : it->second.files)
+            {
+                if (!copyFile(m_dir + "/" + file.name, stagingDir + "/" + file.name))
+                {
+                    PmLogWarning(s_pmlogCtx, "CM", 0, "failed to stage %s", file.name.c_str());
+                }
+            }
+        }
+        return m_stagingDir;
+    }
+
+    bool CacheManager::publish(const std::string &token)
+    {
+        if (m_stagingDir == nullptr || token != m_stagedToken)
+        {
+            PmLogError(s_pmlogCtx, "CM", 0, "%s is not staged", token.c_str());
+            return false;
+        }
+
+        std::map<std::string, File> published;
+        auto it = m_entries.find(token);
+        if (it != m_entries.end())
+        {
+            for (const auto &file : it->second.files)
+            {
+                published[file.name] = file;
+            }
+        }
+
+        std::string stagingDir = m_stagingDir;
+        Entry entry = {{}, static_cast<long long>(time(nullptr))};
+        int changedNum = 0;
+        for (const auto &name : listDir(stagingDir))
+        {
+            std::string path = stagingDir + "/" + name;
+            File file = {name, 0, "", 0};
+            if (isDirectory(path) || !hashFile(path, file.bytes, file.hash))
+            {
+                continue;
+            }
+
+            auto old = published.find(name);
+            if (old == published.end() || old->second.bytes != file.bytes || old->second.hash != file.hash)
+            {
+                // rename() replaces the old file in one step, so readers see either version whole
+                if (std::rename(path.c_str(), (m_dir + "/" + name).c_str()) != 0)
+                {
+                    PmLogError(s_pmlogCtx, "CM", 0, "failed to publish %s (errno %d)", name.c_str(), errno);
+                    continue;
+                }
+                long long bytes = 0;
+                statFile(m_dir + "/" + name, bytes, file.mtime);
+                changedNum++;
+            }
+            else
+            {
+                file.mtime = old->second.mtime;
+            }
+            entry.files.push_back(std::move(file));
+        }
+
+        if (entry.files.empty())
+        {
+            // the delegate did not use the cache, e.g. it was not applied
+            return true;
+        }
+
+        // files the delegate dropped are no longer part of the entry
+        for (const auto &old : published)
+        {
+            bool kept = false;
+            for (const auto &file : entry.files)
+            {
+                kept = kept || file.name == old.first;
+            }
+            if (!kept)
+            {
+                unlink((m_dir + "/" + old.first).c_str());
+            }
+        }
+
+        m_entries[token] = std::move(entry);
+        if (changedNum > 0)
+        {
+            PmLogInfo(s_pmlogCtx, "CM", 0, "published %d files of %s to %s", changedNum, token.c_str(), m_dir.c_str());
+        }
+        evict(token);
+        return writeIndex();
+    }
+
+    void CacheManager::evict(const std::string &keep)
+    {
+        if (m_maxBytes <= 0)
+        {
+            return;
+        }
+
+        while (getTotalBytes() > m_maxBytes)
+        {
+            auto oldest = m_entries.end();
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+            {
+                if (it->first != keep && (oldest == m_entries.end() || it->second.last_use < oldest->second.last_use))
+                {
+                    oldest = it;
+                }
+            }
+            if (oldest == m_entries.end())
+            {
+                PmLogWarning(s_pmlogCtx, "CM", 0, "%s alone exceeds the cap of %s", keep.c_str(), m_dir.c_str());
+                return;
+            }
+            PmLogInfo(s_pmlogCtx, "CM", 0, "evicting %s from %s", oldest->first.c_str(), m_dir.c_str());
+            removeEntry(oldest->first);
+        }
+    }
+
+    void CacheManager::removeEntry(const std::string &token)
+    {
+        auto it = m_entries.find(token);
+        if (it == m_entries.end())
+        {
+            return;
+        }
+        for (const auto &file : it->second.files)
+        {
+            unlink((m_dir + "/" + file.name).c_str());
+        }
+        m_entries.erase(it);
+    }
+
+    bool CacheManager::hasEntry(const std::string &token) const
+    {
+        return m_entries.find(token) != m_entries.end();
+    }
+
+    int CacheManager::getEntryNum() const
+    {
+        return static_cast<int>(m_entries.size());
+    }
+
+    long long CacheManager::getTotalBytes() const
+    {
+        long long totalBytes = 0;
+        for (const auto &entry : m_entries)
+        {
+            for (const auto &file : entry.second.files)
+            {
+                totalBytes += file.bytes;
+            }
+        }
+        return totalBytes;
+    }
+} // end of namespace aif
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegateCache.h"
+#include "tools/Logger.h"
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+} // end of anonymous namespace
+
+namespace aif
+{
+    DelegateCache& DelegateCache::getInstance()
+    {
+        static DelegateCache s_cache;
+        return s_cache;
+    }
+
+    tflite::Interpreter::TfLiteDelegatePtr DelegateCache::acquire(const std::string &key, bool shareable,
+                                                                  const std::function<TfLiteDelegate *()> &create,
+                                                                  void (*destroy)(TfLiteDelegate *))
+    {
+        tflite::Interpreter::TfLiteDelegatePtr none(nullptr, [](TfLiteDelegate *) {});
+
+        if (!shareable)
+        {
+            TfLiteDelegate *delegate = create();
+            if (delegate == nullptr)
+            {
+                return none;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_counters.created++;
+            m_counters.unshared++;
+            if (m_reportedKeys.insert(key).second)
+            {
+                PmLogInfo(s_pmlogCtx, "DC", 0, "%s delegate can not be shared between interpreters, each one creates its own",
+                          key.c_str());
+            }
+            return tflite::Interpreter::TfLiteDelegatePtr(delegate, destroy);
+        }
+
+        // Held while creating, so that two interpreters asking at once do not both initialize
+        // the device. Creation is rare, and a shared delegate is created once per key.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_entries.find(key);
+        if (found != m_entries.end())
+        {
+            found->second.refs++;
+            m_counters.reused++;
+            PmLogDebug(s_pmlogCtx, "%s delegate is shared by %d interpreters", key.c_str(), found->second.refs);
+            return tflite::Interpreter::TfLiteDelegatePtr(found->second.delegate, release);
+        }
+
+        TfLiteDelegate *delegate = create();
+        if (delegate == nullptr)
+        {
+            return none;
+        }
+        m_entries[key] = {delegate, destroy, 1};
+        m_keys[delegate] = key;
+        m_counters.created++;
+        PmLogInfo(s_pmlogCtx, "DC", 0, "%s delegate is created to be shared", key.c_str());
+        return tflite::Interpreter::TfLiteDelegatePtr(delegate, release);
+    }
+
+    void DelegateCache::release(TfLiteDelegate *delegate)
+    {
+        DelegateCache &cache = getInstance();
+        void (*destroy)(TfLiteDelegate *) = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(cache.m_mutex);
+            auto key = cache.m_keys.find(delegate);
+            if (key == cache.m_keys.end())
+            {
+                PmLogError(s_pmlogCtx, "DC", 0, "released delegate is not in the cache");
+                return;
+            }
+            Entry &entry = cache.m_entries[key->second];
+            if (--entry.refs > 0)
+            {
+                return;
+            }
+            destroy = entry.destroy;
+            PmLogInfo(s_pmlogCtx, "DC", 0, "%s delegate is destroyed with its last interpreter", key->second.c_str());
+            cache.m_entries.erase(key->second);
+            cache.m_keys.erase(key);
+        }
+        // outside the lock, the backend may take a while to close the device
+        destroy(delegate);
+    }
+
+    int DelegateCache::getRefCount(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_entries.find(key);
+        return found != m_entries.end() ? found->second.refs : 0;
+    }
+
+    DelegateCache::Counters DelegateCache::getCounters()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_counters;
+    }
+} // end of namespace aif
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegateDecisionCache.h"
+#include "DeviceCapabilities.h"
+#include "tools/Hash.h"
+#include "tools/Logger.h"
+
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include <unistd.h>
+
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    const int kDecisionCacheVersion = 1;
+
+    // save() of every DelegateDecisionCache of this process, they share the temporary file
+    std::mutex s_saveMutex;
+
+    std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            return "";
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    void readStringArray(const rapidjson::Value &value, std::vector<std::string> &out)
+    {
+        if (!value.IsArray())
+        {
+            return;
+        }
+        for (auto it = value.Begin(); it != value.End(); ++it)
+        {
+            if (it->IsString())
+            {
+                out.push_back(it->GetString());
+            }
+        }
+    }
+
+    void writeStringArray(rapidjson::Writer<rapidjson::StringBuffer> &writer, const std::vector<std::string> &values)
+    {
+        writer.StartArray();
+        for (const auto &value : values)
+        {
+            writer.String(value.c_str());
+        }
+        writer.EndArray();
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    DelegateDecisionCache::DelegateDecisionCache(const std::string &path)
+        : m_path(path)
+    {
+    }
+
+    DelegateDecisionCache::~DelegateDecisionCache()
+    {
+    }
+
+    std::string DelegateDecisionCache::makeKey(const tflite::FlatBufferModel &model, AccelerationPolicyManager &apm)
+    {
+        const tflite::Allocation *allocation = model.allocation();
+        if (allocation == nullptr || allocation->base() == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "DDC", 0, "model buffer is not available");
+            return "";
+        }
+
+        std::string key = hashToString(hash64(allocation->base(), allocation->bytes()));
+        key += "-" + getDeviceFingerprint();
+        key += "-" + std::to_string(apm.getPolicy());
+        key += "-" + std::to_string(apm.getCPUFallbackPercentage());
+        // options that change the outcome are only added when set, so existing keys stay valid
+        const auto &limits = apm.getPartitionLimits();
+        if (limits.max_delegated_partitions > 0 || limits.min_delegated_node_ratio > 0.0)
+        {
+            key += "-p" + std::to_string(limits.max_delegated_partitions) + ":" + std::to_string(limits.min_delegated_node_ratio);
+        }
+        if (apm.getMaxMemoryMB() > 0)
+        {
+            key += "-m" + std::to_string(apm.getMaxMemoryMB());
+        }
+        return key;
+    }
+
+    std::string DelegateDecisionCache::getDeviceFingerprint()
+    {
+        return DeviceCapabilities::getInstance().getFingerprint();
+    }
+
+    bool DelegateDecisionCache::load()
+    {
+        m_decisions.clear();
+        m_changedKeys.clear();
+        return read(m_decisions);
+    }
+
+    bool DelegateDecisionCache::read(std::map<std::string, Decision> &decisions)
+    {
+        std::string content = readFile(m_path);
+        if (content.empty())
+        {
+            return false;
+        }
+
+        rapidjson::Document d;
+        d.Parse(content.c_str());
+        if (d.HasParseError() || !d.IsObject())
+        {
+            PmLogWarning(s_pmlogCtx, "DDC", 0, "%s is corrupted and will be rewritten", m_path.c_str());
+            return false;
+        }
+
+        if (!d.HasMember("version") || !d["version"].IsInt() || d["version"].GetInt() != kDecisionCacheVersion ||
+            !d.HasMember("decisions") || !d["decisions"].IsObject())
+        {
+            PmLogWarning(s_pmlogCtx, "DDC", 0, "%s has an unknown format and will be rewritten", m_path.c_str());
+            return false;
+        }
+
+        const auto &entries = d["decisions"];
+        for (auto it = entries.MemberBegin(); it != entries.MemberEnd(); ++it)
+        {
+            const auto &entry = it->value;
+            if (!entry.IsObject() || !entry.HasMember("result") || !entry["result"].IsBool())
+            {
+                continue;
+            }
+
+            Decision decision = {{}, {}, -1, entry["result"].GetBool()};
+            if (entry.HasMember("backends"))
+            {
+                readStringArray(entry["backends"], decision.backends);
+            }
+            if (entry.HasMember("failed_backends"))
+            {
+                readStringArray(entry["failed_backends"], decision.failedBackends);
+            }
+            if (entry.HasMember("gpu_vendor_img") && entry["gpu_vendor_img"].IsInt())
+            {
+                decision.gpuVendorIMG = entry["gpu_vendor_img"].GetInt();
+            }
+            decisions[it->name.GetString()] = std::move(decision);
+        }
+        return true;
+    }
+
+    bool DelegateDecisionCache::save()
+    {
+        if (m_changedKeys.empty())
+        {
+            return true;
+        }
+
+        // Other processes may have stored their own decisions since load(), so only
+        // the keys changed here are merged into the current file.
+        std::lock_guard<std::mutex> lock(s_saveMutex);
+        std::map<std::string, Decision> decisions;
+        read(decisions);
+        for (const auto &key : m_changedKeys)
+        {
+            auto it = m_decisions.find(key);
+            if (it == m_decisions.end())
+            {
+                decisions.erase(key);
+            }
+            else
+            {
+                decisions[key] = it->second;
+            }
+        }
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.Key("version");
+        writer.Int(kDecisionCacheVersion);
+        writer.Key("decisions");
+        writer.StartObject();
+        for (const auto &entry : decisions)
+        {
+            writer.Key(entry.first.c_str());
+            writer.StartObject();
+            writer.Key("backends");
+            writeStringArray(writer, entry.second.backends);
+            writer.Key("failed_backends");
+            writeStringArray(writer, entry.second.failedBackends);
+            writer.Key("gpu_vendor_img");
+            writer.Int(entry.second.gpuVendorIMG);
+            writer.Key("result");
+            writer.Bool(entry.second.result);
+            writer.EndObject();
+        }
+        writer.EndObject();
+        writer.EndObject();
+
+        // Write to a temporary file first so that a reader never sees a torn file.
+        std::string tmpPath = m_path + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream file(tmpPath, std::ios::trunc);
+            if (!file.is_open())
+            {
+                PmLogError(s_pmlogCtx, "DDC", 0, "failed to open %s", tmpPath.c_str());
+                return false;
+            }
+            file << buffer.GetString();
+            if (!file.good())
+            {
+                file.close();
+                std::remove(tmpPath.c_str());
+                PmLogError(s_pmlogCtx, "DDC", 0, "failed to write %s", tmpPath.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tmpPath.c_str(), m_path.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            PmLogError(s_pmlogCtx, "DDC", 0, "failed to publish %s", m_path.c_str());
+            return false;
+        }
+
+        m_changedKeys.clear();
+        return true;
+    }
+
+    bool DelegateDecisionCache::lookup(const std::string &key, Decision &decision)
+    {
+        auto it = m_decisions.find(key);
+        if (it == m_decisions.end())
+        {
+            return false;
+        }
+        decision = it->second;
+        return true;
+    }
+
+    void DelegateDecisionCache::store(const std::string &key, Decision decision)
+    {
+        m_decisions[key] = std::move(decision);
+        m_changedKeys.insert(key);
+    }
+
+    void DelegateDecisionCache::erase(const std::string &key)
+    {
+        m_decisions.erase(key);
+        m_changedKeys.insert(key);
+    }
+} // end of namespace aif
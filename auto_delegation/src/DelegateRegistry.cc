@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegateRegistry.h"
+#include "DelegateCache.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <dlfcn.h>
+
+#include "rapidjson/document.h"
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    const std::string kManifestSuffix = ".json";
+
+    // names of the manifests in dir, sorted so that the first one found does not depend on readdir()
+    bool listManifests(const std::string &dir, std::vector<std::string> &names)
+    {
+        DIR *d = opendir(dir.c_str());
+        if (d == nullptr)
+        {
+            return false;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(d)) != nullptr)
+        {
+            std::string name = entry->d_name;
+            if (name.size() > kManifestSuffix.size() &&
+                name.compare(name.size() - kManifestSuffix.size(), kManifestSuffix.size(), kManifestSuffix) == 0)
+            {
+                names.push_back(std::move(name));
+            }
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        return true;
+    }
+
+    bool readStrings(const rapidjson::Value &object, const char *key, std::vector<std::string> &strings)
+    {
+        if (!object.HasMember(key))
+        {
+            return true;
+        }
+        if (!object[key].IsArray())
+        {
+            return false;
+        }
+        for (auto it = object[key].Begin(); it != object[key].End(); ++it)
+        {
+            if (!it->IsString())
+            {
+                return false;
+            }
+            strings.push_back(it->GetString());
+        }
+        return true;
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    DelegateRegistry& DelegateRegistry::getInstance()
+    {
+        static DelegateRegistry s_registry;
+        return s_registry;
+    }
+
+    bool DelegateRegistry::scan(const std::string &dir)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return scanLocked(dir) != nullptr;
+    }
+
+    const std::vector<DelegateRegistry::Manifest>* DelegateRegistry::scanLocked(const std::string &dir)
+    {
+        auto scanned = m_manifests.find(dir);
+        if (scanned != m_manifests.end())
+        {
+            return &scanned->second;
+        }
+
+        std::vector<std::string> names;
+        if (!listManifests(dir, names))
+        {
+            PmLogDebug(s_pmlogCtx, "plugin directory %s is not available", dir.c_str());
+            return nullptr;
+        }
+
+        std::vector<Manifest> &manifests = m_manifests[dir];
+        for (const auto &name : names)
+        {
+            std::ifstream file(dir + "/" + name);
+            std::stringstream ss;
+            ss << file.rdbuf();
+
+            Manifest manifest;
+            if (!parseManifest(ss.str(), dir, manifest))
+            {
+                PmLogWarning(s_pmlogCtx, "DR", 0, "%s/%s is not a valid delegate plugin manifest", dir.c_str(), name.c_str());
+                continue;
+            }
+            auto registered = std::find_if(manifests.begin(), manifests.end(),
+                                           [&manifest](const Manifest &m) { return m.name == manifest.name; });
+            if (registered != manifests.end())
+            {
+                PmLogWarning(s_pmlogCtx, "DR", 0, "plugin %s of %s/%s is already registered from %s", manifest.name.c_str(),
+                             dir.c_str(), name.c_str(), registered->library.c_str());
+                continue;
+            }
+
+            PmLogInfo(s_pmlogCtx, "DR", 0, "plugin %s registered from %s (%zu custom ops, %zu policies)", manifest.name.c_str(),
+                      dir.c_str(), manifest.customOps.size(), manifest.policies.size());
+            manifests.push_back(std::move(manifest));
+        }
+        return &manifests;
+    }
+
+    bool DelegateRegistry::parseManifest(const std::string &json, const std::string &dir, DelegateRegistry::Manifest &manifest)
+    {
+        rapidjson::Document d;
+        d.Parse(json.c_str());
+        if (d.HasParseError() || !d.IsObject())
+        {
+            return false;
+        }
+        if (!d.HasMember("name") || !d["name"].IsString() || !d.HasMember("library") || !d["library"].IsString())
+        {
+            PmLogError(s_pmlogCtx, "DR", 0, "manifest has no name or library");
+            return false;
+        }
+
+        manifest.name = d["name"].GetString();
+        manifest.library = d["library"].GetString();
+        if (manifest.name.empty() || manifest.library.empty())
+        {
+            return false;
+        }
+        if (manifest.library[0] != '/')
+        {
+            manifest.library = dir + "/" + manifest.library;
+        }
+
+        manifest.shareable = false;
+        if (d.HasMember("shareable"))
+        {
+            if (!d["shareable"].IsBool())
+            {
+                PmLogError(s_pmlogCtx, "DR", 0, "shareable of %s must be a boolean", manifest.name.c_str());
+                return false;
+            }
+            manifest.shareable = d["shareable"].GetBool();
+        }
+
+        std::vector<std::string> policies;
+        manifest.customOps.clear();
+        if (!readStrings(d, "custom_ops", manifest.customOps) || !readStrings(d, "policies", policies))
+        {
+            PmLogError(s_pmlogCtx, "DR", 0, "custom_ops and policies of %s must be arrays of strings", manifest.name.c_str());
+            return false;
+        }
+        manifest.policies.clear();
+        for (const auto &policyStr : policies)
+        {
+            AccelerationPolicyManager::Policy policy;
+            if (!AccelerationPolicyManager::stringToPolicy(policyStr, policy))
+            {
+                PmLogError(s_pmlogCtx, "DR", 0, "policy %s of %s is unknown", policyStr.c_str(), manifest.name.c_str());
+                return false;
+            }
+            manifest.policies.push_back(policy);
+        }
+        if (manifest.customOps.empty() && manifest.policies.empty())
+        {
+            PmLogError(s_pmlogCtx, "DR", 0, "%s declares neither custom_ops nor policies", manifest.name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool DelegateRegistry::findByCustomOp(const std::string &dir, const std::string &customOp, DelegateRegistry::Manifest &manifest)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::vector<Manifest> *manifests = scanLocked(dir);
+        if (manifests == nullptr)
+        {
+            return false;
+        }
+        for (const auto &m : *manifests)
+        {
+            if (std::find(m.customOps.begin(), m.customOps.end(), customOp) != m.customOps.end())
+            {
+                manifest = m;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool DelegateRegistry::findByPolicy(const std::string &dir, AccelerationPolicyManager::Policy policy, DelegateRegistry::Manifest &manifest)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::vector<Manifest> *manifests = scanLocked(dir);
+        if (manifests == nullptr)
+        {
+            return false;
+        }
+        for (const auto &m : *manifests)
+        {
+            if (std::find(m.policies.begin(), m.policies.end(), policy) != m.policies.end())
+            {
+                manifest = m;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool DelegateRegistry::find(const std::string &dir, const std::string &name, DelegateRegistry::Manifest &manifest)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::vector<Manifest> *manifests = scanLocked(dir);
+        if (manifests == nullptr)
+        {
+            return false;
+        }
+        for (const auto &m : *manifests)
+        {
+            if (m.name == name)
+            {
+                manifest = m;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<DelegateRegistry::Manifest> DelegateRegistry::getManifests(const std::string &dir)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::vector<Manifest> *manifests = scanLocked(dir);
+        return manifests != nullptr ? *manifests : std::vector<Manifest>();
+    }
+
+    tflite::Interpreter::TfLiteDelegatePtr DelegateRegistry::createDelegate(const DelegateRegistry::Manifest &manifest, const std::string &options)
+    {
+        const AifDelegatePlugin *plugin = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            plugin = loadLocked(manifest);
+        }
+
+        if (plugin == nullptr)
+        {
+            return tflite::Interpreter::TfLiteDelegatePtr(nullptr, [](TfLiteDelegate *) {});
+        }
+
+        auto delegate = DelegateCache::getInstance().acquire(
+            "plugin:" + manifest.library + ";" + options, manifest.shareable,
+            [plugin, &options]() { return plugin->create(options.c_str()); }, plugin->destroy);
+        if (delegate == nullptr)
+        {
+            PmLogWarning(s_pmlogCtx, "DR", 0, "plugin %s did not create a delegate", manifest.name.c_str());
+        }
+        return delegate;
+    }
+
+    bool DelegateRegistry::isLoaded(const DelegateRegistry::Manifest &manifest)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_plugins.find(manifest.library) != m_plugins.end();
+    }
+
+    const AifDelegatePlugin* DelegateRegistry::loadLocked(const DelegateRegistry::Manifest &manifest)
+    {
+        auto loaded = m_plugins.find(manifest.library);
+        if (loaded != m_plugins.end())
+        {
+            return loaded->second;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        void *handle = dlopen(manifest.library.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "DR", 0, "failed to load %s: %s", manifest.library.c_str(), dlerror());
+            return nullptr;
+        }
+
+        auto get = reinterpret_cast<AifDelegatePluginGetFunc>(dlsym(handle, AIF_DELEGATE_PLUGIN_SYMBOL));
+        const AifDelegatePlugin *plugin = (get != nullptr) ? get() : nullptr;
+        if (plugin == nullptr || plugin->abi_version != AIF_DELEGATE_PLUGIN_ABI_VERSION ||
+            plugin->name == nullptr || manifest.name != plugin->name || plugin->create == nullptr || plugin->destroy == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "DR", 0, "%s is not a delegate plugin of ABI %d named %s", manifest.library.c_str(),
+                       AIF_DELEGATE_PLUGIN_ABI_VERSION, manifest.name.c_str());
+            dlclose(handle);
+            return nullptr;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        PmLogInfo(s_pmlogCtx, "DR", 0, "plugin %s loaded from %s in %lld us", manifest.name.c_str(), manifest.library.c_str(),
+                  static_cast<long long>(elapsed));
+        m_plugins[manifest.library] = plugin;
+        return plugin;
+    }
+} // end of namespace aif
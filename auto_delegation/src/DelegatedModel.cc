@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegatedModel.h"
+#include "AutoDelegateSelector.h"
+#include "tools/Logger.h"
+
+#include <chrono>
+
+#include <tensorflow/lite/util.h>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+#ifdef GPU_DELEGATE_ONLY_GL
+    // The GL delegate only runs on the thread it was created on, so the accelerated interpreter
+    // is built by the first acquire() instead of a worker thread.
+    const std::launch kPrepareLaunch = std::launch::deferred;
+#else
+    const std::launch kPrepareLaunch = std::launch::async;
+#endif
+} // end of anonymous namespace
+
+namespace aif
+{
+    static_assert(DelegatedModel::kTensorAlignment == tflite::kDefaultTensorAlignment, "tensor alignment of TFLite changed");
+    const size_t DelegatedModel::kTensorAlignment;
+
+    DelegatedModel::Session::Session(std::unique_lock<std::mutex> lock, std::shared_ptr<tflite::Interpreter> interpreter, bool accelerated,
+                                     DelegatedModel *owner)
+        : m_lock(std::move(lock))
+        , m_interpreter(std::move(interpreter))
+        , m_accelerated(accelerated)
+        , m_owner(owner)
+    {
+    }
+
+    bool DelegatedModel::Session::isValid() const
+    {
+        return m_interpreter != nullptr;
+    }
+
+    bool DelegatedModel::Session::isAccelerated() const
+    {
+        return m_accelerated;
+    }
+
+    tflite::Interpreter &DelegatedModel::Session::interpreter()
+    {
+        return *m_interpreter;
+    }
+
+    TfLiteStatus DelegatedModel::Session::invoke()
+    {
+        if (m_interpreter == nullptr)
+        {
+            return kTfLiteError;
+        }
+        if (!m_accelerated || m_owner->m_controller == nullptr)
+        {
+            return m_owner->m_stats->invoke(*m_interpreter);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        TfLiteStatus status = m_interpreter->Invoke();
+        auto end = std::chrono::steady_clock::now();
+
+        uint64_t latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        m_owner->m_stats->recordInvoke(latencyUs, status == kTfLiteOk);
+        if (status == kTfLiteOk)
+        {
+            m_owner->adapt(latencyUs);
+        }
+        return status;
+    }
+
+    bool DelegatedModel::Session::bindInput(int i, void *data, size_t bytes)
+    {
+        if (m_interpreter == nullptr || i < 0 || i >= static_cast<int>(m_interpreter->inputs().size()))
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "input %d does not exist", i);
+            return false;
+        }
+        return bindTensor(m_interpreter->inputs()[i], data, bytes);
+    }
+
+    bool DelegatedModel::Session::bindOutput(int i, void *data, size_t bytes)
+    {
+        if (m_interpreter == nullptr || i < 0 || i >= static_cast<int>(m_interpreter->outputs().size()))
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "output %d does not exist", i);
+            return false;
+        }
+        return bindTensor(m_interpreter->outputs()[i], data, bytes);
+    }
+
+    bool DelegatedModel::Session::bindTensor(int index, void *data, size_t bytes)
+    {
+        TfLiteTensor *tensor = m_interpreter->tensor(index);
+        if (data == nullptr || reinterpret_cast<uintptr_t>(data) % kTensorAlignment != 0)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "buffer for tensor %d is not aligned to %zu bytes", index, kTensorAlignment);
+            return false;
+        }
+        if (bytes < tensor->bytes)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "buffer for tensor %d has %zu bytes, %zu are needed", index, bytes, tensor->bytes);
+            return false;
+        }
+        if (tensor->allocation_type != kTfLiteArenaRw && tensor->allocation_type != kTfLiteCustom)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "tensor %d is not allocated by the interpreter and can not be bound", index);
+            return false;
+        }
+        if (tensor->data.raw == data)
+        {
+            return true;
+        }
+
+        bool planned = (tensor->allocation_type == kTfLiteArenaRw);
+        TfLiteCustomAllocation allocation = {data, bytes};
+        if (m_interpreter->SetCustomAllocationForTensor(index, allocation) != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "failed to bind tensor %d", index);
+            return false;
+        }
+        // The first binding takes the tensor out of the arena. Later ones only swap the pointer,
+        // which AllocateTensors() checks without planning again.
+        if (m_interpreter->AllocateTensors() != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "failed to allocate tensors after binding tensor %d", index);
+            return false;
+        }
+        if (planned)
+        {
+            PmLogDebug(s_pmlogCtx, "tensor %d is bound to caller buffers", index);
+        }
+        return true;
+    }
+
+    DelegatedModel::DelegatedModel(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm)
+        : m_model(std::move(model))
+        , m_apm(std::move(apm))
+        , m_accelerated(false)
+        , m_stats(std::make_shared<DelegationStats>())
+        , m_preparationUs(0)
+    {
+    }
+
+    DelegatedModel::~DelegatedModel()
+    {
+        // a deferred preparation that nobody asked for is not run
+        if (m_pending.valid() && m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::deferred)
+        {
+            m_pending.wait();
+        }
+    }
+
+    bool DelegatedModel::init()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_interpreter != nullptr)
+        {
+            return true;
+        }
+        if (m_model == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "model is null");
+            return false;
+        }
+
+        AccelerationPolicyManager cpuApm = m_apm;
+        cpuApm.setPolicy(AccelerationPolicyManager::kCPUOnly);
+        cpuApm.setDecisionCachePath("");
+        m_interpreter = buildInterpreter(cpuApm);
+        if (m_interpreter == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "failed to build the CPU interpreter");
+            return false;
+        }
+
+        if (m_apm.getPolicy() == AccelerationPolicyManager::kCPUOnly)
+        {
+            return true;
+        }
+
+        auto policy = m_apm.getPolicy();
+        if (m_apm.getAdaptiveFallback().enabled &&
+            (policy == AccelerationPolicyManager::kEnableLoadBalancing || policy == AccelerationPolicyManager::kPytorchModelGPU))
+        {
+            m_controller.reset(new FallbackController(m_apm.getCPUFallbackPercentage(), m_apm.getAdaptiveFallback()));
+        }
+
+        prepare(m_apm);
+        return true;
+    }
+
+    DelegatedModel::Session DelegatedModel::acquire()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        swapIfReady();
+        return Session(std::move(lock), m_interpreter, m_accelerated, this);
+    }
+
+    bool DelegatedModel::isAccelerated()
+    {
+        return m_accelerated;
+    }
+
+    std::shared_ptr<const DelegationStats> DelegatedModel::getStats()
+    {
+        return m_stats;
+    }
+
+    int DelegatedModel::getCPUFallbackPercentage()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_controller != nullptr)
+        {
+            return m_controller->getServingPercentage();
+        }
+        return m_apm.getCPUFallbackPercentage();
+    }
+
+    bool DelegatedModel::waitForAcceleration()
+    {
+        std::shared_future<std::shared_ptr<tflite::Interpreter>> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_accelerated)
+            {
+                return true;
+            }
+            pending = m_pending;
+        }
+
+        if (!pending.valid())
+        {
+            return false;
+        }
+        return pending.get() != nullptr;
+    }
+
+    std::shared_ptr<tflite::Interpreter> DelegatedModel::buildInterpreter(AccelerationPolicyManager &apm)
+    {
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        if (tflite::InterpreterBuilder(*m_model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "failed to build an interpreter");
+            return nullptr;
+        }
+
+        AutoDelegateSelector ads;
+        ads.setStats(m_stats);
+        if (!ads.selectDelegate(*interpreter, apm, *m_model))
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "failed to select a delegate");
+            return nullptr;
+        }
+
+        if (interpreter->AllocateTensors() != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "DM", 0, "failed to allocate tensors");
+            return nullptr;
+        }
+        return std::shared_ptr<tflite::Interpreter>(std::move(interpreter));
+    }
+
+    void DelegatedModel::prepare(AccelerationPolicyManager apm)
+    {
+        m_pending = std::async(kPrepareLaunch, [this, apm]() mutable {
+            auto start = std::chrono::steady_clock::now();
+            std::shared_ptr<tflite::Interpreter> interpreter = buildInterpreter(apm);
+            auto end = std::chrono::steady_clock::now();
+            m_preparationUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            return interpreter;
+        }).share();
+    }
+
+    void DelegatedModel::swapIfReady()
+    {
+        if (!m_pending.valid())
+        {
+            return;
+        }
+        // a deferred preparation is run here, on the thread that is going to invoke
+        std::future_status status = m_pending.wait_for(std::chrono::seconds(0));
+        if (status != std::future_status::ready && status != std::future_status::deferred)
+        {
+            return;
+        }
+
+        std::shared_ptr<tflite::Interpreter> accelerated = m_pending.get();
+        m_pending = std::shared_future<std::shared_ptr<tflite::Interpreter>>();
+        if (m_accelerated)
+        {
+            // re-delegation asked for by the controller
+            m_controller->onRedelegated(m_preparationUs, accelerated != nullptr);
+            if (accelerated != nullptr)
+            {
+                m_interpreter = std::move(accelerated);
+                PmLogInfo(s_pmlogCtx, "DM", 0, "switched to cpu_fallback_percentage %d",
+                          m_controller->getServingPercentage());
+            }
+            return;
+        }
+
+        if (accelerated == nullptr)
+        {
+            PmLogWarning(s_pmlogCtx, "DM", 0, "accelerated interpreter is not available. CPU interpreter keeps serving");
+            return;
+        }
+
+        m_interpreter = std::move(accelerated);
+        m_accelerated = true;
+        PmLogInfo(s_pmlogCtx, "DM", 0, "switched to the accelerated interpreter");
+    }
+
+    void DelegatedModel::adapt(double latencyUs)
+    {
+        if (!m_controller->onInvoke(latencyUs))
+        {
+            return;
+        }
+
+        AccelerationPolicyManager apm = m_apm;
+        apm.setCPUFallbackPercentage(m_controller->getPercentage());
+        // the decision was made for the configured percentage
+        apm.setDecisionCachePath("");
+        prepare(std::move(apm));
+    }
+} // end of namespace aif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegationStats.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace aif
+{
+    uint64_t DelegationStats::Snapshot::getPercentileUs(double percentile) const
+    {
+        if (invoke_count == 0)
+        {
+            return 0;
+        }
+
+        uint64_t counted = 0;
+        for (int i = 0; i < kLatencyBucketNum; i++)
+        {
+            counted += latency_histogram[i];
+            if (counted * 100.0 >= percentile * invoke_count)
+            {
+                return std::min(getLatencyBucketUpperUs(i), max_latency_us);
+            }
+        }
+        return max_latency_us;
+    }
+
+    DelegationStats::DelegationStats()
+        : m_sequence(0)
+        , m_delegationCount(0)
+        , m_backendMask(0)
+        , m_failedBackendMask(0)
+        , m_delegationUs(0)
+        , m_nodeNum(0)
+        , m_cpuNodeNum(0)
+        , m_partitionNum(0)
+        , m_delegatedPartitionNum(0)
+        , m_accelerated(false)
+        , m_result(false)
+        , m_fallbackCount(0)
+        , m_invokeCount(0)
+        , m_failedInvokeCount(0)
+        , m_totalLatencyUs(0)
+        , m_maxLatencyUs(0)
+    {
+        for (auto &bucket : m_latencyHistogram)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void DelegationStats::recordDelegation(const DelegationStats::Delegation &delegation)
+    {
+        uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_backendMask.store(delegation.backend_mask, std::memory_order_relaxed);
+        m_failedBackendMask.store(delegation.failed_backend_mask, std::memory_order_relaxed);
+        m_delegationUs.store(delegation.delegation_us, std::memory_order_relaxed);
+        m_nodeNum.store(delegation.node_num, std::memory_order_relaxed);
+        m_cpuNodeNum.store(delegation.cpu_node_num, std::memory_order_relaxed);
+        m_partitionNum.store(delegation.partition_num, std::memory_order_relaxed);
+        m_delegatedPartitionNum.store(delegation.delegated_partition_num, std::memory_order_relaxed);
+        m_accelerated.store(delegation.accelerated, std::memory_order_relaxed);
+        m_result.store(delegation.result, std::memory_order_relaxed);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+        m_delegationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DelegationStats::Delegation DelegationStats::readDelegation() const
+    {
+        Delegation delegation;
+        while (true)
+        {
+            uint32_t before = m_sequence.load(std::memory_order_acquire);
+            delegation.backend_mask = m_backendMask.load(std::memory_order_relaxed);
+            delegation.failed_backend_mask = m_failedBackendMask.load(std::memory_order_relaxed);
+            delegation.delegation_us = m_delegationUs.load(std::memory_order_relaxed);
+            delegation.node_num = m_nodeNum.load(std::memory_order_relaxed);
+            delegation.cpu_node_num = m_cpuNodeNum.load(std::memory_order_relaxed);
+            delegation.partition_num = m_partitionNum.load(std::memory_order_relaxed);
+            delegation.delegated_partition_num = m_delegatedPartitionNum.load(std::memory_order_relaxed);
+            delegation.accelerated = m_accelerated.load(std::memory_order_relaxed);
+            delegation.result = m_result.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t after = m_sequence.load(std::memory_order_relaxed);
+
+            if ((before & 1) == 0 && before == after)
+            {
+                return delegation;
+            }
+        }
+    }
+
+    void DelegationStats::recordFallback()
+    {
+        m_fallbackCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void DelegationStats::recordInvoke(uint64_t latencyUs, bool success)
+    {
+        if (!success)
+        {
+            m_failedInvokeCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_latencyHistogram[getLatencyBucket(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+        m_totalLatencyUs.fetch_add(latencyUs, std::memory_order_relaxed);
+        uint64_t max = m_maxLatencyUs.load(std::memory_order_relaxed);
+        while (latencyUs > max && !m_maxLatencyUs.compare_exchange_weak(max, latencyUs, std::memory_order_relaxed))
+        {
+        }
+        m_invokeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    TfLiteStatus DelegationStats::invoke(tflite::Interpreter &interpreter)
+    {
+        auto start = std::chrono::steady_clock::now();
+        TfLiteStatus status = interpreter.Invoke();
+        auto end = std::chrono::steady_clock::now();
+
+        recordInvoke(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), status == kTfLiteOk);
+        return status;
+    }
+
+    DelegationStats::Snapshot DelegationStats::snapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.delegation_count = m_delegationCount.load(std::memory_order_relaxed);
+        snapshot.delegation = readDelegation();
+        snapshot.fallback_count = m_fallbackCount.load(std::memory_order_relaxed);
+        snapshot.failed_invoke_count = m_failedInvokeCount.load(std::memory_order_relaxed);
+        snapshot.total_latency_us = m_totalLatencyUs.load(std::memory_order_relaxed);
+        snapshot.max_latency_us = m_maxLatencyUs.load(std::memory_order_relaxed);
+
+        // invoke_count is derived from the histogram so that percentiles always add up,
+        // even while other threads keep recording
+        snapshot.invoke_count = 0;
+        for (int i = 0; i < kLatencyBucketNum; i++)
+        {
+            snapshot.latency_histogram[i] = m_latencyHistogram[i].load(std::memory_order_relaxed);
+            snapshot.invoke_count += snapshot.latency_histogram[i];
+        }
+        return snapshot;
+    }
+
+    bool DelegationStats::isAccelerated() const
+    {
+        return readDelegation().accelerated;
+    }
+
+    uint64_t DelegationStats::getInvokeCount() const
+    {
+        return m_invokeCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t DelegationStats::getFallbackCount() const
+    {
+        return m_fallbackCount.load(std::memory_order_relaxed);
+    }
+
+    int DelegationStats::getLatencyBucket(uint64_t latencyUs)
+    {
+        int bucket = 0;
+        while (latencyUs > 1 && bucket < kLatencyBucketNum - 1)
+        {
+            latencyUs >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    uint64_t DelegationStats::getLatencyBucketUpperUs(int bucket)
+    {
+        if (bucket >= kLatencyBucketNum - 1)
+        {
+            return UINT64_MAX;
+        }
+        return (static_cast<uint64_t>(1) << (bucket + 1)) - 1;
+    }
+} // end of namespace aif
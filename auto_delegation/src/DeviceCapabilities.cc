@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DeviceCapabilities.h"
+#include "tools/CpuTopology.h"
+#include "tools/Hash.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#if defined(USE_GPU) && defined(GPU_DELEGATE_ONLY_CL)
+#include "CL/cl.h"
+#endif
+
+#ifndef AUTO_DELEGATION_VERSION
+#define AUTO_DELEGATION_VERSION "unknown"
+#endif
+
+#ifndef AIF_DEVICE_CAPABILITIES_PATH
+#define AIF_DEVICE_CAPABILITIES_PATH "/var/cache/aif/device_capabilities.json"
+#endif
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    const int kCapabilitiesVersion = 1;
+
+    // Driver libraries whose update may change which delegate works best.
+    const char *kDriverLibraries[] = {
+        "/usr/lib/libOpenCL.so",
+        "/usr/lib/libGLESv2.so",
+        "/usr/lib/libedgetpu.so.1",
+    };
+
+    const char *kImgVendorName = "Imagination Technologies";
+
+    std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            return "";
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    bool exists(const std::string &path)
+    {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0;
+    }
+
+    void appendCpuInfo(std::string &fingerprint)
+    {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 8, "Hardware") == 0 || line.compare(0, 10, "model name") == 0 ||
+                line.compare(0, 8, "CPU part") == 0 || line.compare(0, 8, "Revision") == 0)
+            {
+                fingerprint += line;
+                fingerprint += ";";
+            }
+        }
+    }
+
+    // "Features" on ARM, "flags" on x86, of the first core
+    void readCpuFeatures(std::vector<std::string> &features)
+    {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 8, "Features") != 0 && line.compare(0, 5, "flags") != 0)
+            {
+                continue;
+            }
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+            {
+                continue;
+            }
+            std::istringstream ss(line.substr(colon + 1));
+            std::string feature;
+            while (ss >> feature)
+            {
+                features.push_back(feature);
+            }
+            return;
+        }
+    }
+
+    // /dev/npu* of the NPU driver
+    bool hasNpuDevice()
+    {
+        DIR *d = opendir("/dev");
+        if (d == nullptr)
+        {
+            return false;
+        }
+        bool found = false;
+        struct dirent *entry;
+        while (!found && (entry = readdir(d)) != nullptr)
+        {
+            found = (std::string(entry->d_name).compare(0, 3, "npu") == 0);
+        }
+        closedir(d);
+        return found;
+    }
+
+    // a PCIe EdgeTPU, or a USB one before (1a6e) or after (18d1:9302) its firmware is loaded
+    bool hasEdgeTpuDevice()
+    {
+        if (exists("/dev/apex_0"))
+        {
+            return true;
+        }
+        const std::string usbDir = "/sys/bus/usb/devices";
+        DIR *d = opendir(usbDir.c_str());
+        if (d == nullptr)
+        {
+            return false;
+        }
+        bool found = false;
+        struct dirent *entry;
+        while (!found && (entry = readdir(d)) != nullptr)
+        {
+            std::string device = usbDir + "/" + entry->d_name;
+            std::string vendor = readFile(device + "/idVendor");
+            std::string product = readFile(device + "/idProduct");
+            found = (vendor.compare(0, 4, "1a6e") == 0) ||
+                    (vendor.compare(0, 4, "18d1") == 0 && product.compare(0, 4, "9302") == 0);
+        }
+        closedir(d);
+        return found;
+    }
+
+#if defined(USE_GPU) && defined(GPU_DELEGATE_ONLY_CL)
+    std::string getCLDeviceInfo(cl_device_id device, cl_device_info param)
+    {
+        char buffer[256];
+        if (clGetDeviceInfo(device, param, sizeof(buffer), buffer, nullptr) != CL_SUCCESS)
+        {
+            PmLogError(s_pmlogCtx, "CAP", 0, "clGetDeviceInfo(0x%x) failed", static_cast<unsigned>(param));
+            return "";
+        }
+        buffer[sizeof(buffer) - 1] = '\0';
+        return buffer;
+    }
+
+    void probeOpenCL(aif::DeviceCapabilities::Capabilities &capabilities)
+    {
+        cl_uint platformCount = 0;
+        if (clGetPlatformIDs(0, nullptr, &platformCount) != CL_SUCCESS || platformCount == 0)
+        {
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "no OpenCL platform is found");
+            return;
+        }
+        if (platformCount != 1)
+        {
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "expected exactly one OpenCL platform, but found %d platforms", platformCount);
+        }
+        std::vector<cl_platform_id> platforms(platformCount);
+        if (clGetPlatformIDs(platformCount, platforms.data(), nullptr) != CL_SUCCESS)
+        {
+            PmLogError(s_pmlogCtx, "CAP", 0, "clGetPlatformIDs failed");
+            return;
+        }
+
+        cl_uint deviceCount = 0;
+        if (clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_ALL, 0, nullptr, &deviceCount) != CL_SUCCESS || deviceCount == 0)
+        {
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "no OpenCL device is found");
+            return;
+        }
+        if (deviceCount != 1)
+        {
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "expected exactly one OpenCL device, but found %d devices", deviceCount);
+        }
+        std::vector<cl_device_id> devices(deviceCount);
+        if (clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_ALL, deviceCount, devices.data(), nullptr) != CL_SUCCESS)
+        {
+            PmLogError(s_pmlogCtx, "CAP", 0, "clGetDeviceIDs failed");
+            return;
+        }
+
+        capabilities.gpuVendor = getCLDeviceInfo(devices[0], CL_DEVICE_VENDOR);
+        capabilities.gpuName = getCLDeviceInfo(devices[0], CL_DEVICE_NAME);
+        capabilities.gpuDriverVersion = getCLDeviceInfo(devices[0], CL_DRIVER_VERSION);
+        capabilities.openCLVersion = getCLDeviceInfo(devices[0], CL_DEVICE_VERSION);
+    }
+#endif
+
+    class SystemProber : public aif::DeviceCapabilities::Prober
+    {
+    public:
+        std::string getFingerprint() override
+        {
+            std::string fingerprint = AUTO_DELEGATION_VERSION;
+            fingerprint += ";";
+
+            struct utsname name;
+            if (uname(&name) == 0)
+            {
+                fingerprint += std::string(name.machine) + ";" + name.release + ";" + name.version + ";";
+            }
+
+            appendCpuInfo(fingerprint);
+            fingerprint += readFile("/sys/firmware/devicetree/base/compatible");
+
+            for (const char *library : kDriverLibraries)
+            {
+                struct stat st;
+                if (stat(library, &st) == 0)
+                {
+                    fingerprint += std::string(library) + ":" + std::to_string(st.st_size) + ":" +
+                                   std::to_string(st.st_mtime) + ";";
+                }
+            }
+
+            return aif::hashToString(aif::hash64(fingerprint.data(), fingerprint.size()));
+        }
+
+        bool probeCpu(aif::DeviceCapabilities::Capabilities &capabilities) override
+        {
+            struct utsname name;
+            if (uname(&name) == 0)
+            {
+                capabilities.cpuArch = name.machine;
+            }
+            readCpuFeatures(capabilities.cpuFeatures);
+
+            aif::CpuTopology topology;
+            capabilities.cpuCoreNum = topology.getOnlineCoreNum();
+            for (const auto &cluster : topology.getClusters())
+            {
+                capabilities.cpuClusters.push_back({cluster.max_frequency, static_cast<int>(cluster.cpus.size())});
+            }
+            return true;
+        }
+
+        bool probeAccelerators(aif::DeviceCapabilities::Capabilities &capabilities) override
+        {
+#if defined(USE_GPU) && defined(GPU_DELEGATE_ONLY_CL)
+            probeOpenCL(capabilities);
+#endif
+            capabilities.hasNPU = hasNpuDevice();
+            capabilities.hasEdgeTPU = hasEdgeTpuDevice();
+            return true;
+        }
+    };
+
+    void writeStringArray(rapidjson::Writer<rapidjson::StringBuffer> &writer, const std::vector<std::string> &values)
+    {
+        writer.StartArray();
+        for (const auto &value : values)
+        {
+            writer.String(value.c_str());
+        }
+        writer.EndArray();
+    }
+
+    std::string readString(const rapidjson::Value &object, const char *key)
+    {
+        return (object.HasMember(key) && object[key].IsString()) ? object[key].GetString() : "";
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    DeviceCapabilities::DeviceCapabilities()
+        : m_prober(new SystemProber()),
+          m_cachePath(getDefaultCachePath())
+    {
+    }
+
+    DeviceCapabilities& DeviceCapabilities::getInstance()
+    {
+        static DeviceCapabilities s_capabilities;
+        return s_capabilities;
+    }
+
+    void DeviceCapabilities::configure(std::unique_ptr<DeviceCapabilities::Prober> prober, const std::string &cachePath)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_prober = prober ? std::move(prober) : std::unique_ptr<Prober>(new SystemProber());
+        m_cachePath = cachePath;
+        m_fingerprint.clear();
+        m_cpuProbed = false;
+        m_cpuValid = false;
+        m_probed = false;
+    }
+
+    std::string DeviceCapabilities::getDefaultCachePath()
+    {
+        return AIF_DEVICE_CAPABILITIES_PATH;
+    }
+
+    DeviceCapabilities::Capabilities DeviceCapabilities::get()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return getLocked();
+    }
+
+    std::string DeviceCapabilities::getFingerprint()
+    {
+        // does not probe, the decision cache asks for it before any delegate is tried
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return getFingerprintLocked();
+    }
+
+    bool DeviceCapabilities::isGpuVendorIMG()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return getLocked().gpuVendor == kImgVendorName;
+    }
+
+    bool DeviceCapabilities::hasCpuFeature(const std::string &feature)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto &features = getCpuLocked().cpuFeatures;
+        return std::find(features.begin(), features.end(), feature) != features.end();
+    }
+
+    int DeviceCapabilities::getCpuCoreNum()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return getCpuLocked().cpuCoreNum;
+    }
+
+    int DeviceCapabilities::getBigCoreNum()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Capabilities &capabilities = getCpuLocked();
+        if (capabilities.cpuClusters.size() < 2)
+        {
+            return capabilities.cpuCoreNum;
+        }
+        return capabilities.cpuCoreNum - capabilities.cpuClusters.front().coreNum;
+    }
+
+    int DeviceCapabilities::getLittleCoreNum()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Capabilities &capabilities = getCpuLocked();
+        if (capabilities.cpuClusters.empty())
+        {
+            return capabilities.cpuCoreNum;
+        }
+        return capabilities.cpuClusters.front().coreNum;
+    }
+
+    const DeviceCapabilities::Capabilities& DeviceCapabilities::getLocked()
+    {
+        if (m_probed)
+        {
+            return m_capabilities;
+        }
+        getCpuLocked();
+        if (m_probed)
+        {
+            // read from the file
+            return m_capabilities;
+        }
+        m_probed = true;
+
+        if (!m_cpuValid || !m_prober->probeAccelerators(m_capabilities))
+        {
+            // Not stored, the next process probes again.
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "device capabilities could not be probed");
+            return m_capabilities;
+        }
+        PmLogInfo(s_pmlogCtx, "CAP", 0, "%s, %d cores in %zu clusters, GPU: %s %s (%s), NPU: %d, EdgeTPU: %d",
+                  m_capabilities.cpuArch.c_str(), m_capabilities.cpuCoreNum, m_capabilities.cpuClusters.size(),
+                  m_capabilities.gpuVendor.c_str(), m_capabilities.gpuName.c_str(), m_capabilities.openCLVersion.c_str(),
+                  m_capabilities.hasNPU, m_capabilities.hasEdgeTPU);
+        saveLocked();
+        return m_capabilities;
+    }
+
+    const DeviceCapabilities::Capabilities& DeviceCapabilities::getCpuLocked()
+    {
+        if (m_cpuProbed)
+        {
+            return m_capabilities;
+        }
+        m_cpuProbed = true;
+
+        const std::string &fingerprint = getFingerprintLocked();
+        if (loadLocked(fingerprint))
+        {
+            PmLogDebug(s_pmlogCtx, "device capabilities are read from %s", m_cachePath.c_str());
+            m_cpuValid = true;
+            m_probed = true;
+            return m_capabilities;
+        }
+
+        m_capabilities = {fingerprint, "", {}, 0, {}, "", "", "", "", false, false};
+        if (!m_prober->probeCpu(m_capabilities))
+        {
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "CPU capabilities could not be probed");
+            return m_capabilities;
+        }
+        m_capabilities.fingerprint = fingerprint;
+        m_cpuValid = true;
+        PmLogDebug(s_pmlogCtx, "%s, %d cores in %zu clusters", m_capabilities.cpuArch.c_str(),
+                   m_capabilities.cpuCoreNum, m_capabilities.cpuClusters.size());
+        return m_capabilities;
+    }
+
+    const std::string& DeviceCapabilities::getFingerprintLocked()
+    {
+        if (m_fingerprint.empty())
+        {
+            m_fingerprint = m_prober->getFingerprint();
+        }
+        return m_fingerprint;
+    }
+
+    bool DeviceCapabilities::loadLocked(const std::string &fingerprint)
+    {
+        if (m_cachePath.empty())
+        {
+            return false;
+        }
+        std::string content = readFile(m_cachePath);
+        Capabilities capabilities;
+        if (content.empty() || !parse(content, capabilities))
+        {
+            return false;
+        }
+        if (capabilities.fingerprint != fingerprint)
+        {
+            PmLogInfo(s_pmlogCtx, "CAP", 0, "device has changed since %s was written, probing again", m_cachePath.c_str());
+            return false;
+        }
+        m_capabilities = std::move(capabilities);
+        return true;
+    }
+
+    void DeviceCapabilities::saveLocked()
+    {
+        if (m_cachePath.empty())
+        {
+            return;
+        }
+
+        // Write to a temporary file first so that another process never reads a torn file.
+        std::string tmpPath = m_cachePath + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream file(tmpPath, std::ios::trunc);
+            if (!file.is_open())
+            {
+                PmLogDebug(s_pmlogCtx, "failed to open %s, device capabilities are not kept", tmpPath.c_str());
+                return;
+            }
+            file << serialize(m_capabilities);
+            if (!file.good())
+            {
+                file.close();
+                std::remove(tmpPath.c_str());
+                PmLogWarning(s_pmlogCtx, "CAP", 0, "failed to write %s", tmpPath.c_str());
+                return;
+            }
+        }
+        if (std::rename(tmpPath.c_str(), m_cachePath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            PmLogWarning(s_pmlogCtx, "CAP", 0, "failed to publish %s", m_cachePath.c_str());
+        }
+    }
+
+    bool DeviceCapabilities::parse(const std::string &json, DeviceCapabilities::Capabilities &capabilities)
+    {
+        rapidjson::Document d;
+        d.Parse(json.c_str());
+        if (d.HasParseError() || !d.IsObject() || !d.HasMember("version") || !d["version"].IsInt() ||
+            d["version"].GetInt() != kCapabilitiesVersion)
+        {
+            return false;
+        }
+        if (!d.HasMember("fingerprint") || !d["fingerprint"].IsString() || !d.HasMember("cpu_core_num") ||
+            !d["cpu_core_num"].IsInt())
+        {
+            return false;
+        }
+
+        capabilities = {d["fingerprint"].GetString(), readString(d, "cpu_arch"), {}, d["cpu_core_num"].GetInt(), {},
+                        readString(d, "gpu_vendor"), readString(d, "gpu_name"), readString(d, "gpu_driver_version"),
+                        readString(d, "opencl_version"), false, false};
+        if (d.HasMember("cpu_features") && d["cpu_features"].IsArray())
+        {
+            for (auto it = d["cpu_features"].Begin(); it != d["cpu_features"].End(); ++it)
+            {
+                if (it->IsString())
+                {
+                    capabilities.cpuFeatures.push_back(it->GetString());
+                }
+            }
+        }
+        if (d.HasMember("cpu_clusters") && d["cpu_clusters"].IsArray())
+        {
+            for (auto it = d["cpu_clusters"].Begin(); it != d["cpu_clusters"].End(); ++it)
+            {
+                if (!it->IsObject() || !it->HasMember("max_frequency") || !(*it)["max_frequency"].IsInt64() ||
+                    !it->HasMember("core_num") || !(*it)["core_num"].IsInt())
+                {
+                    return false;
+                }
+                capabilities.cpuClusters.push_back({static_cast<long>((*it)["max_frequency"].GetInt64()), (*it)["core_num"].GetInt()});
+            }
+        }
+        if (d.HasMember("npu") && d["npu"].IsBool())
+        {
+            capabilities.hasNPU = d["npu"].GetBool();
+        }
+        if (d.HasMember("edgetpu") && d["edgetpu"].IsBool())
+        {
+            capabilities.hasEdgeTPU = d["edgetpu"].GetBool();
+        }
+        return true;
+    }
+
+    std::string DeviceCapabilities::serialize(const DeviceCapabilities::Capabilities &capabilities)
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.Key("version");
+        writer.Int(kCapabilitiesVersion);
+        writer.Key("fingerprint");
+        writer.String(capabilities.fingerprint.c_str());
+        writer.Key("cpu_arch");
+        writer.String(capabilities.cpuArch.c_str());
+        writer.Key("cpu_features");
+        writeStringArray(writer, capabilities.cpuFeatures);
+        writer.Key("cpu_core_num");
+        writer.Int(capabilities.cpuCoreNum);
+        writer.Key("cpu_clusters");
+        writer.StartArray();
+        for (const auto &cluster : capabilities.cpuClusters)
+        {
+            writer.StartObject();
+            writer.Key("max_frequency");
+            writer.Int64(cluster.maxFrequency);
+            writer.Key("core_num");
+            writer.Int(cluster.coreNum);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.Key("gpu_vendor");
+        writer.String(capabilities.gpuVendor.c_str());
+        writer.Key("gpu_name");
+        writer.String(capabilities.gpuName.c_str());
+        writer.Key("gpu_driver_version");
+        writer.String(capabilities.gpuDriverVersion.c_str());
+        writer.Key("opencl_version");
+        writer.String(capabilities.openCLVersion.c_str());
+        writer.Key("npu");
+        writer.Bool(capabilities.hasNPU);
+        writer.Key("edgetpu");
+        writer.Bool(capabilities.hasEdgeTPU);
+        writer.EndObject();
+        return buffer.GetString();
+    }
+} // end of namespace aif
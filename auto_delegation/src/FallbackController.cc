@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "FallbackController.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    // After converging, a change of this many hystereses from the best latency starts the search over.
+    const double kDriftFactor = 2.0;
+} // end of anonymous namespace
+
+namespace aif
+{
+    FallbackController::FallbackController(int percentage, AccelerationPolicyManager::AdaptiveFallback options)
+        : m_options(std::move(options))
+        , m_serving(std::min(100, std::max(0, percentage)))
+        , m_candidate(m_serving)
+        , m_pending(-1)
+        , m_waiting(false)
+        , m_hasBest(false)
+        , m_bestPercentage(m_serving)
+        , m_bestLatencyUs(0.0)
+        , m_direction(m_serving <= 50 ? 1 : -1)
+        , m_step(std::max(1, m_options.step))
+        , m_converged(false)
+        , m_servingUs(0.0)
+        , m_redelegationUs(0.0)
+        , m_redelegationCount(0)
+    {
+        m_samples.reserve(std::max(1, m_options.window));
+    }
+
+    bool FallbackController::onInvoke(double latencyUs)
+    {
+        m_servingUs += latencyUs;
+        if (m_waiting)
+        {
+            // the old interpreter is still serving
+            return false;
+        }
+
+        if (m_pending < 0)
+        {
+            m_samples.push_back(latencyUs);
+            if (static_cast<int>(m_samples.size()) >= std::max(1, m_options.window))
+            {
+                auto median = m_samples.begin() + m_samples.size() / 2;
+                std::nth_element(m_samples.begin(), median, m_samples.end());
+                double latency = *median;
+                m_samples.clear();
+                measured(latency);
+            }
+        }
+
+        if (m_pending >= 0 && isWithinBudget())
+        {
+            m_candidate = m_pending;
+            m_pending = -1;
+            m_waiting = true;
+            return true;
+        }
+        return false;
+    }
+
+    void FallbackController::onRedelegated(double costUs, bool applied)
+    {
+        if (!m_waiting)
+        {
+            return;
+        }
+        m_waiting = false;
+        m_redelegationUs += costUs;
+        m_redelegationCount++;
+        m_samples.clear();
+
+        if (applied)
+        {
+            m_serving = m_candidate;
+            return;
+        }
+
+        PmLogWarning(s_pmlogCtx, "FBC", 0, "re-delegation with %d%% failed", m_candidate);
+        m_candidate = m_serving;
+        if (!m_converged)
+        {
+            turnAround();
+        }
+    }
+
+    void FallbackController::measured(double latencyUs)
+    {
+        if (!m_hasBest)
+        {
+            m_hasBest = true;
+            m_bestPercentage = m_serving;
+            m_bestLatencyUs = latencyUs;
+            propose(m_serving + m_direction * m_step);
+            return;
+        }
+
+        if (m_converged)
+        {
+            if (std::fabs(latencyUs - m_bestLatencyUs) > m_bestLatencyUs * m_options.hysteresis * kDriftFactor)
+            {
+                PmLogInfo(s_pmlogCtx, "FBC", 0, "latency at %d%% moved from %.0f us to %.0f us, searching again",
+                          m_serving, m_bestLatencyUs, latencyUs);
+                m_converged = false;
+                m_step = std::max(1, m_options.step);
+                m_bestPercentage = m_serving;
+                m_bestLatencyUs = latencyUs;
+                propose(m_serving + m_direction * m_step);
+            }
+            return;
+        }
+
+        if (m_serving == m_bestPercentage)
+        {
+            m_bestLatencyUs = latencyUs;
+            propose(m_serving + m_direction * m_step);
+        }
+        else if (latencyUs < m_bestLatencyUs * (1.0 - m_options.hysteresis))
+        {
+            m_bestPercentage = m_serving;
+            m_bestLatencyUs = latencyUs;
+            propose(m_serving + m_direction * m_step);
+        }
+        else
+        {
+            turnAround();
+        }
+    }
+
+    void FallbackController::turnAround()
+    {
+        m_direction = -m_direction;
+        m_step /= 2;
+        if (m_step == 0)
+        {
+            m_converged = true;
+            PmLogInfo(s_pmlogCtx, "FBC", 0, "converged on %d%% (%.0f us)", m_bestPercentage, m_bestLatencyUs);
+            propose(m_bestPercentage);
+            return;
+        }
+        propose(m_bestPercentage + m_direction * m_step);
+    }
+
+    void FallbackController::propose(int percentage)
+    {
+        percentage = std::min(100, std::max(0, percentage));
+        if (percentage == m_serving)
+        {
+            // at a bound, or already back at the best
+            m_pending = -1;
+            if (!m_converged)
+            {
+                turnAround();
+            }
+            return;
+        }
+        m_pending = percentage;
+    }
+
+    bool FallbackController::isWithinBudget() const
+    {
+        // a budget of 0 turns re-delegation off
+        return m_options.redelegation_budget > 0.0 &&
+               m_redelegationUs <= m_options.redelegation_budget * m_servingUs;
+    }
+
+    int FallbackController::getPercentage() const
+    {
+        return m_waiting ? m_candidate : m_serving;
+    }
+
+    int FallbackController::getServingPercentage() const
+    {
+        return m_serving;
+    }
+
+    bool FallbackController::isConverged() const
+    {
+        return m_converged;
+    }
+
+    int FallbackController::getRedelegationCount() const
+    {
+        return m_redelegationCount;
+    }
+} // end of namespace aif
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "InterpreterPool.h"
+#include "AutoDelegateSelector.h"
+#include "DeviceCapabilities.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+} // end of anonymous namespace
+
+namespace aif
+{
+    InterpreterPool::Lease::Lease()
+        : m_pool(nullptr)
+        , m_slot(-1)
+    {
+    }
+
+    InterpreterPool::Lease::Lease(InterpreterPool *pool, int slot)
+        : m_pool(pool)
+        , m_slot(slot)
+    {
+    }
+
+    InterpreterPool::Lease::Lease(Lease &&other)
+        : m_pool(other.m_pool)
+        , m_slot(other.m_slot)
+    {
+        other.m_pool = nullptr;
+        other.m_slot = -1;
+    }
+
+    InterpreterPool::Lease &InterpreterPool::Lease::operator=(Lease &&other)
+    {
+        if (this != &other)
+        {
+            release();
+            m_pool = other.m_pool;
+            m_slot = other.m_slot;
+            other.m_pool = nullptr;
+            other.m_slot = -1;
+        }
+        return *this;
+    }
+
+    InterpreterPool::Lease::~Lease()
+    {
+        release();
+    }
+
+    bool InterpreterPool::Lease::isValid() const
+    {
+        return m_pool != nullptr;
+    }
+
+    tflite::Interpreter &InterpreterPool::Lease::interpreter()
+    {
+        return *m_pool->m_interpreters[m_slot];
+    }
+
+    TfLiteStatus InterpreterPool::Lease::invoke()
+    {
+        if (m_pool == nullptr)
+        {
+            return kTfLiteError;
+        }
+        return m_pool->m_stats[m_slot]->invoke(*m_pool->m_interpreters[m_slot]);
+    }
+
+    void InterpreterPool::Lease::release()
+    {
+        if (m_pool != nullptr)
+        {
+            m_pool->release(m_slot);
+            m_pool = nullptr;
+            m_slot = -1;
+        }
+    }
+
+    InterpreterPool::InterpreterPool(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm)
+        : m_model(std::move(model))
+        , m_apm(std::move(apm))
+        , m_next(0)
+        , m_waiters(0)
+    {
+    }
+
+    InterpreterPool::~InterpreterPool()
+    {
+    }
+
+    bool InterpreterPool::init()
+    {
+        if (!m_interpreters.empty())
+        {
+            return true;
+        }
+        if (m_model == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "IP", 0, "model is null");
+            return false;
+        }
+
+        // applyDecision() has no model, so "auto" model tokens are derived once for every interpreter
+        AutoDelegateSelector::resolveModelTokens(m_apm, *m_model);
+        int poolSize = m_apm.getPoolSize() > 0 ? m_apm.getPoolSize() : getAutoPoolSize();
+
+        // Only the first interpreter goes through the whole selection (and AUTO_TUNE trials).
+        // The others get the same decision applied directly.
+        AutoDelegateSelector ads;
+        DelegateDecisionCache::Decision decision;
+        std::vector<std::unique_ptr<tflite::Interpreter>> interpreters;
+        std::vector<std::shared_ptr<DelegationStats>> statsList;
+        for (int i = 0; i < poolSize; i++)
+        {
+            std::unique_ptr<tflite::Interpreter> interpreter;
+            tflite::ops::builtin::BuiltinOpResolver resolver;
+            if (tflite::InterpreterBuilder(*m_model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+            {
+                PmLogError(s_pmlogCtx, "IP", 0, "failed to build interpreter %d", i);
+                return false;
+            }
+
+            auto stats = std::make_shared<DelegationStats>();
+            ads.setStats(stats);
+
+            bool delegated = false;
+            if (i == 0)
+            {
+                delegated = ads.selectDelegate(*interpreter, m_apm, *m_model);
+                decision = ads.getLastDecision();
+#ifdef GPU_DELEGATE_ONLY_GL
+                const char *gpu = AutoDelegateSelector::backendToString(AutoDelegateSelector::kBackendGPU);
+                if (std::find(decision.backends.begin(), decision.backends.end(), gpu) != decision.backends.end())
+                {
+                    PmLogError(s_pmlogCtx, "IP", 0, "the GL delegate only runs on the thread that created it, "
+                                                    "so a model delegated to GPU can not be pooled");
+                    return false;
+                }
+#endif
+            }
+            else
+            {
+                delegated = ads.applyDecision(*interpreter, m_apm, decision);
+            }
+            if (!delegated)
+            {
+                PmLogError(s_pmlogCtx, "IP", 0, "failed to select a delegate for interpreter %d", i);
+                return false;
+            }
+
+            if (interpreter->AllocateTensors() != kTfLiteOk)
+            {
+                PmLogError(s_pmlogCtx, "IP", 0, "failed to allocate tensors of interpreter %d", i);
+                return false;
+            }
+            interpreters.push_back(std::move(interpreter));
+            statsList.push_back(std::move(stats));
+        }
+
+        m_busy.reset(new std::atomic<bool>[poolSize]);
+        for (int i = 0; i < poolSize; i++)
+        {
+            m_busy[i].store(false);
+        }
+        m_interpreters = std::move(interpreters);
+        m_stats = std::move(statsList);
+
+        PmLogInfo(s_pmlogCtx, "IP", 0, "%d interpreters are ready", poolSize);
+        return true;
+    }
+
+    InterpreterPool::Lease InterpreterPool::tryAcquire()
+    {
+        int poolSize = size();
+        if (poolSize == 0)
+        {
+            return Lease();
+        }
+
+        // start from a different slot on every call so that threads do not all fight over slot 0
+        unsigned int start = m_next.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < poolSize; i++)
+        {
+            int slot = (start + i) % poolSize;
+            bool expected = false;
+            if (!m_busy[slot].load(std::memory_order_relaxed) &&
+                m_busy[slot].compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return Lease(this, slot);
+            }
+        }
+        return Lease();
+    }
+
+    InterpreterPool::Lease InterpreterPool::acquire()
+    {
+        if (size() == 0)
+        {
+            return Lease();
+        }
+
+        Lease lease = tryAcquire();
+        if (lease.isValid())
+        {
+            return lease;
+        }
+
+        // Counted before trying again, so that a release() either frees a slot this thread
+        // sees or sees this thread waiting and wakes it up. tryAcquire() reads m_busy relaxed,
+        // the fence orders that read after the count as the one in release() orders its store
+        // before reading the count.
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waiters.fetch_add(1);
+        while (true)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            lease = tryAcquire();
+            if (lease.isValid())
+            {
+                break;
+            }
+            m_released.wait(lock);
+        }
+        m_waiters.fetch_sub(1);
+        return lease;
+    }
+
+    int InterpreterPool::size() const
+    {
+        return m_interpreters.size();
+    }
+
+    int InterpreterPool::getAvailableNum() const
+    {
+        int available = 0;
+        for (int i = 0; i < size(); i++)
+        {
+            if (!m_busy[i].load(std::memory_order_relaxed))
+            {
+                available++;
+            }
+        }
+        return available;
+    }
+
+    std::shared_ptr<const DelegationStats> InterpreterPool::getStats(int index) const
+    {
+        if (index < 0 || index >= static_cast<int>(m_stats.size()))
+        {
+            return nullptr;
+        }
+        return m_stats[index];
+    }
+
+    int InterpreterPool::getAutoPoolSize()
+    {
+        // every interpreter brings its own CPU threads, so do not oversubscribe the cores
+        int cores = DeviceCapabilities::getInstance().getCpuCoreNum();
+        cores /= AutoDelegateSelector::getMaxCPUThreadNum(m_apm);
+        return cores > 0 ? cores : 1;
+    }
+
+    void InterpreterPool::release(int slot)
+    {
+        m_busy[slot].store(false, std::memory_order_release);
+        // see acquire()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_waitMutex);
+            m_released.notify_one();
+        }
+    }
+} // end of namespace aif
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "ModelLoader.h"
+#include "tools/Logger.h"
+
+#include <cerrno>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    // Read-only shared mapping of a whole file. The pages come from the page cache, so every
+    // process that maps the same file uses the same physical memory.
+    class MappedAllocation : public tflite::Allocation
+    {
+    public:
+        MappedAllocation(int fd, size_t bytes, const aif::AccelerationPolicyManager::ModelLoading &options)
+            : tflite::Allocation(tflite::DefaultErrorReporter(), tflite::Allocation::Type::kMMap)
+            , m_base(MAP_FAILED)
+            , m_bytes(bytes)
+        {
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if (options.populate)
+            {
+                flags |= MAP_POPULATE;
+            }
+#endif
+            m_base = mmap(nullptr, m_bytes, PROT_READ, flags, fd, 0);
+            if (m_base == MAP_FAILED)
+            {
+                PmLogError(s_pmlogCtx, "ML", 0, "mmap failed (errno %d)", errno);
+                return;
+            }
+
+            int advice = MADV_NORMAL;
+            switch (options.advice)
+            {
+                case aif::AccelerationPolicyManager::kAdviceSequential:
+                    advice = MADV_SEQUENTIAL;
+                    break;
+                case aif::AccelerationPolicyManager::kAdviceRandom:
+                    advice = MADV_RANDOM;
+                    break;
+                case aif::AccelerationPolicyManager::kAdviceWillNeed:
+                    advice = MADV_WILLNEED;
+                    break;
+                default:
+                    break;
+            }
+            if (advice != MADV_NORMAL && madvise(m_base, m_bytes, advice) != 0)
+            {
+                PmLogWarning(s_pmlogCtx, "ML", 0, "madvise failed (errno %d)", errno);
+            }
+        }
+
+        virtual ~MappedAllocation()
+        {
+            if (m_base != MAP_FAILED)
+            {
+                munmap(m_base, m_bytes);
+            }
+        }
+
+        const void *base() const override
+        {
+            return m_base;
+        }
+
+        size_t bytes() const override
+        {
+            return m_bytes;
+        }
+
+        bool valid() const override
+        {
+            return m_base != MAP_FAILED;
+        }
+
+    private:
+        void *m_base;
+        size_t m_bytes;
+    };
+
+    std::mutex s_mutex;
+    // file identity -> model, held only while someone uses the model
+    std::map<std::string, std::weak_ptr<tflite::FlatBufferModel>> s_models;
+    // file identities that already passed the verifier in this process
+    std::set<std::string> s_verified;
+
+    std::string makeFileKey(const struct stat &st)
+    {
+        return std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" +
+               std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    std::shared_ptr<tflite::FlatBufferModel> ModelLoader::load(const std::string &path, AccelerationPolicyManager &apm)
+    {
+        return load(path, apm.getModelLoading());
+    }
+
+    std::shared_ptr<tflite::FlatBufferModel> ModelLoader::load(const std::string &path,
+                                                               const AccelerationPolicyManager::ModelLoading &options)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            PmLogError(s_pmlogCtx, "ML", 0, "failed to open %s (errno %d)", path.c_str(), errno);
+            return nullptr;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            PmLogError(s_pmlogCtx, "ML", 0, "%s is empty or can not be read", path.c_str());
+            close(fd);
+            return nullptr;
+        }
+
+        // Keyed by the file rather than the path, so links to one file share the mapping and a
+        // replaced file is mapped again.
+        std::string key = makeFileKey(st);
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto it = s_models.find(key);
+        if (it != s_models.end())
+        {
+            std::shared_ptr<tflite::FlatBufferModel> model = it->second.lock();
+            if (model != nullptr)
+            {
+                PmLogDebug(s_pmlogCtx, "%s is already mapped", path.c_str());
+                close(fd);
+                return model;
+            }
+        }
+
+        std::unique_ptr<tflite::Allocation> allocation(new MappedAllocation(fd, static_cast<size_t>(st.st_size), options));
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+        if (!allocation->valid())
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<tflite::FlatBufferModel> model;
+        bool verify = options.verify && s_verified.find(key) == s_verified.end();
+        if (verify)
+        {
+            model = tflite::FlatBufferModel::VerifyAndBuildFromAllocation(std::move(allocation));
+        }
+        else
+        {
+            model = tflite::FlatBufferModel::BuildFromAllocation(std::move(allocation));
+        }
+        if (model == nullptr || !model->initialized())
+        {
+            PmLogError(s_pmlogCtx, "ML", 0, "%s is not a valid model", path.c_str());
+            return nullptr;
+        }
+        if (verify)
+        {
+            s_verified.insert(key);
+        }
+
+        s_models[key] = model;
+        PmLogInfo(s_pmlogCtx, "ML", 0, "mapped %s (%lld bytes%s)", path.c_str(), static_cast<long long>(st.st_size),
+                  verify ? ", verified" : "");
+        return model;
+    }
+
+    int ModelLoader::getLoadedNum()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        int loadedNum = 0;
+        for (auto it = s_models.begin(); it != s_models.end();)
+        {
+            if (it->second.expired())
+            {
+                it = s_models.erase(it);
+            }
+            else
+            {
+                loadedNum++;
+                ++it;
+            }
+        }
+        return loadedNum;
+    }
+} // end of namespace aif
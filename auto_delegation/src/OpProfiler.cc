@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "OpProfiler.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+} // end of anonymous namespace
+
+namespace aif
+{
+    OpProfiler::OpProfiler(tflite::Interpreter &interpreter, const std::string &reportPath)
+        : m_interpreter(interpreter), m_reportPath(reportPath)
+    {
+    }
+
+    OpProfiler::~OpProfiler()
+    {
+        if (!m_reportPath.empty())
+        {
+            writeReport(m_reportPath);
+        }
+    }
+
+    uint32_t OpProfiler::BeginEvent(const char *tag, EventType event_type, int64_t event_metadata1, int64_t event_metadata2)
+    {
+        bool isInvoke = (event_type == EventType::DEFAULT && tag != nullptr && strcmp(tag, "Invoke") == 0);
+        if (event_type != EventType::OPERATOR_INVOKE_EVENT && !isInvoke)
+        {
+            return 0;
+        }
+
+        Event event = {std::chrono::steady_clock::now(), event_type, tag, event_metadata1, event_metadata2};
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (isInvoke)
+        {
+            m_invokeDepth++;
+        }
+
+        uint32_t slot;
+        if (!m_freeEvents.empty())
+        {
+            slot = m_freeEvents.back();
+            m_freeEvents.pop_back();
+            m_events[slot] = event;
+        }
+        else
+        {
+            slot = m_events.size();
+            m_events.push_back(event);
+        }
+        // 0 is the handle of an event that is not recorded
+        return slot + 1;
+    }
+
+    void OpProfiler::EndEvent(uint32_t event_handle)
+    {
+        auto end = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (event_handle == 0 || event_handle > m_events.size())
+        {
+            return;
+        }
+
+        uint32_t slot = event_handle - 1;
+        const Event &event = m_events[slot];
+        int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(end - event.start).count();
+
+        if (event.type == EventType::OPERATOR_INVOKE_EVENT)
+        {
+            OpStat &stat = getOpStat(OpKey(event.metadata2, event.metadata1), event.tag);
+            stat.count++;
+            stat.total_us += elapsedUs;
+            stat.min_us = (stat.count == 1) ? elapsedUs : std::min(stat.min_us, elapsedUs);
+            stat.max_us = std::max(stat.max_us, elapsedUs);
+        }
+        else if (--m_invokeDepth == 0)
+        {
+            // subgraphs invoked by control flow ops report their own Invoke event inside this one
+            m_invokeCount++;
+            m_invokeTotalUs += elapsedUs;
+        }
+        m_freeEvents.push_back(slot);
+    }
+
+    OpProfiler::OpStat &OpProfiler::getOpStat(const OpProfiler::OpKey &key, const char *tag)
+    {
+        auto it = m_stats.find(key);
+        if (it != m_stats.end())
+        {
+            return it->second;
+        }
+
+        OpStat stat = {key.first, key.second, tag != nullptr ? tag : "", "", -1, 0, 0, 0, 0};
+
+        // Names are resolved while the interpreter is invoking, because the graph may already
+        // be gone when the report is written.
+        if (key.first == 0)
+        {
+            const tflite::Subgraph &subgraph = m_interpreter.primary_subgraph();
+            const auto &nodes = subgraph.nodes_and_registration();
+            if (key.second >= 0 && key.second < static_cast<int>(nodes.size()))
+            {
+                const auto &registration = nodes[key.second].second;
+                auto op = static_cast<tflite::BuiltinOperator>(registration.builtin_code);
+                if (op == tflite::BuiltinOperator_CUSTOM && registration.custom_name != nullptr)
+                {
+                    stat.op_name = registration.custom_name;
+                }
+                else
+                {
+                    stat.op_name = tflite::EnumNameBuiltinOperator(op);
+                }
+
+                if (op == tflite::BuiltinOperator_DELEGATE)
+                {
+                    stat.delegate_name = registration.custom_name != nullptr ? registration.custom_name : "";
+                    stat.partition = 0;
+                    for (int idx : subgraph.execution_plan())
+                    {
+                        if (idx == key.second)
+                            break;
+                        if (idx >= 0 && idx < static_cast<int>(nodes.size()) &&
+                            nodes[idx].second.builtin_code == tflite::BuiltinOperator_DELEGATE)
+                            stat.partition++;
+                    }
+                }
+            }
+        }
+
+        return m_stats.emplace(key, std::move(stat)).first->second;
+    }
+
+    int64_t OpProfiler::getInvokeCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_invokeCount;
+    }
+
+    int64_t OpProfiler::getInvokeTotalUs()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_invokeTotalUs;
+    }
+
+    std::vector<OpProfiler::OpStat> OpProfiler::getHotspots()
+    {
+        std::vector<OpStat> hotspots;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            hotspots.reserve(m_stats.size());
+            for (const auto &entry : m_stats)
+            {
+                hotspots.push_back(entry.second);
+            }
+        }
+
+        std::stable_sort(hotspots.begin(), hotspots.end(), [](const OpStat &a, const OpStat &b) {
+            return a.total_us > b.total_us;
+        });
+        return hotspots;
+    }
+
+    std::string OpProfiler::getReport()
+    {
+        std::vector<OpStat> hotspots = getHotspots();
+        int64_t invokeCount = getInvokeCount();
+        int64_t invokeTotalUs = getInvokeTotalUs();
+
+        int64_t delegatedUs = 0;
+        int64_t cpuUs = 0;
+        for (const auto &stat : hotspots)
+        {
+            if (stat.partition >= 0)
+                delegatedUs += stat.total_us;
+            else
+                cpuUs += stat.total_us;
+        }
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.Key("invoke_count");
+        writer.Int64(invokeCount);
+        writer.Key("invoke_total_us");
+        writer.Int64(invokeTotalUs);
+        writer.Key("delegated_total_us");
+        writer.Int64(delegatedUs);
+        writer.Key("cpu_total_us");
+        writer.Int64(cpuUs);
+        writer.Key("ops");
+        writer.StartArray();
+        for (const auto &stat : hotspots)
+        {
+            writer.StartObject();
+            writer.Key("subgraph_index");
+            writer.Int(stat.subgraph_index);
+            writer.Key("node_index");
+            writer.Int(stat.node_index);
+            writer.Key("op_name");
+            writer.String(stat.op_name.c_str());
+            if (stat.partition >= 0)
+            {
+                writer.Key("delegate");
+                writer.String(stat.delegate_name.c_str());
+                writer.Key("partition");
+                writer.Int(stat.partition);
+            }
+            writer.Key("count");
+            writer.Int64(stat.count);
+            writer.Key("total_us");
+            writer.Int64(stat.total_us);
+            writer.Key("avg_us");
+            writer.Double(stat.count > 0 ? static_cast<double>(stat.total_us) / stat.count : 0.0);
+            writer.Key("min_us");
+            writer.Int64(stat.min_us);
+            writer.Key("max_us");
+            writer.Int64(stat.max_us);
+            writer.Key("share");
+            writer.Double(invokeTotalUs > 0 ? static_cast<double>(stat.total_us) / invokeTotalUs : 0.0);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+
+        return std::string(buffer.GetString(), buffer.GetSize());
+    }
+
+    bool OpProfiler::writeReport(const std::string &path)
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open())
+        {
+            PmLogError(s_pmlogCtx, "OPP", 0, "failed to open %s", path.c_str());
+            return false;
+        }
+        file << getReport() << std::endl;
+        if (!file.good())
+        {
+            PmLogError(s_pmlogCtx, "OPP", 0, "failed to write %s", path.c_str());
+            return false;
+        }
+        PmLogInfo(s_pmlogCtx, "OPP", 0, "profiling report of %lld invokes is written to %s",
+                  static_cast<long long>(getInvokeCount()), path.c_str());
+        return true;
+    }
+
+    void OpProfiler::reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.clear();
+        m_invokeCount = 0;
+        m_invokeTotalUs = 0;
+    }
+} // end of namespace aif
@@ -0,0 +1,523 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "PipelinedModel.h"
+#include "AutoDelegateSelector.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <set>
+
+#include <tensorflow/lite/util.h>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    bool isCarried(const TfLiteTensor *tensor)
+    {
+        // weights are in every interpreter already, and variables stay with their stage
+        return tensor != nullptr && tensor->allocation_type != kTfLiteMmapRo &&
+               tensor->allocation_type != kTfLitePersistentRo && !tensor->is_variable;
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    PipelinedModel::PipelinedModel(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm)
+        : m_model(std::move(model))
+        , m_apm(std::move(apm))
+    {
+    }
+
+    PipelinedModel::~PipelinedModel()
+    {
+        for (auto &queue : m_queues)
+        {
+            queue->close();
+        }
+        for (auto &thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    bool PipelinedModel::init()
+    {
+        if (!m_interpreters.empty())
+        {
+            return true;
+        }
+        if (m_model == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "model is null");
+            return false;
+        }
+
+        // applyDecision() has no model, so "auto" model tokens are derived once for every interpreter
+        AutoDelegateSelector::resolveModelTokens(m_apm, *m_model);
+
+        // Only the first interpreter goes through the whole selection. Its execution plan decides
+        // the stages, and the other delegated stages get the same decision so that their plans
+        // are identical.
+        AutoDelegateSelector ads;
+        auto referenceStats = std::make_shared<DelegationStats>();
+        ads.setStats(referenceStats);
+        std::unique_ptr<tflite::Interpreter> reference;
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        if (tflite::InterpreterBuilder(*m_model, resolver)(&reference) != kTfLiteOk || reference == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to build interpreter 0");
+            return false;
+        }
+        if (!ads.selectDelegate(*reference, m_apm, *m_model))
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to select a delegate for interpreter 0");
+            return false;
+        }
+        DelegateDecisionCache::Decision decision = ads.getLastDecision();
+#ifdef GPU_DELEGATE_ONLY_GL
+        const char *gpu = AutoDelegateSelector::backendToString(AutoDelegateSelector::kBackendGPU);
+        if (std::find(decision.backends.begin(), decision.backends.end(), gpu) != decision.backends.end())
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "the GL delegate only runs on the thread that created it, "
+                                            "so a model delegated to GPU can not be pipelined");
+            return false;
+        }
+#endif
+        if (reference->AllocateTensors() != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to allocate tensors of interpreter 0");
+            return false;
+        }
+        if (reference->primary_subgraph().HasDynamicTensors())
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "a model with dynamic tensors can not be pipelined");
+            return false;
+        }
+        m_stages = split(reference->primary_subgraph(), m_apm.getPipeline().max_stages);
+        if (m_stages.empty() || !findStageTensors(*reference))
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to split the execution plan");
+            return false;
+        }
+        int stageNum = m_stages.size();
+
+        // the first interpreter serves the first delegated stage, or the only stage of a plan without delegates
+        int referenceStage = 0;
+        for (int i = 0; i < stageNum; i++)
+        {
+            if (m_stages[i].delegated)
+            {
+                referenceStage = i;
+                break;
+            }
+        }
+
+        const std::vector<int> plan = reference->primary_subgraph().execution_plan();
+        tflite::Interpreter &referenceInterpreter = *reference;
+        std::vector<std::unique_ptr<tflite::Interpreter>> interpreters;
+        std::vector<std::shared_ptr<DelegationStats>> statsList;
+        for (int i = 0; i < stageNum; i++)
+        {
+            std::vector<int> stagePlan(plan.begin() + m_stages[i].begin, plan.begin() + m_stages[i].end);
+            std::unique_ptr<tflite::Interpreter> interpreter;
+            auto stats = std::make_shared<DelegationStats>();
+            if (i == referenceStage)
+            {
+                interpreter = std::move(reference);
+                stats = referenceStats;
+            }
+            else if (!m_stages[i].delegated)
+            {
+                // no delegate is prepared for a stage that does not run one
+                interpreter = buildCPUStage(i, stagePlan, referenceInterpreter);
+                if (interpreter == nullptr)
+                {
+                    return false;
+                }
+                interpreters.push_back(std::move(interpreter));
+                statsList.push_back(std::move(stats));
+                continue;
+            }
+            else
+            {
+                if (tflite::InterpreterBuilder(*m_model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+                {
+                    PmLogError(s_pmlogCtx, "PM", 0, "failed to build interpreter %d", i);
+                    return false;
+                }
+                ads.setStats(stats);
+                if (!ads.applyDecision(*interpreter, m_apm, decision))
+                {
+                    PmLogError(s_pmlogCtx, "PM", 0, "failed to select a delegate for interpreter %d", i);
+                    return false;
+                }
+                if (interpreter->AllocateTensors() != kTfLiteOk)
+                {
+                    PmLogError(s_pmlogCtx, "PM", 0, "failed to allocate tensors of interpreter %d", i);
+                    return false;
+                }
+                if (interpreter->primary_subgraph().execution_plan() != plan)
+                {
+                    PmLogError(s_pmlogCtx, "PM", 0, "interpreter %d was delegated differently", i);
+                    return false;
+                }
+            }
+
+            // The plans of delegated stages are cut after AllocateTensors(), so the arena stays
+            // planned for the whole graph and every tensor carried into a stage has memory of its own.
+            if (interpreter->primary_subgraph().SetExecutionPlan(stagePlan) != kTfLiteOk)
+            {
+                PmLogError(s_pmlogCtx, "PM", 0, "failed to set the execution plan of stage %d", i);
+                return false;
+            }
+            interpreters.push_back(std::move(interpreter));
+            statsList.push_back(std::move(stats));
+        }
+
+        m_inputBytes.clear();
+        for (int index : referenceInterpreter.inputs())
+        {
+            m_inputBytes.push_back(referenceInterpreter.tensor(index)->bytes);
+        }
+        m_interpreters = std::move(interpreters);
+        m_stats = std::move(statsList);
+
+        for (int i = 0; i <= stageNum; i++)
+        {
+            m_queues.emplace_back(new FrameQueue(m_apm.getPipeline().queue_size));
+        }
+        for (int i = 0; i < stageNum; i++)
+        {
+            m_threads.emplace_back(&PipelinedModel::run, this, i);
+        }
+
+        PmLogInfo(s_pmlogCtx, "PM", 0, "%d stages are running", stageNum);
+        return true;
+    }
+
+    std::unique_ptr<tflite::Interpreter> PipelinedModel::buildCPUStage(int stage, const std::vector<int> &stagePlan,
+                                                                      tflite::Interpreter &reference)
+    {
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        if (tflite::InterpreterBuilder(*m_model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to build interpreter %d", stage);
+            return nullptr;
+        }
+
+        // Delegation appends the delegate nodes and leaves the CPU nodes where they were, so the
+        // plan of a CPU stage is valid without the delegates. It is set before AllocateTensors()
+        // to plan the arena for the stage alone, in the order the stage runs.
+        for (int index : stagePlan)
+        {
+            if (index < 0 || index >= static_cast<int>(interpreter->nodes_size()))
+            {
+                PmLogError(s_pmlogCtx, "PM", 0, "node %d of stage %d is not in the model", index, stage);
+                return nullptr;
+            }
+        }
+        if (interpreter->primary_subgraph().SetExecutionPlan(stagePlan) != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to set the execution plan of stage %d", stage);
+            return nullptr;
+        }
+
+        // Nothing in this plan writes the tensors carried in from earlier stages, so the arena
+        // would not hold them, and it may reuse the memory of a tensor carried out once the
+        // stage itself is done reading it. Both get memory of their own. The model inputs and
+        // outputs are kept by the arena for the whole invoke.
+        std::set<int> carried(m_stages[stage].input_tensors.begin(), m_stages[stage].input_tensors.end());
+        carried.insert(m_stages[stage].output_tensors.begin(), m_stages[stage].output_tensors.end());
+        for (int index : interpreter->inputs())
+        {
+            carried.erase(index);
+        }
+        for (int index : interpreter->outputs())
+        {
+            carried.erase(index);
+        }
+        for (int index : carried)
+        {
+            size_t bytes = reference.tensor(index)->bytes;
+            m_carriedBuffers.emplace_back(bytes + tflite::kDefaultTensorAlignment);
+            void *data = m_carriedBuffers.back().data();
+            size_t space = m_carriedBuffers.back().size();
+            TfLiteCustomAllocation allocation = {std::align(tflite::kDefaultTensorAlignment, bytes, data, space), bytes};
+            if (interpreter->SetCustomAllocationForTensor(index, allocation) != kTfLiteOk)
+            {
+                PmLogError(s_pmlogCtx, "PM", 0, "failed to allocate tensor %d of stage %d", index, stage);
+                return nullptr;
+            }
+        }
+
+        if (m_apm.getThreadPolicy().num_threads >= 0)
+        {
+            interpreter->SetNumThreads(AutoDelegateSelector::getMaxCPUThreadNum(m_apm));
+        }
+        if (interpreter->AllocateTensors() != kTfLiteOk)
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "failed to allocate tensors of interpreter %d", stage);
+            return nullptr;
+        }
+        return interpreter;
+    }
+
+    bool PipelinedModel::push(const Buffers &inputs)
+    {
+        if (m_queues.empty())
+        {
+            return false;
+        }
+        if (inputs.size() != m_inputBytes.size())
+        {
+            PmLogError(s_pmlogCtx, "PM", 0, "%zu inputs are given for %zu input tensors", inputs.size(), m_inputBytes.size());
+            return false;
+        }
+
+        std::unique_ptr<Frame> frame(new Frame());
+        frame->ok = true;
+        const std::vector<int> &indices = m_interpreters[0]->inputs();
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (inputs[i].size() != m_inputBytes[i])
+            {
+                PmLogError(s_pmlogCtx, "PM", 0, "input %zu has %zu bytes instead of %zu", i, inputs[i].size(), m_inputBytes[i]);
+                return false;
+            }
+            frame->tensors[indices[i]] = inputs[i];
+        }
+        return m_queues.front()->push(std::move(frame));
+    }
+
+    bool PipelinedModel::pop(Buffers &outputs)
+    {
+        std::unique_ptr<Frame> frame;
+        if (m_queues.empty() || !m_queues.back()->pop(frame))
+        {
+            return false;
+        }
+
+        outputs.clear();
+        if (!frame->ok)
+        {
+            return true;
+        }
+        for (int index : m_interpreters[0]->outputs())
+        {
+            outputs.push_back(std::move(frame->tensors[index]));
+        }
+        return true;
+    }
+
+    void PipelinedModel::stop()
+    {
+        if (!m_queues.empty())
+        {
+            m_queues.front()->close();
+        }
+    }
+
+    int PipelinedModel::getStageNum() const
+    {
+        return m_stages.size();
+    }
+
+    const std::vector<PipelinedModel::Stage>& PipelinedModel::getStages() const
+    {
+        return m_stages;
+    }
+
+    std::shared_ptr<const DelegationStats> PipelinedModel::getStats(int stage) const
+    {
+        if (stage < 0 || stage >= static_cast<int>(m_stats.size()))
+        {
+            return nullptr;
+        }
+        return m_stats[stage];
+    }
+
+    std::vector<PipelinedModel::Stage> PipelinedModel::split(const std::vector<bool> &delegated, int maxStages)
+    {
+        std::vector<Stage> partitions;
+        for (int i = 0; i < static_cast<int>(delegated.size()); i++)
+        {
+            // every delegate node is a partition of its own, while CPU nodes in a row share one
+            if (partitions.empty() || delegated[i] || partitions.back().delegated)
+            {
+                partitions.push_back({i, i + 1, delegated[i], {}, {}});
+            }
+            else
+            {
+                partitions.back().end = i + 1;
+            }
+        }
+
+        int partitionNum = partitions.size();
+        if (maxStages <= 0 || partitionNum <= maxStages)
+        {
+            return partitions;
+        }
+
+        std::vector<Stage> stages;
+        for (int s = 0; s < maxStages; s++)
+        {
+            int first = s * partitionNum / maxStages;
+            int last = (s + 1) * partitionNum / maxStages;
+            Stage stage = {partitions[first].begin, partitions[last - 1].end, false, {}, {}};
+            for (int p = first; p < last; p++)
+            {
+                stage.delegated = stage.delegated || partitions[p].delegated;
+            }
+            stages.push_back(std::move(stage));
+        }
+        return stages;
+    }
+
+    std::vector<PipelinedModel::Stage> PipelinedModel::split(const tflite::Subgraph &subgraph, int maxStages)
+    {
+        const auto &plan = subgraph.execution_plan();
+        const auto &nodes = subgraph.nodes_and_registration();
+        std::vector<bool> delegated;
+        for (int index : plan)
+        {
+            delegated.push_back(nodes[index].second.builtin_code == tflite::BuiltinOperator_DELEGATE);
+        }
+        return split(delegated, maxStages);
+    }
+
+    bool PipelinedModel::findStageTensors(tflite::Interpreter &interpreter)
+    {
+        const tflite::Subgraph &subgraph = interpreter.primary_subgraph();
+        const auto &plan = subgraph.execution_plan();
+        const auto &nodes = subgraph.nodes_and_registration();
+        int stageNum = m_stages.size();
+
+        std::map<int, int> producers;   // tensor index to stage
+        for (int s = 0; s < stageNum; s++)
+        {
+            for (int pos = m_stages[s].begin; pos < m_stages[s].end; pos++)
+            {
+                const TfLiteIntArray *outputs = nodes[plan[pos]].first.outputs;
+                for (int j = 0; j < outputs->size; j++)
+                {
+                    producers[outputs->data[j]] = s;
+                }
+            }
+        }
+
+        std::set<int> modelInputs(interpreter.inputs().begin(), interpreter.inputs().end());
+        std::vector<std::set<int>> stageOutputs(stageNum);
+        for (int s = 0; s < stageNum; s++)
+        {
+            std::set<int> stageInputs;
+            for (int pos = m_stages[s].begin; pos < m_stages[s].end; pos++)
+            {
+                const TfLiteIntArray *inputs = nodes[plan[pos]].first.inputs;
+                for (int j = 0; j < inputs->size; j++)
+                {
+                    int index = inputs->data[j];
+                    if (index < 0 || !isCarried(interpreter.tensor(index)))
+                    {
+                        continue;
+                    }
+
+                    auto producer = producers.find(index);
+                    if (producer == producers.end())
+                    {
+                        if (modelInputs.count(index) > 0)
+                        {
+                            stageInputs.insert(index);
+                        }
+                    }
+                    else if (producer->second < s)
+                    {
+                        stageInputs.insert(index);
+                        stageOutputs[producer->second].insert(index);
+                    }
+                    else if (producer->second > s)
+                    {
+                        PmLogError(s_pmlogCtx, "PM", 0, "tensor %d is read before it is written", index);
+                        return false;
+                    }
+                }
+            }
+            m_stages[s].input_tensors.assign(stageInputs.begin(), stageInputs.end());
+        }
+
+        for (int index : interpreter.outputs())
+        {
+            auto producer = producers.find(index);
+            if (producer != producers.end())
+            {
+                stageOutputs[producer->second].insert(index);
+            }
+        }
+        for (int s = 0; s < stageNum; s++)
+        {
+            m_stages[s].output_tensors.assign(stageOutputs[s].begin(), stageOutputs[s].end());
+        }
+        return true;
+    }
+
+    void PipelinedModel::run(int stage)
+    {
+        tflite::Interpreter &interpreter = *m_interpreters[stage];
+        const Stage &info = m_stages[stage];
+        FrameQueue &in = *m_queues[stage];
+        FrameQueue &out = *m_queues[stage + 1];
+
+        std::unique_ptr<Frame> frame;
+        while (in.pop(frame))
+        {
+            for (int index : info.input_tensors)
+            {
+                if (!frame->ok)
+                {
+                    break;
+                }
+                TfLiteTensor *tensor = interpreter.tensor(index);
+                const std::vector<uint8_t> &buffer = frame->tensors[index];
+                if (tensor->data.raw == nullptr || buffer.size() != tensor->bytes)
+                {
+                    frame->ok = false;
+                    break;
+                }
+                memcpy(tensor->data.raw, buffer.data(), buffer.size());
+            }
+
+            if (frame->ok && m_stats[stage]->invoke(interpreter) != kTfLiteOk)
+            {
+                PmLogWarning(s_pmlogCtx, "PM", 0, "stage %d failed to invoke", stage);
+                frame->ok = false;
+            }
+
+            for (int index : info.output_tensors)
+            {
+                if (!frame->ok)
+                {
+                    break;
+                }
+                const TfLiteTensor *tensor = interpreter.tensor(index);
+                if (interpreter.EnsureTensorDataIsReadable(index) != kTfLiteOk || tensor->data.raw == nullptr)
+                {
+                    frame->ok = false;
+                    break;
+                }
+                frame->tensors[index].assign(tensor->data.raw, tensor->data.raw + tensor->bytes);
+            }
+
+            if (!out.push(std::move(frame)))
+            {
+                break;
+            }
+        }
+        // lets the next stage finish the frames it has, or wakes it up after an abort
+        out.close();
+    }
+} // end of namespace aif
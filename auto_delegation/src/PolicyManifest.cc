@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "PolicyManifest.h"
+#include "tools/Hash.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+
+#include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    const char *kModelHashKey = "model_hash";
+
+    // source over target, objects member by member, anything else replaced
+    void mergeObject(rapidjson::Value &target, const rapidjson::Value &source, rapidjson::Document::AllocatorType &allocator)
+    {
+        for (auto it = source.MemberBegin(); it != source.MemberEnd(); ++it)
+        {
+            auto found = target.FindMember(it->name.GetString());
+            if (found == target.MemberEnd())
+            {
+                rapidjson::Value name(it->name, allocator);
+                rapidjson::Value value(it->value, allocator);
+                target.AddMember(name, value, allocator);
+            }
+            else if (found->value.IsObject() && it->value.IsObject())
+            {
+                mergeObject(found->value, it->value, allocator);
+            }
+            else
+            {
+                found->value.CopyFrom(it->value, allocator);
+            }
+        }
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    PolicyManifest::PolicyManifest(const std::string &json)
+    {
+        rapidjson::Document d;
+        d.Parse(json.c_str());
+        if (d.HasParseError())
+        {
+            addError("manifest is not valid JSON at offset " + std::to_string(d.GetErrorOffset()) + ": " +
+                     rapidjson::GetParseError_En(d.GetParseError()));
+            return;
+        }
+        if (!d.IsObject())
+        {
+            addError("manifest: must be an object");
+            return;
+        }
+        for (auto it = d.MemberBegin(); it != d.MemberEnd(); ++it)
+        {
+            std::string key = it->name.GetString();
+            if (key != "defaults" && key != "models")
+            {
+                addError(key + ": unknown option");
+            }
+        }
+
+        // an invalid default would be inherited by every model, so the defaults are dropped as a whole
+        rapidjson::Document defaults;
+        defaults.SetObject();
+        if (d.HasMember("defaults"))
+        {
+            std::vector<std::string> errors;
+            if (AccelerationPolicyManager::validate(d["defaults"], "defaults", errors))
+            {
+                mergeObject(defaults, d["defaults"], defaults.GetAllocator());
+            }
+            for (const auto &error : errors)
+            {
+                addError(error);
+            }
+        }
+        m_defaults = AccelerationPolicyManager(defaults);
+
+        if (!d.HasMember("models"))
+        {
+            return;
+        }
+        const auto &models = d["models"];
+        if (!models.IsObject())
+        {
+            addError("models: must be an object");
+            return;
+        }
+        for (auto it = models.MemberBegin(); it != models.MemberEnd(); ++it)
+        {
+            std::string name = it->name.GetString();
+            std::string path = "models." + name;
+            const auto &entry = it->value;
+            if (name.empty() || !entry.IsObject())
+            {
+                addError(path + ": must be an object with a name");
+                continue;
+            }
+            if (m_models.find(name) != m_models.end())
+            {
+                addError(path + ": is defined twice");
+                continue;
+            }
+
+            std::string modelHash;
+            rapidjson::Document overrides;
+            overrides.SetObject();
+            for (auto member = entry.MemberBegin(); member != entry.MemberEnd(); ++member)
+            {
+                if (std::string(member->name.GetString()) != kModelHashKey)
+                {
+                    rapidjson::Value key(member->name, overrides.GetAllocator());
+                    rapidjson::Value value(member->value, overrides.GetAllocator());
+                    overrides.AddMember(key, value, overrides.GetAllocator());
+                }
+                else if (member->value.IsString() && member->value.GetStringLength() > 0)
+                {
+                    modelHash = member->value.GetString();
+                }
+                else
+                {
+                    addError(path + "." + kModelHashKey + ": must be a non-empty string");
+                }
+            }
+
+            std::vector<std::string> errors;
+            if (!AccelerationPolicyManager::validate(overrides, path, errors))
+            {
+                for (const auto &error : errors)
+                {
+                    addError(error);
+                }
+                continue;
+            }
+            if (!modelHash.empty())
+            {
+                auto registered = m_names.find(modelHash);
+                if (registered != m_names.end())
+                {
+                    addError(path + "." + kModelHashKey + ": already used by models." + registered->second);
+                    continue;
+                }
+                m_names[modelHash] = name;
+            }
+
+            rapidjson::Document merged;
+            merged.SetObject();
+            mergeObject(merged, defaults, merged.GetAllocator());
+            mergeObject(merged, overrides, merged.GetAllocator());
+            m_models.emplace(name, AccelerationPolicyManager(merged));
+        }
+
+        PmLogInfo(s_pmlogCtx, "PMF", 0, "policy manifest has %zu models, %zu errors", m_models.size(), m_errors.size());
+    }
+
+    PolicyManifest::~PolicyManifest()
+    {
+    }
+
+    bool PolicyManifest::isValid() const
+    {
+        return m_errors.empty();
+    }
+
+    const std::vector<std::string>& PolicyManifest::getErrors() const
+    {
+        return m_errors;
+    }
+
+    bool PolicyManifest::find(const std::string &name, AccelerationPolicyManager &apm) const
+    {
+        auto found = m_models.find(name);
+        if (found == m_models.end())
+        {
+            return false;
+        }
+        apm = found->second;
+        return true;
+    }
+
+    bool PolicyManifest::findByHash(const std::string &modelHash, AccelerationPolicyManager &apm) const
+    {
+        auto found = m_names.find(modelHash);
+        return found != m_names.end() && find(found->second, apm);
+    }
+
+    bool PolicyManifest::findByModel(const tflite::FlatBufferModel &model, AccelerationPolicyManager &apm) const
+    {
+        std::string modelHash = hashModel(model);
+        return !modelHash.empty() && findByHash(modelHash, apm);
+    }
+
+    AccelerationPolicyManager PolicyManifest::getDefaults() const
+    {
+        return m_defaults;
+    }
+
+    std::vector<std::string> PolicyManifest::getModelNames() const
+    {
+        std::vector<std::string> names;
+        for (const auto &model : m_models)
+        {
+            names.push_back(model.first);
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    std::string PolicyManifest::hashModel(const tflite::FlatBufferModel &model)
+    {
+        const tflite::Allocation *allocation = model.allocation();
+        if (allocation == nullptr || allocation->base() == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "PMF", 0, "model buffer is not available");
+            return "";
+        }
+        return hashToString(hash64(allocation->base(), allocation->bytes()));
+    }
+
+    void PolicyManifest::addError(const std::string &error)
+    {
+        PmLogError(s_pmlogCtx, "PMF", 0, "%s", error.c_str());
+        m_errors.push_back(error);
+    }
+} // end of namespace aif
@@ -0,0 +1,603 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "Preprocessor.h"
+#include "tools/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PREPROCESSOR_X86
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PREPROCESSOR_NEON
+#endif
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    // widest vector in floats. Coefficients are repeated over kLanes pixels so that every
+    // kernel can load them per vector while the channels of interleaved pixels rotate.
+    const int kLanes = 8;
+    const int kCoefficientNum = kLanes * aif::Preprocessor::kMaxChannels;
+
+    typedef struct Affine
+    {
+        int channels;
+        float scale[kCoefficientNum];   // scale[i] is the one of channel i % channels
+        float bias[kCoefficientNum];
+        float lower;                    // range of the quantized type
+        float upper;
+    } Affine;
+
+    // IEEE 754 half precision, rounded to nearest even like F16C and NEON do
+    uint16_t toHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t exponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        if (exponent == 0xff)
+        {
+            return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+        }
+        int halfExponent = static_cast<int>(exponent) - 127 + 15;
+        if (halfExponent >= 0x1f)
+        {
+            return sign | 0x7c00;
+        }
+        if (halfExponent <= 0)
+        {
+            if (halfExponent < -10)
+            {
+                return sign;
+            }
+            mantissa |= 0x800000;
+            int shift = 14 - halfExponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t middle = 1u << (shift - 1);
+            if (rest > middle || (rest == middle && (half & 1)))
+            {
+                half++;
+            }
+            return sign | half;
+        }
+
+        uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        {
+            half++;     // a carry into the exponent is still the right result
+        }
+        return sign | half;
+    }
+
+    // The scalar kernels are the reference the vector ones must match. Every kernel takes n as
+    // a multiple of channels, and hands its tail to the scalar one.
+    void scalarFloat(const uint8_t *src, float *dst, size_t n, const Affine &k)
+    {
+        for (size_t i = 0; i < n; i += k.channels)
+        {
+            for (int c = 0; c < k.channels; c++)
+            {
+                dst[i + c] = src[i + c] * k.scale[c] + k.bias[c];
+            }
+        }
+    }
+
+    void scalarHalf(const uint8_t *src, uint16_t *dst, size_t n, const Affine &k)
+    {
+        for (size_t i = 0; i < n; i += k.channels)
+        {
+            for (int c = 0; c < k.channels; c++)
+            {
+                dst[i + c] = toHalf(src[i + c] * k.scale[c] + k.bias[c]);
+            }
+        }
+    }
+
+    template <typename T>
+    void scalarQuantized(const uint8_t *src, T *dst, size_t n, const Affine &k)
+    {
+        for (size_t i = 0; i < n; i += k.channels)
+        {
+            for (int c = 0; c < k.channels; c++)
+            {
+                float value = src[i + c] * k.scale[c] + k.bias[c];
+                value = std::min(std::max(value, k.lower), k.upper);
+                dst[i + c] = static_cast<T>(std::nearbyint(value));
+            }
+        }
+    }
+
+#ifdef PREPROCESSOR_X86
+    inline __m128 sse2Load4(const uint8_t *src)
+    {
+        int32_t word;
+        memcpy(&word, src, sizeof(word));
+        __m128i zero = _mm_setzero_si128();
+        __m128i bytes = _mm_cvtsi32_si128(word);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+
+    inline __m128 sse2Affine(const uint8_t *src, const Affine &k, int v)
+    {
+        return _mm_add_ps(_mm_mul_ps(sse2Load4(src), _mm_loadu_ps(k.scale + 4 * v)), _mm_loadu_ps(k.bias + 4 * v));
+    }
+
+    void sse2Float(const uint8_t *src, float *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 4 * k.channels;
+        size_t i = 0;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                _mm_storeu_ps(dst + i + 4 * v, sse2Affine(src + i + 4 * v, k, v));
+            }
+        }
+        scalarFloat(src + i, dst + i, n - i, k);
+    }
+
+    // SSE2 has no float16 conversion
+    void sse2Half(const uint8_t *src, uint16_t *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 4 * k.channels;
+        size_t i = 0;
+        float values[4];
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                _mm_storeu_ps(values, sse2Affine(src + i + 4 * v, k, v));
+                for (int j = 0; j < 4; j++)
+                {
+                    dst[i + 4 * v + j] = toHalf(values[j]);
+                }
+            }
+        }
+        scalarHalf(src + i, dst + i, n - i, k);
+    }
+
+    template <typename T>
+    void sse2Quantized(const uint8_t *src, T *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 4 * k.channels;
+        size_t i = 0;
+        __m128 lower = _mm_set1_ps(k.lower);
+        __m128 upper = _mm_set1_ps(k.upper);
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                __m128 value = _mm_min_ps(_mm_max_ps(sse2Affine(src + i + 4 * v, k, v), lower), upper);
+                __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(value), _mm_setzero_si128());
+                __m128i bytes = std::is_signed<T>::value ? _mm_packs_epi16(words, words) : _mm_packus_epi16(words, words);
+                int32_t packed = _mm_cvtsi128_si32(bytes);
+                memcpy(dst + i + 4 * v, &packed, sizeof(packed));
+            }
+        }
+        scalarQuantized(src + i, dst + i, n - i, k);
+    }
+
+    __attribute__((target("avx2,f16c"))) inline __m256 avx2Affine(const uint8_t *src, const Affine &k, int v)
+    {
+        __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src))));
+        return _mm256_add_ps(_mm256_mul_ps(value, _mm256_loadu_ps(k.scale + 8 * v)), _mm256_loadu_ps(k.bias + 8 * v));
+    }
+
+    __attribute__((target("avx2,f16c"))) void avx2Float(const uint8_t *src, float *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                _mm256_storeu_ps(dst + i + 8 * v, avx2Affine(src + i + 8 * v, k, v));
+            }
+        }
+        scalarFloat(src + i, dst + i, n - i, k);
+    }
+
+    __attribute__((target("avx2,f16c"))) void avx2Half(const uint8_t *src, uint16_t *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                __m128i half = _mm256_cvtps_ph(avx2Affine(src + i + 8 * v, k, v), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8 * v), half);
+            }
+        }
+        scalarHalf(src + i, dst + i, n - i, k);
+    }
+
+    template <typename T>
+    __attribute__((target("avx2,f16c"))) void avx2Quantized(const uint8_t *src, T *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        __m256 lower = _mm256_set1_ps(k.lower);
+        __m256 upper = _mm256_set1_ps(k.upper);
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                __m256 value = _mm256_min_ps(_mm256_max_ps(avx2Affine(src + i + 8 * v, k, v), lower), upper);
+                __m256i ints = _mm256_cvtps_epi32(value);
+                __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(ints), _mm256_extracti128_si256(ints, 1));
+                __m128i bytes = std::is_signed<T>::value ? _mm_packs_epi16(words, words) : _mm_packus_epi16(words, words);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i + 8 * v), bytes);
+            }
+        }
+        scalarQuantized(src + i, dst + i, n - i, k);
+    }
+#endif
+
+#ifdef PREPROCESSOR_NEON
+    inline void neonAffine(const uint8_t *src, const Affine &k, int v, float32x4_t &low, float32x4_t &high)
+    {
+        uint16x8_t words = vmovl_u8(vld1_u8(src));
+        low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+        high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(words)));
+        low = vaddq_f32(vmulq_f32(low, vld1q_f32(k.scale + 8 * v)), vld1q_f32(k.bias + 8 * v));
+        high = vaddq_f32(vmulq_f32(high, vld1q_f32(k.scale + 8 * v + 4)), vld1q_f32(k.bias + 8 * v + 4));
+    }
+
+    void neonFloat(const uint8_t *src, float *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        float32x4_t low, high;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                neonAffine(src + i + 8 * v, k, v, low, high);
+                vst1q_f32(dst + i + 8 * v, low);
+                vst1q_f32(dst + i + 8 * v + 4, high);
+            }
+        }
+        scalarFloat(src + i, dst + i, n - i, k);
+    }
+
+    void neonHalf(const uint8_t *src, uint16_t *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        float32x4_t low, high;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                neonAffine(src + i + 8 * v, k, v, low, high);
+                vst1_u16(dst + i + 8 * v, vreinterpret_u16_f16(vcvt_f16_f32(low)));
+                vst1_u16(dst + i + 8 * v + 4, vreinterpret_u16_f16(vcvt_f16_f32(high)));
+            }
+        }
+        scalarHalf(src + i, dst + i, n - i, k);
+    }
+
+    inline int16x8_t neonRound(float32x4_t low, float32x4_t high, const Affine &k)
+    {
+        float32x4_t lower = vdupq_n_f32(k.lower);
+        float32x4_t upper = vdupq_n_f32(k.upper);
+        low = vminq_f32(vmaxq_f32(low, lower), upper);
+        high = vminq_f32(vmaxq_f32(high, lower), upper);
+        return vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(low)), vqmovn_s32(vcvtnq_s32_f32(high)));
+    }
+
+    void neonInt8(const uint8_t *src, int8_t *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        float32x4_t low, high;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                neonAffine(src + i + 8 * v, k, v, low, high);
+                vst1_s8(dst + i + 8 * v, vqmovn_s16(neonRound(low, high, k)));
+            }
+        }
+        scalarQuantized(src + i, dst + i, n - i, k);
+    }
+
+    void neonUInt8(const uint8_t *src, uint8_t *dst, size_t n, const Affine &k)
+    {
+        size_t chunk = 8 * k.channels;
+        size_t i = 0;
+        float32x4_t low, high;
+        for (; i + chunk <= n; i += chunk)
+        {
+            for (int v = 0; v < k.channels; v++)
+            {
+                neonAffine(src + i + 8 * v, k, v, low, high);
+                vst1_u8(dst + i + 8 * v, vqmovun_s16(neonRound(low, high, k)));
+            }
+        }
+        scalarQuantized(src + i, dst + i, n - i, k);
+    }
+#endif
+
+    typedef struct Kernels
+    {
+        void (*toFloat)(const uint8_t *, float *, size_t, const Affine &);
+        void (*toHalf)(const uint8_t *, uint16_t *, size_t, const Affine &);
+        void (*toInt8)(const uint8_t *, int8_t *, size_t, const Affine &);
+        void (*toUInt8)(const uint8_t *, uint8_t *, size_t, const Affine &);
+    } Kernels;
+
+    bool isSupported(aif::Preprocessor::Isa isa)
+    {
+        switch (isa)
+        {
+        case aif::Preprocessor::kIsaScalar:
+            return true;
+#ifdef PREPROCESSOR_X86
+        case aif::Preprocessor::kIsaSSE2:
+            return __builtin_cpu_supports("sse2");
+        case aif::Preprocessor::kIsaAVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+#endif
+#ifdef PREPROCESSOR_NEON
+        case aif::Preprocessor::kIsaNEON:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Kernels getKernels(aif::Preprocessor::Isa isa)
+    {
+        switch (isa)
+        {
+#ifdef PREPROCESSOR_X86
+        case aif::Preprocessor::kIsaSSE2:
+            return {sse2Float, sse2Half, sse2Quantized<int8_t>, sse2Quantized<uint8_t>};
+        case aif::Preprocessor::kIsaAVX2:
+            return {avx2Float, avx2Half, avx2Quantized<int8_t>, avx2Quantized<uint8_t>};
+#endif
+#ifdef PREPROCESSOR_NEON
+        case aif::Preprocessor::kIsaNEON:
+            return {neonFloat, neonHalf, neonInt8, neonUInt8};
+#endif
+        default:
+            return {scalarFloat, scalarHalf, scalarQuantized<int8_t>, scalarQuantized<uint8_t>};
+        }
+    }
+
+    // repeats the coefficients of channels over kLanes pixels
+    Affine expand(const float *scale, const float *bias, int channels, float lower, float upper)
+    {
+        Affine affine;
+        affine.channels = channels;
+        for (int i = 0; i < kCoefficientNum; i++)
+        {
+            affine.scale[i] = scale[i % channels];
+            affine.bias[i] = bias[i % channels];
+        }
+        affine.lower = lower;
+        affine.upper = upper;
+        return affine;
+    }
+
+    void run(const Kernels &kernels, TfLiteType type, const uint8_t *src, void *dst, size_t n, const Affine &affine)
+    {
+        switch (type)
+        {
+        case kTfLiteFloat32:
+            kernels.toFloat(src, static_cast<float *>(dst), n, affine);
+            break;
+        case kTfLiteFloat16:
+            kernels.toHalf(src, static_cast<uint16_t *>(dst), n, affine);
+            break;
+        case kTfLiteInt8:
+            kernels.toInt8(src, static_cast<int8_t *>(dst), n, affine);
+            break;
+        case kTfLiteUInt8:
+            kernels.toUInt8(src, static_cast<uint8_t *>(dst), n, affine);
+            break;
+        default:
+            break;
+        }
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    Preprocessor::Preprocessor(Preprocessor::Options options)
+        : m_options(std::move(options))
+        , m_isa(getBestIsa())
+    {
+    }
+
+    Preprocessor::Isa Preprocessor::getBestIsa()
+    {
+        for (Isa isa : {kIsaAVX2, kIsaNEON, kIsaSSE2})
+        {
+            if (isSupported(isa))
+            {
+                return isa;
+            }
+        }
+        return kIsaScalar;
+    }
+
+    void Preprocessor::setIsa(Preprocessor::Isa isa)
+    {
+        if (!isSupported(isa))
+        {
+            PmLogWarning(s_pmlogCtx, "PP", 0, "isa %d is not supported by this CPU. Scalar kernels are used", isa);
+            isa = kIsaScalar;
+        }
+        m_isa = isa;
+    }
+
+    Preprocessor::Isa Preprocessor::getIsa() const
+    {
+        return m_isa;
+    }
+
+    bool Preprocessor::fill(const uint8_t *frame, int height, int width, int channels, tflite::Interpreter &interpreter, int input)
+    {
+        if (input < 0 || input >= static_cast<int>(interpreter.inputs().size()))
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "input %d does not exist", input);
+            return false;
+        }
+        TfLiteTensor *tensor = interpreter.tensor(interpreter.inputs()[input]);
+        if (tensor == nullptr)
+        {
+            return false;
+        }
+        return fill(frame, height, width, channels, *tensor);
+    }
+
+    bool Preprocessor::fill(const uint8_t *frame, int height, int width, int channels, TfLiteTensor &tensor)
+    {
+        std::vector<int> expected;
+        if (m_options.layout == kLayoutCHW)
+            expected = {1, channels, height, width};
+        else
+            expected = {1, height, width, channels};
+
+        const TfLiteIntArray *dims = tensor.dims;
+        if (dims == nullptr || dims->size != static_cast<int>(expected.size()) ||
+            !std::equal(expected.begin(), expected.end(), dims->data))
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "tensor %s does not have the shape of a %dx%dx%d frame",
+                       tensor.name != nullptr ? tensor.name : "", height, width, channels);
+            return false;
+        }
+        if (tensor.data.raw == nullptr)
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "tensor %s is not allocated", tensor.name != nullptr ? tensor.name : "");
+            return false;
+        }
+        return convert(frame, height, width, channels, tensor.type, tensor.params, tensor.data.raw, tensor.bytes);
+    }
+
+    bool Preprocessor::convert(const uint8_t *frame, int height, int width, int channels, TfLiteType type,
+                               const TfLiteQuantizationParams &quantization, void *dst, size_t bytes)
+    {
+        if (frame == nullptr || dst == nullptr || height <= 0 || width <= 0 || channels <= 0 || channels > kMaxChannels)
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "invalid %dx%dx%d frame", height, width, channels);
+            return false;
+        }
+
+        size_t elementSize = 0;
+        float lower = 0.0f;
+        float upper = 0.0f;
+        switch (type)
+        {
+        case kTfLiteFloat32:
+            elementSize = sizeof(float);
+            break;
+        case kTfLiteFloat16:
+            elementSize = sizeof(uint16_t);
+            break;
+        case kTfLiteInt8:
+            elementSize = sizeof(int8_t);
+            lower = -128.0f;
+            upper = 127.0f;
+            break;
+        case kTfLiteUInt8:
+            elementSize = sizeof(uint8_t);
+            lower = 0.0f;
+            upper = 255.0f;
+            break;
+        default:
+            PmLogError(s_pmlogCtx, "PP", 0, "type %d is not supported", type);
+            return false;
+        }
+
+        size_t planeSize = static_cast<size_t>(height) * width;
+        size_t n = planeSize * channels;
+        if (bytes != n * elementSize)
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "%zu bytes do not hold %zu elements of type %d", bytes, n, type);
+            return false;
+        }
+
+        const auto &mean = m_options.mean;
+        const auto &stddev = m_options.stddev;
+        if ((mean.size() > 1 && static_cast<int>(mean.size()) != channels) ||
+            (stddev.size() > 1 && static_cast<int>(stddev.size()) != channels))
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "mean and stddev must have 1 or %d values", channels);
+            return false;
+        }
+
+        bool quantized = (type == kTfLiteInt8 || type == kTfLiteUInt8);
+        if (quantized && quantization.scale <= 0.0f)
+        {
+            PmLogError(s_pmlogCtx, "PP", 0, "quantized tensor has no scale");
+            return false;
+        }
+
+        // (pixel - mean) / stddev, and for quantized types / scale + zero_point, as one multiply-add
+        float scale[kMaxChannels];
+        float bias[kMaxChannels];
+        bool identity = true;
+        for (int c = 0; c < channels; c++)
+        {
+            float m = mean.empty() ? 0.0f : mean[mean.size() == 1 ? 0 : c];
+            float s = stddev.empty() ? 1.0f : stddev[stddev.size() == 1 ? 0 : c];
+            if (s == 0.0f)
+            {
+                PmLogError(s_pmlogCtx, "PP", 0, "stddev of channel %d is 0", c);
+                return false;
+            }
+            scale[c] = 1.0f / s;
+            bias[c] = -m / s;
+            if (quantized)
+            {
+                scale[c] /= quantization.scale;
+                bias[c] = bias[c] / quantization.scale + quantization.zero_point;
+            }
+            identity = identity && scale[c] == 1.0f && bias[c] == 0.0f;
+        }
+
+        if (identity && type == kTfLiteUInt8 && m_options.layout == kLayoutHWC)
+        {
+            memcpy(dst, frame, n);
+            return true;
+        }
+
+        Kernels kernels = getKernels(m_isa);
+        if (m_options.layout == kLayoutHWC)
+        {
+            run(kernels, type, frame, dst, n, expand(scale, bias, channels, lower, upper));
+            return true;
+        }
+
+        // CHW: every channel is gathered into a plane and converted with its own coefficients
+        m_plane.resize(planeSize);
+        for (int c = 0; c < channels; c++)
+        {
+            const uint8_t *src = frame + c;
+            for (size_t i = 0; i < planeSize; i++)
+            {
+                m_plane[i] = src[i * channels];
+            }
+            run(kernels, type, m_plane.data(), static_cast<uint8_t *>(dst) + c * planeSize * elementSize, planeSize,
+                expand(scale + c, bias + c, 1, lower, upper));
+        }
+        return true;
+    }
+} // end of namespace aif
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <tools/CpuTopology.h>
+#include <tools/Logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+#include <unistd.h>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+
+    bool readLine(const std::string &path, std::string &line)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        return static_cast<bool>(std::getline(file, line));
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    CpuTopology::CpuTopology(const std::string &sysfsRoot)
+    {
+        std::string online;
+        if (!readLine(sysfsRoot + "/online", online) || !parseCpuList(online, m_onlineCpus))
+        {
+            long num = sysconf(_SC_NPROCESSORS_ONLN);
+            PmLogWarning(s_pmlogCtx, "CPU", 0, "failed to read %s/online. %ld cores are assumed", sysfsRoot.c_str(), num);
+            for (int cpu = 0; cpu < num; cpu++)
+            {
+                m_onlineCpus.push_back(cpu);
+            }
+        }
+
+        std::map<long, std::vector<int>> cpusByFrequency;
+        for (int cpu : m_onlineCpus)
+        {
+            std::string freq;
+            long maxFrequency = 0;
+            if (readLine(sysfsRoot + "/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq", freq))
+            {
+                maxFrequency = std::strtol(freq.c_str(), nullptr, 10);
+            }
+            cpusByFrequency[maxFrequency].push_back(cpu);
+        }
+
+        for (auto &entry : cpusByFrequency)
+        {
+            m_clusters.push_back({entry.first, std::move(entry.second)});
+        }
+    }
+
+    CpuTopology::~CpuTopology()
+    {
+    }
+
+    int CpuTopology::getOnlineCoreNum() const
+    {
+        return m_onlineCpus.size();
+    }
+
+    const std::vector<CpuTopology::Cluster>& CpuTopology::getClusters() const
+    {
+        return m_clusters;
+    }
+
+    int CpuTopology::getBigCoreNum() const
+    {
+        if (m_clusters.size() < 2)
+        {
+            return getOnlineCoreNum();
+        }
+        return getOnlineCoreNum() - m_clusters.front().cpus.size();
+    }
+
+    int CpuTopology::getLittleCoreNum() const
+    {
+        if (m_clusters.empty())
+        {
+            return getOnlineCoreNum();
+        }
+        return m_clusters.front().cpus.size();
+    }
+
+    bool CpuTopology::parseCpuList(const std::string &list, std::vector<int> &cpus)
+    {
+        // e.g. "0-3,6,8-9"
+        std::vector<int> parsed;
+        size_t pos = 0;
+        while (pos < list.size())
+        {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos)
+            {
+                end = list.size();
+            }
+            std::string range = list.substr(pos, end - pos);
+            pos = end + 1;
+
+            range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+            if (range.empty())
+            {
+                continue;
+            }
+
+            char *next = nullptr;
+            long first = std::strtol(range.c_str(), &next, 10);
+            long last = first;
+            if (next == range.c_str())
+            {
+                return false;
+            }
+            if (*next == '-')
+            {
+                const char *lastStr = next + 1;
+                last = std::strtol(lastStr, &next, 10);
+                if (next == lastStr)
+                {
+                    return false;
+                }
+            }
+            if (*next != '\0' || first < 0 || last < first)
+            {
+                return false;
+            }
+
+            for (long cpu = first; cpu <= last; cpu++)
+            {
+                parsed.push_back(static_cast<int>(cpu));
+            }
+        }
+
+        if (parsed.empty())
+        {
+            return false;
+        }
+        cpus = std::move(parsed);
+        return true;
+    }
+} // end of aif namespace
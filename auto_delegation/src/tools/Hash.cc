@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <tools/Hash.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t read64(const uint8_t *p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t read32(const uint8_t *p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t input)
+    {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    inline uint64_t mergeRound(uint64_t acc, uint64_t val)
+    {
+        acc ^= round(0, val);
+        return acc * kPrime1 + kPrime4;
+    }
+} // end of anonymous namespace
+
+namespace aif
+{
+    uint64_t hash64(const void *data, size_t size, uint64_t seed)
+    {
+        Hash64 hash(seed);
+        hash.update(data, size);
+        return hash.digest();
+    }
+
+    Hash64::Hash64(uint64_t seed)
+        : m_v1(seed + kPrime1 + kPrime2)
+        , m_v2(seed + kPrime2)
+        , m_v3(seed)
+        , m_v4(seed - kPrime1)
+        , m_seed(seed)
+        , m_totalSize(0)
+        , m_bufferSize(0)
+    {
+    }
+
+    void Hash64::update(const void *data, size_t size)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        const uint8_t *end = p + size;
+        m_totalSize += size;
+
+        if (m_bufferSize + size < sizeof(m_buffer))
+        {
+            memcpy(m_buffer + m_bufferSize, p, size);
+            m_bufferSize += size;
+            return;
+        }
+
+        if (m_bufferSize > 0)
+        {
+            size_t fill = sizeof(m_buffer) - m_bufferSize;
+            memcpy(m_buffer + m_bufferSize, p, fill);
+            m_v1 = round(m_v1, read64(m_buffer));
+            m_v2 = round(m_v2, read64(m_buffer + 8));
+            m_v3 = round(m_v3, read64(m_buffer + 16));
+            m_v4 = round(m_v4, read64(m_buffer + 24));
+            p += fill;
+            m_bufferSize = 0;
+        }
+
+        // stripes are consumed straight from data, so a mapped file is read once in order
+        while (p + 32 <= end)
+        {
+            m_v1 = round(m_v1, read64(p));
+            m_v2 = round(m_v2, read64(p + 8));
+            m_v3 = round(m_v3, read64(p + 16));
+            m_v4 = round(m_v4, read64(p + 24));
+            p += 32;
+        }
+
+        if (p < end)
+        {
+            m_bufferSize = static_cast<size_t>(end - p);
+            memcpy(m_buffer, p, m_bufferSize);
+        }
+    }
+
+    void Hash64::update(const std::string &data)
+    {
+        update(data.data(), data.size());
+    }
+
+    uint64_t Hash64::digest() const
+    {
+        uint64_t h;
+        if (m_totalSize >= 32)
+        {
+            h = rotl(m_v1, 1) + rotl(m_v2, 7) + rotl(m_v3, 12) + rotl(m_v4, 18);
+            h = mergeRound(h, m_v1);
+            h = mergeRound(h, m_v2);
+            h = mergeRound(h, m_v3);
+            h = mergeRound(h, m_v4);
+        }
+        else
+        {
+            h = m_seed + kPrime5;
+        }
+
+        h += m_totalSize;
+
+        const uint8_t *p = m_buffer;
+        const uint8_t *end = m_buffer + m_bufferSize;
+        while (p + 8 <= end)
+        {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * kPrime1 + kPrime4;
+            p += 8;
+        }
+        if (p + 4 <= end)
+        {
+            h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+            h = rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        while (p < end)
+        {
+            h ^= (*p) * kPrime5;
+            h = rotl(h, 11) * kPrime1;
+            p++;
+        }
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    std::string hashToString(uint64_t hash)
+    {
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+        return std::string(buffer);
+    }
+} // end of aif namespace
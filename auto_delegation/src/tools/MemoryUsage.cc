@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <tools/MemoryUsage.h>
+#include <tools/Logger.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include <unistd.h>
+
+namespace
+{
+    static PmLogContext s_pmlogCtx = aif::getADPmLogContext();
+} // end of anonymous namespace
+
+namespace aif
+{
+    long MemoryUsage::getResidentBytes(const std::string &statmPath)
+    {
+        std::ifstream file(statmPath);
+        long sizePages = 0;
+        long residentPages = 0;
+        if (!file.is_open() || !(file >> sizePages >> residentPages))
+        {
+            PmLogWarning(s_pmlogCtx, "MEM", 0, "failed to read %s", statmPath.c_str());
+            return -1;
+        }
+        return residentPages * sysconf(_SC_PAGESIZE);
+    }
+
+    MemoryUsage::TensorMemory MemoryUsage::getTensorMemory(const tflite::Interpreter &interpreter)
+    {
+        TensorMemory memory = {0, 0, 0, 0};
+        for (size_t i = 0; i < interpreter.tensors_size(); i++)
+        {
+            const TfLiteTensor *tensor = interpreter.tensor(i);
+            if (tensor == nullptr || tensor->data.raw_const == nullptr)
+            {
+                continue;
+            }
+
+            switch (tensor->allocation_type)
+            {
+            case kTfLiteArenaRw:
+                memory.arena_bytes += tensor->bytes;
+                break;
+            case kTfLiteArenaRwPersistent:
+            case kTfLitePersistentRo:
+                memory.persistent_bytes += tensor->bytes;
+                break;
+            case kTfLiteDynamic:
+                memory.dynamic_bytes += tensor->bytes;
+                break;
+            case kTfLiteMmapRo:
+                memory.read_only_bytes += tensor->bytes;
+                break;
+            default:
+                break;
+            }
+        }
+        return memory;
+    }
+
+    size_t MemoryUsage::getCost(const MemoryUsage::Footprint &footprint)
+    {
+        size_t tensorBytes = footprint.tensors.arena_bytes + footprint.tensors.persistent_bytes + footprint.tensors.dynamic_bytes;
+        size_t rssBytes = footprint.rss_delta_bytes > 0 ? static_cast<size_t>(footprint.rss_delta_bytes) : 0;
+        return std::max(tensorBytes, rssBytes);
+    }
+} // end of namespace aif
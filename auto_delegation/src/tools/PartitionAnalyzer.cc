@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <tools/PartitionAnalyzer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <set>
+
+namespace
+{
+    // builtin ops parsed by tensorflow/lite/delegates/gpu/common/model_builder.cc
+    const std::set<int> kGPUBuiltinOps = {
+        tflite::BuiltinOperator_ABS,
+        tflite::BuiltinOperator_ADD,
+        tflite::BuiltinOperator_AVERAGE_POOL_2D,
+        tflite::BuiltinOperator_BATCH_MATMUL,
+        tflite::BuiltinOperator_CONCATENATION,
+        tflite::BuiltinOperator_CONV_2D,
+        tflite::BuiltinOperator_COS,
+        tflite::BuiltinOperator_DENSIFY,
+        tflite::BuiltinOperator_DEPTH_TO_SPACE,
+        tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
+        tflite::BuiltinOperator_DEQUANTIZE,
+        tflite::BuiltinOperator_DIV,
+        tflite::BuiltinOperator_ELU,
+        tflite::BuiltinOperator_EQUAL,
+        tflite::BuiltinOperator_EXP,
+        tflite::BuiltinOperator_FLOOR,
+        tflite::BuiltinOperator_FLOOR_DIV,
+        tflite::BuiltinOperator_FLOOR_MOD,
+        tflite::BuiltinOperator_FULLY_CONNECTED,
+        tflite::BuiltinOperator_GREATER,
+        tflite::BuiltinOperator_GREATER_EQUAL,
+        tflite::BuiltinOperator_HARD_SWISH,
+        tflite::BuiltinOperator_LEAKY_RELU,
+        tflite::BuiltinOperator_LESS,
+        tflite::BuiltinOperator_LESS_EQUAL,
+        tflite::BuiltinOperator_LOG,
+        tflite::BuiltinOperator_LOGISTIC,
+        tflite::BuiltinOperator_MAX_POOL_2D,
+        tflite::BuiltinOperator_MAXIMUM,
+        tflite::BuiltinOperator_MEAN,
+        tflite::BuiltinOperator_MINIMUM,
+        tflite::BuiltinOperator_MIRROR_PAD,
+        tflite::BuiltinOperator_MUL,
+        tflite::BuiltinOperator_NEG,
+        tflite::BuiltinOperator_NOT_EQUAL,
+        tflite::BuiltinOperator_PACK,
+        tflite::BuiltinOperator_PAD,
+        tflite::BuiltinOperator_PADV2,
+        tflite::BuiltinOperator_POW,
+        tflite::BuiltinOperator_PRELU,
+        tflite::BuiltinOperator_QUANTIZE,
+        tflite::BuiltinOperator_REDUCE_MAX,
+        tflite::BuiltinOperator_REDUCE_MIN,
+        tflite::BuiltinOperator_REDUCE_PROD,
+        tflite::BuiltinOperator_RELU,
+        tflite::BuiltinOperator_RELU6,
+        tflite::BuiltinOperator_RELU_N1_TO_1,
+        tflite::BuiltinOperator_RESHAPE,
+        tflite::BuiltinOperator_RESIZE_BILINEAR,
+        tflite::BuiltinOperator_RESIZE_NEAREST_NEIGHBOR,
+        tflite::BuiltinOperator_RSQRT,
+        tflite::BuiltinOperator_SIN,
+        tflite::BuiltinOperator_SLICE,
+        tflite::BuiltinOperator_SOFTMAX,
+        tflite::BuiltinOperator_SPACE_TO_DEPTH,
+        tflite::BuiltinOperator_SPLIT,
+        tflite::BuiltinOperator_SPLIT_V,
+        tflite::BuiltinOperator_SQRT,
+        tflite::BuiltinOperator_SQUARE,
+        tflite::BuiltinOperator_SQUARED_DIFFERENCE,
+        tflite::BuiltinOperator_STRIDED_SLICE,
+        tflite::BuiltinOperator_SUB,
+        tflite::BuiltinOperator_SUM,
+        tflite::BuiltinOperator_TANH,
+        tflite::BuiltinOperator_TILE,
+        tflite::BuiltinOperator_TRANSPOSE,
+        tflite::BuiltinOperator_TRANSPOSE_CONV,
+    };
+
+    // custom ops the GPU delegate has its own kernels for
+    const char *kGPUCustomOps[] = {
+        "Convolution2DTransposeBias",
+        "MaxPoolingWithArgmax2D",
+        "MaxUnpooling2D",
+        "Resampler",
+    };
+
+    // builtin ops validated by tensorflow/lite/delegates/nnapi/nnapi_delegate.cc
+    const std::set<int> kNNAPIBuiltinOps = {
+        tflite::BuiltinOperator_ABS,
+        tflite::BuiltinOperator_ADD,
+        tflite::BuiltinOperator_ARG_MAX,
+        tflite::BuiltinOperator_ARG_MIN,
+        tflite::BuiltinOperator_AVERAGE_POOL_2D,
+        tflite::BuiltinOperator_BATCH_TO_SPACE_ND,
+        tflite::BuiltinOperator_CAST,
+        tflite::BuiltinOperator_CONCATENATION,
+        tflite::BuiltinOperator_CONV_2D,
+        tflite::BuiltinOperator_DEPTH_TO_SPACE,
+        tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
+        tflite::BuiltinOperator_DEQUANTIZE,
+        tflite::BuiltinOperator_DIV,
+        tflite::BuiltinOperator_ELU,
+        tflite::BuiltinOperator_EMBEDDING_LOOKUP,
+        tflite::BuiltinOperator_EQUAL,
+        tflite::BuiltinOperator_EXP,
+        tflite::BuiltinOperator_EXPAND_DIMS,
+        tflite::BuiltinOperator_FILL,
+        tflite::BuiltinOperator_FLOOR,
+        tflite::BuiltinOperator_FULLY_CONNECTED,
+        tflite::BuiltinOperator_GATHER,
+        tflite::BuiltinOperator_GREATER,
+        tflite::BuiltinOperator_GREATER_EQUAL,
+        tflite::BuiltinOperator_HARD_SWISH,
+        tflite::BuiltinOperator_L2_NORMALIZATION,
+        tflite::BuiltinOperator_L2_POOL_2D,
+        tflite::BuiltinOperator_LEAKY_RELU,
+        tflite::BuiltinOperator_LESS,
+        tflite::BuiltinOperator_LESS_EQUAL,
+        tflite::BuiltinOperator_LOCAL_RESPONSE_NORMALIZATION,
+        tflite::BuiltinOperator_LOG,
+        tflite::BuiltinOperator_LOGICAL_AND,
+        tflite::BuiltinOperator_LOGICAL_NOT,
+        tflite::BuiltinOperator_LOGICAL_OR,
+        tflite::BuiltinOperator_LOGISTIC,
+        tflite::BuiltinOperator_LSH_PROJECTION,
+        tflite::BuiltinOperator_LSTM,
+        tflite::BuiltinOperator_MAX_POOL_2D,
+        tflite::BuiltinOperator_MAXIMUM,
+        tflite::BuiltinOperator_MEAN,
+        tflite::BuiltinOperator_MINIMUM,
+        tflite::BuiltinOperator_MUL,
+        tflite::BuiltinOperator_NEG,
+        tflite::BuiltinOperator_NOT_EQUAL,
+        tflite::BuiltinOperator_PACK,
+        tflite::BuiltinOperator_PAD,
+        tflite::BuiltinOperator_PADV2,
+        tflite::BuiltinOperator_POW,
+        tflite::BuiltinOperator_PRELU,
+        tflite::BuiltinOperator_QUANTIZE,
+        tflite::BuiltinOperator_REDUCE_MAX,
+        tflite::BuiltinOperator_REDUCE_MIN,
+        tflite::BuiltinOperator_REDUCE_PROD,
+        tflite::BuiltinOperator_RELU,
+        tflite::BuiltinOperator_RELU6,
+        tflite::BuiltinOperator_RELU_N1_TO_1,
+        tflite::BuiltinOperator_RESHAPE,
+        tflite::BuiltinOperator_RESIZE_BILINEAR,
+        tflite::BuiltinOperator_RESIZE_NEAREST_NEIGHBOR,
+        tflite::BuiltinOperator_RNN,
+        tflite::BuiltinOperator_RSQRT,
+        tflite::BuiltinOperator_SELECT,
+        tflite::BuiltinOperator_SIN,
+        tflite::BuiltinOperator_SLICE,
+        tflite::BuiltinOperator_SOFTMAX,
+        tflite::BuiltinOperator_SPACE_TO_BATCH_ND,
+        tflite::BuiltinOperator_SPACE_TO_DEPTH,
+        tflite::BuiltinOperator_SPLIT,
+        tflite::BuiltinOperator_SPLIT_V,
+        tflite::BuiltinOperator_SQRT,
+        tflite::BuiltinOperator_SQUARED_DIFFERENCE,
+        tflite::BuiltinOperator_SQUEEZE,
+        tflite::BuiltinOperator_STRIDED_SLICE,
+        tflite::BuiltinOperator_SUB,
+        tflite::BuiltinOperator_SUM,
+        tflite::BuiltinOperator_SVDF,
+        tflite::BuiltinOperator_TANH,
+        tflite::BuiltinOperator_TILE,
+        tflite::BuiltinOperator_TOPK_V2,
+        tflite::BuiltinOperator_TRANSPOSE,
+        tflite::BuiltinOperator_TRANSPOSE_CONV,
+        tflite::BuiltinOperator_UNPACK,
+    };
+} // end of anonymous namespace
+
+namespace aif
+{
+    bool PartitionAnalyzer::isSupported(PartitionAnalyzer::Target target, const TfLiteRegistration &registration)
+    {
+        switch (target)
+        {
+        case kTargetGPU:
+            if (registration.builtin_code == tflite::BuiltinOperator_CUSTOM)
+            {
+                if (registration.custom_name == nullptr)
+                    return false;
+                for (const char *name : kGPUCustomOps)
+                {
+                    if (strcmp(registration.custom_name, name) == 0)
+                        return true;
+                }
+                return false;
+            }
+            return kGPUBuiltinOps.count(registration.builtin_code) > 0;
+        case kTargetNNAPI:
+            return kNNAPIBuiltinOps.count(registration.builtin_code) > 0;
+        default:
+            return false;
+        }
+    }
+
+    std::vector<PartitionAnalyzer::NodeClass> PartitionAnalyzer::classify(const tflite::Subgraph &subgraph, PartitionAnalyzer::Target target)
+    {
+        const auto &plan = subgraph.execution_plan();
+        const auto &nodes = subgraph.nodes_and_registration();
+
+        std::vector<NodeClass> classes;
+        classes.reserve(plan.size());
+        for (int idx : plan)
+        {
+            if (idx < 0 || idx >= static_cast<int>(nodes.size()))
+            {
+                classes.push_back(kNodeCPU);
+                continue;
+            }
+
+            const auto &registration = nodes[idx].second;
+            if (registration.builtin_code == tflite::BuiltinOperator_DELEGATE)
+                classes.push_back(kNodeDelegated);
+            else if (isSupported(target, registration))
+                classes.push_back(kNodeSupported);
+            else
+                classes.push_back(kNodeCPU);
+        }
+        return classes;
+    }
+
+    PartitionAnalyzer::Prediction PartitionAnalyzer::predict(const std::vector<PartitionAnalyzer::NodeClass> &nodes, int maxPartitions)
+    {
+        Prediction prediction = {0, 0, 0, 0, 0, 0.0};
+
+        // A partition is a run of supported nodes in the execution plan. Nodes that stay on CPU or
+        // belong to an earlier delegate end it.
+        std::vector<int> partitionSizes;
+        int runSize = 0;
+        for (auto nodeClass : nodes)
+        {
+            if (nodeClass == kNodeSupported)
+            {
+                runSize++;
+                prediction.supported_node_num++;
+            }
+            else if (runSize > 0)
+            {
+                partitionSizes.push_back(runSize);
+                runSize = 0;
+            }
+
+            if (nodeClass != kNodeDelegated)
+                prediction.node_num++;
+        }
+        if (runSize > 0)
+            partitionSizes.push_back(runSize);
+
+        prediction.partition_num = partitionSizes.size();
+        if (maxPartitions > 0 && static_cast<int>(partitionSizes.size()) > maxPartitions)
+        {
+            std::sort(partitionSizes.begin(), partitionSizes.end(), std::greater<int>());
+            partitionSizes.resize(maxPartitions);
+        }
+
+        prediction.delegated_partition_num = partitionSizes.size();
+        for (int size : partitionSizes)
+            prediction.delegated_node_num += size;
+
+        if (prediction.node_num > 0)
+            prediction.delegated_node_ratio = static_cast<double>(prediction.delegated_node_num) / prediction.node_num;
+        return prediction;
+    }
+
+    PartitionAnalyzer::Prediction PartitionAnalyzer::predict(const tflite::Subgraph &subgraph, PartitionAnalyzer::Target target, int maxPartitions)
+    {
+        return predict(classify(subgraph, target), maxPartitions);
+    }
+} // end of namespace aif
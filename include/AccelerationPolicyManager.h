@@ -4,6 +4,7 @@
  */
 #ifndef ACCELERATIONPOLICYMANAGER_H_
 #define ACCELERATIONPOLICYMANAGER_H_
+#include <map>
 #include <vector>
 #include <string>
 #include "rapidjson/document.h"
@@ -24,6 +25,24 @@ namespace aif
             kMinimumLatency = 0x10,
 
             kMinLatencyMinRes = (kMinimumLatency | kMinRes), // 0x14
+
+            kAutoTune = 0x20,
+        };
+
+        enum CpuCluster
+        {
+            kClusterAuto = 0,
+            kClusterAll,
+            kClusterBig,
+            kClusterLittle,
+        };
+
+        enum MmapAdvice
+        {
+            kAdviceNormal = 0,
+            kAdviceSequential,
+            kAdviceRandom,
+            kAdviceWillNeed,
         };
 
         typedef struct Caching
@@ -42,9 +61,86 @@ namespace aif
             std::string accelerator_name;
         } NnapiCaching;
 
+        typedef struct XnnpackOptions
+        {
+            int num_threads;
+            bool enable_qs8;
+            bool enable_qu8;
+            bool force_fp16;
+        } XnnpackOptions;
+
+        typedef struct AutoTuning
+        {
+            int warmup_runs;
+            int runs;
+        } AutoTuning;
+
+        // cluster only chooses how many threads TFLite and XNNPACK use, from the core count of
+        // that cluster. No thread is pinned to it: the workers are created inside TFLite and the
+        // kernel scheduler still decides where they run.
+        typedef struct ThreadPolicy
+        {
+            int num_threads;        // -1: leave the interpreter default, 0: derive it from cluster
+            CpuCluster cluster;
+        } ThreadPolicy;
+
+        typedef struct PartitionLimits
+        {
+            int max_delegated_partitions;       // 0: the delegate's own default
+            double min_delegated_node_ratio;    // a delegate is skipped below this share of the nodes
+        } PartitionLimits;
+
+        typedef struct Profiling
+        {
+            bool enabled;
+            std::string report_path;    // written when the interpreter is destroyed, if not empty
+        } Profiling;
+
+        typedef struct ModelLoading
+        {
+            bool populate;          // prefault the whole file with MAP_POPULATE
+            MmapAdvice advice;
+            bool verify;            // run the flatbuffer verifier the first time a file is mapped
+        } ModelLoading;
+
+        typedef struct CacheManagement
+        {
+            bool enabled;   // serialization_dir and the NNAPI cache_dir are owned by CacheManager
+            int max_mb;     // per directory, 0: no cap
+        } CacheManagement;
+
+        typedef struct AdaptiveFallback
+        {
+            bool enabled;
+            int step;                       // first change of cpu_fallback_percentage, halved on every turn
+            int window;                     // invokes measured for each percentage
+            double hysteresis;              // relative latency change that counts as better or worse
+            double redelegation_budget;     // share of the serving time re-delegations may take
+        } AdaptiveFallback;
+
+        typedef struct Pipeline
+        {
+            int max_stages;     // 0: one stage per partition
+            int queue_size;     // frames waiting in front of each stage
+        } Pipeline;
+
+        typedef struct Batching
+        {
+            int max_batch_size;     // 1: no batching
+            int window_ms;          // how long the first request of a batch waits for others
+        } Batching;
+
+        typedef struct DelegatePlugins
+        {
+            std::string dir;                                // manifests of the providers, "" disables plugins
+            std::map<std::string, std::string> options;     // JSON object handed to each plugin, by name
+        } DelegatePlugins;
+
 
         AccelerationPolicyManager();
         AccelerationPolicyManager(const std::string &config);
+        // a config already parsed, e.g. an entry of a PolicyManifest
+        AccelerationPolicyManager(const rapidjson::Value &config);
 
         virtual ~AccelerationPolicyManager();
 
@@ -57,14 +153,85 @@ namespace aif
         void setNnapiCache(std::string cache_dir, std::string model_token, bool disallow_nnapi_cpu = false, int max_number_delegated_partitions = 0, std::string accelerator_name = "");
         const NnapiCaching& getNnapiCache();
 
+        void setXnnpackOptions(XnnpackOptions options);
+        const XnnpackOptions& getXnnpackOptions();
+
+        void setAutoTuning(AutoTuning tuning);
+        const AutoTuning& getAutoTuning();
+
+        void setThreadPolicy(ThreadPolicy threadPolicy);
+        const ThreadPolicy& getThreadPolicy();
+
+        void setPartitionLimits(PartitionLimits limits);
+        const PartitionLimits& getPartitionLimits();
+
+        // 0 means no budget. Only the selectDelegate() overload that takes the model enforces it.
+        void setMaxMemoryMB(int maxMemoryMB);
+        int getMaxMemoryMB();
+
+        void setProfiling(Profiling profiling);
+        const Profiling& getProfiling();
+
+        // used by ModelLoader::load() and the constructors that take a model path
+        void setModelLoading(ModelLoading loading);
+        const ModelLoading& getModelLoading();
+
+        void setCacheManagement(CacheManagement management);
+        const CacheManagement& getCacheManagement();
+
+        // Only LOAD_BALANCING and PYTORCH_MODEL_GPU served by DelegatedModel adapt, see FallbackController
+        void setAdaptiveFallback(AdaptiveFallback adaptiveFallback);
+        const AdaptiveFallback& getAdaptiveFallback();
+
+        // 0 means one interpreter per available core group, see InterpreterPool
+        void setPoolSize(int size);
+        int getPoolSize();
+
+        // see PipelinedModel
+        void setPipeline(Pipeline pipeline);
+        const Pipeline& getPipeline();
+
+        // see BatchedModel
+        void setBatching(Batching batching);
+        const Batching& getBatching();
+
+        // see DelegateRegistry
+        void setDelegatePlugins(DelegatePlugins plugins);
+        const DelegatePlugins& getDelegatePlugins();
+        static const char* getDefaultDelegatePluginDir();
+
+        void setDecisionCachePath(std::string path);
+        const std::string& getDecisionCachePath();
+
         bool setCPUFallbackPercentage(int percentage);
         int getCPUFallbackPercentage();
 
+        // Returns false for a string that is not a policy name like "MIN_LATENCY"
+        static bool stringToPolicy(const std::string &policyStr, Policy &policy);
+        // Appends "<path>.<key>: <problem>" for every unknown key and every value of the wrong
+        // type in config. The constructors skip such values, this tells why.
+        static bool validate(const rapidjson::Value &config, const std::string &path, std::vector<std::string> &errors);
+
     private:
+        void load(const rapidjson::Value &config);
         Policy stringToPolicy(const std::string &policy);
         Policy m_policy = kCPUOnly;
         Caching m_cache = {false, "", ""};
         NnapiCaching m_nnapi_cache = {"", "", false, 0, ""};
+        XnnpackOptions m_xnnpack_options = {0, false, false, false};
+        AutoTuning m_auto_tuning = {2, 10};
+        ThreadPolicy m_thread_policy = {-1, kClusterAuto};
+        PartitionLimits m_partition_limits = {0, 0.0};
+        Profiling m_profiling = {false, ""};
+        ModelLoading m_model_loading = {false, kAdviceNormal, true};
+        CacheManagement m_cache_management = {false, 0};
+        AdaptiveFallback m_adaptive_fallback = {false, 20, 30, 0.05, 0.05};
+        int m_max_memory_mb = 0;
+        std::string m_decision_cache_path = "";
+        int m_pool_size = 0;
+        Pipeline m_pipeline = {0, 2};
+        Batching m_batching = {1, 2};
+        DelegatePlugins m_delegate_plugins = {getDefaultDelegatePluginDir(), {}};
         int m_cpuFallbackPercentage = 0;
     };
 } // end of namespace aif
@@ -6,7 +6,11 @@
 #define AUTODELEGATESELECTOR_H_
 #include <iostream>
 #include <vector>
+#include <chrono>
 #include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
 
 #include <tensorflow/lite/interpreter.h>
 #include <tensorflow/lite/kernels/register.h>
@@ -14,11 +18,6 @@
 
 #ifdef USE_GPU
 #include <tensorflow/lite/delegates/gpu/delegate.h>
-
-#ifdef GPU_DELEGATE_ONLY_CL
-#include "CL/cl.h"
-#endif
-
 #endif
 
 #ifdef USE_EDGETPU
@@ -33,23 +32,107 @@
 #include <tensorflow/lite/delegates/nnapi/nnapi_delegate.h>
 #endif
 
+#ifdef USE_XNNPACK
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+#endif
+
 #include "AccelerationPolicyManager.h"
+#include "DelegateDecisionCache.h"
+#include "DelegationStats.h"
+#include "OpProfiler.h"
+#include "tools/MemoryUsage.h"
 
 namespace aif
 {
     class AutoDelegateSelector
     {
     public:
+        enum Backend
+        {
+            kBackendCPU = 0,
+            kBackendXNNPack,
+            kBackendGPU,
+            kBackendNNAPI,
+            kBackendNPU,
+            kBackendEdgeTPU,
+        };
+
         AutoDelegateSelector();
         virtual ~AutoDelegateSelector() = default;
+        // With "profiling" in the policy, an OpProfiler is attached to the interpreter as well.
+        // It can be reached with dynamic_cast<OpProfiler*>(interpreter.GetProfiler()).
         bool selectDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm);
+        // kAutoTune builds trial interpreters from the model, so it is only honored by this overload.
+        // With a decision_cache the interpreter must not be delegated yet. A stored decision that
+        // no longer applies is dropped and the delegate is selected again, unless it left the
+        // graph partly delegated; then false is returned and the interpreter has to be rebuilt.
+        bool selectDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model);
+
+        // Runs selectDelegate() on a worker thread. The worker keeps its own references to the
+        // interpreter and the model, so the caller may drop theirs at any time, but it must not
+        // touch the interpreter until the future is ready. Destroying the future waits for the worker.
+        // With GPU_DELEGATE_ONLY_GL the interpreter has to be invoked from the worker thread, so
+        // use selectDelegate() instead.
+        static std::future<bool> selectDelegateAsync(std::shared_ptr<tflite::Interpreter> interpreter, AccelerationPolicyManager apm,
+                                                     std::shared_ptr<const tflite::FlatBufferModel> model = nullptr);
+
+        // What the last selectDelegate() call did. It can be applied to other interpreters of the
+        // same model with applyDecision() without walking the graph or trial-running again.
+        const DelegateDecisionCache::Decision& getLastDecision();
+        bool applyDecision(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const DelegateDecisionCache::Decision &decision);
+
+        // Memory of the trial interpreter that was chosen under the max_memory_mb budget, or of
+        // the AUTO_TUNE winner. rss_delta_bytes is -1 if nothing was measured.
+        const MemoryUsage::Footprint& getLastFootprint();
+
+        // Delegations done by this selector from now on, and the delegates that failed or were
+        // skipped on the way, are recorded to stats.
+        void setStats(std::shared_ptr<DelegationStats> stats);
+
+        // The most CPU threads one interpreter delegated under apm may run at once, counting
+        // the interpreter's own and XNNPACK's, from the thread policy and the xnnpack options.
+        // Acceleration is not known before selection, so the auto policy counts as CPU bound.
+        static int getMaxCPUThreadNum(AccelerationPolicyManager &apm);
+
+        static const char* backendToString(Backend backend);
+        static bool stringToBackend(const std::string &backendStr, Backend &backend);
+
+        // Replaces a "serialization" or "caching" model_token of "auto" with deriveModelToken().
+        // selectDelegate() does this on its own when it is given the model. Returns false if a
+        // token is "auto" but the model buffer is not available.
+        static bool resolveModelTokens(AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model);
+        // Hash of the model content, the options that change what the backend caches, the
+        // library and TFLite versions and the device. A changed model never reuses a stale cache.
+        static std::string deriveModelToken(const tflite::FlatBufferModel &model, Backend backend, AccelerationPolicyManager &apm);
 
     private:
+        bool selectDelegateWithModel(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model);
+        bool selectDelegateByPolicy(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm);
+        bool selectDelegateWithinBudget(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model);
+        bool measureFootprint(const tflite::FlatBufferModel &model, const std::function<bool(AutoDelegateSelector &, tflite::Interpreter &)> &delegate,
+                              DelegateDecisionCache::Decision &decision, MemoryUsage::Footprint &footprint);
+        // plugin is the name of the DelegateRegistry plugin that declares the custom op, if no
+        // built-in backend does
+        bool findCustomOpBackend(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, Backend &backend, std::string &plugin);
+        std::vector<Backend> getAvailableBackends();
+        bool setBackendDelegate(tflite::Interpreter &interpreter, Backend backend, AccelerationPolicyManager &apm);
+        bool applyBackend(tflite::Interpreter &interpreter, Backend backend, AccelerationPolicyManager &apm);
+        bool setPluginDelegate(tflite::Interpreter &interpreter, const std::string &plugin, AccelerationPolicyManager &apm);
+        bool applyPlugin(tflite::Interpreter &interpreter, const std::string &plugin, AccelerationPolicyManager &apm);
+        bool isDelegationProfitable(tflite::Interpreter &interpreter, Backend backend, AccelerationPolicyManager &apm);
+        int getMaxDelegatedPartitions(Backend backend, AccelerationPolicyManager &apm);
+        bool replayDecision(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const DelegateDecisionCache::Decision &decision);
+        bool autoTune(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, const tflite::FlatBufferModel &model);
+        double measureBackendLatency(const tflite::FlatBufferModel &model, Backend backend, AccelerationPolicyManager &apm,
+                                     MemoryUsage::Footprint &footprint);
+        static int getThreadNum(AccelerationPolicyManager &apm, bool isCPUBound);
+        void applyThreadPolicy(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm, int originalNodeNum);
+        void attachProfiler(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm);
+        bool isAcceleratorApplied();
+        void recordStats(tflite::Interpreter &interpreter, int originalNodeNum, std::chrono::steady_clock::time_point start);
+
 #ifdef USE_GPU
         bool setTfLiteGPUDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm);
-#ifdef GPU_DELEGATE_ONLY_CL
-        bool isCLDeviceVendorIMG();
-#endif
 #endif
 #ifdef USE_NPU
         bool setWebOSNPUDelegate(tflite::Interpreter &interpreter);
@@ -57,10 +140,18 @@ namespace aif
 #ifdef USE_NNAPI
         bool setNNAPIDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm);
 #endif
+#ifdef USE_XNNPACK
+        bool setXNNPackDelegate(tflite::Interpreter &interpreter, AccelerationPolicyManager &apm);
+#endif
 #ifdef USE_EDGETPU
         bool setEdgeTPUDelegate(tflite::Interpreter &interpreter);
         const std::string EDGETPU_LIB_PATH = "/usr/lib/libedgetpu.so.1";
 #endif
+
+        // what the last selectDelegate() call did, as stored in DelegateDecisionCache
+        DelegateDecisionCache::Decision m_decision = {{}, {}, -1, false};
+        std::shared_ptr<DelegationStats> m_stats;
+        MemoryUsage::Footprint m_footprint = {{0, 0, 0, 0}, -1};
     };
 } // end of namespace aif
 #endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef BATCHEDMODEL_H_
+#define BATCHEDMODEL_H_
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+#include "DelegationStats.h"
+
+namespace aif
+{
+    // Collects independent requests for a model whose inputs and outputs have a leading batch
+    // dimension of 1, and runs them as one batch once max_batch_size requests are waiting or
+    // the first of them has waited window_ms. Batches are run at bucket sizes 1, 2, 4, ... up to
+    // max_batch_size, each with an interpreter resized to its batch size before the delegate is
+    // selected for it, so no interpreter is ever resized and re-delegated while serving. A batch
+    // smaller than its bucket is padded with zeros.
+    // The interpreters are delegated by init() and invoked on the batching thread, so a GPU
+    // delegate built with GPU_DELEGATE_ONLY_GL, which only runs on the thread that created it,
+    // makes init() fail.
+    class BatchedModel
+    {
+    public:
+        // one buffer per tensor, in the order of Interpreter::inputs() or outputs()
+        typedef std::vector<std::vector<uint8_t>> Buffers;
+
+        BatchedModel(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm);
+        // fails the requests still waiting and joins the batching thread
+        virtual ~BatchedModel();
+
+        // builds and delegates the interpreter of every bucket
+        bool init();
+
+        // Runs one request of batch size 1, from any thread. Blocks until the batch holding it
+        // has run. Returns false if a buffer does not match its input tensor or the batch failed.
+        bool infer(const Buffers &inputs, Buffers &outputs);
+
+        const std::vector<int>& getBuckets() const;
+        // Invokes of the batches, and the delegation of every bucket
+        std::shared_ptr<const DelegationStats> getStats();
+        uint64_t getRequestCount();
+
+        static std::vector<int> makeBuckets(int maxBatchSize);
+
+    private:
+        typedef struct Request
+        {
+            const Buffers *inputs;
+            Buffers *outputs;
+            std::promise<bool> done;
+            std::chrono::steady_clock::time_point arrival;
+        } Request;
+
+        std::unique_ptr<tflite::Interpreter> buildInterpreter(int batchSize);
+        bool runBatch(const std::vector<Request *> &requests);
+        void run();
+
+        std::shared_ptr<tflite::FlatBufferModel> m_model;
+        AccelerationPolicyManager m_apm;
+
+        std::vector<int> m_buckets;
+        std::vector<std::unique_ptr<tflite::Interpreter>> m_interpreters;    // one per bucket
+        std::vector<size_t> m_inputBytes;   // per request
+        std::vector<size_t> m_outputBytes;
+        std::shared_ptr<DelegationStats> m_stats;
+
+        std::mutex m_mutex;
+        std::condition_variable m_arrived;
+        std::deque<Request *> m_requests;
+        bool m_stopping;
+        uint64_t m_requestCount;
+        std::thread m_thread;
+    };
+} // end of namespace aif
+
+#endif
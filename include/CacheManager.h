@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef CACHEMANAGER_H_
+#define CACHEMANAGER_H_
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aif
+{
+    // Manages the delegate cache files in a directory (GPU serialization_dir or NNAPI cache_dir).
+    // Delegates write into a private staging copy, and only complete files are renamed into the
+    // directory, so a process that dies mid-write never leaves a torn entry behind. An index
+    // keeps the files, sizes, hashes and last use of every model token, so that corrupt files
+    // are dropped at startup and the least recently used tokens are evicted over a byte cap.
+    // The directory may be shared with other data: only the files of the index, staging
+    // directories and temporary index files are ever removed.
+    class CacheManager
+    {
+    public:
+        typedef struct File
+        {
+            std::string name;
+            long long bytes;
+            std::string hash;
+            long long mtime;        // nanoseconds since the epoch, 0 if it has to be hashed again
+        } File;
+
+        typedef struct Entry
+        {
+            std::vector<File> files;
+            long long last_use;     // seconds since the epoch
+        } Entry;
+
+        // maxBytes 0 means no cap
+        CacheManager(const std::string &dir, long long maxBytes);
+        // removes the staging directory and releases the lock
+        virtual ~CacheManager();
+
+        // Locks the directory against other processes and threads until destruction, loads the
+        // index, and validates every entry the first time this process opens the directory.
+        // Only files whose size or modification time changed since they were published are hashed.
+        bool open();
+
+        // Directory holding a copy of the files published for token, for a delegate to read and
+        // write. The returned string stays valid for the life of the process. nullptr on failure.
+        const char *stage(const std::string &token);
+        // Renames the new or changed files of the staging directory into place, marks token as
+        // used and evicts the least recently used tokens over the cap.
+        bool publish(const std::string &token);
+
+        bool hasEntry(const std::string &token) const;
+        int getEntryNum() const;
+        long long getTotalBytes() const;
+
+    private:
+        bool readIndex();
+        bool writeIndex();
+        void validate();
+        void evict(const std::string &keep);
+        void removeEntry(const std::string &token);
+
+        std::string m_dir;
+        long long m_maxBytes;
+        int m_lockFd;
+        const char *m_stagingDir;
+        std::string m_stagedToken;
+        std::map<std::string, Entry> m_entries;
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DELEGATECACHE_H_
+#define DELEGATECACHE_H_
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <tensorflow/lite/interpreter.h>
+
+namespace aif
+{
+    // Process-wide cache of delegate instances, keyed by the backend and the options the
+    // delegate was created with. Interpreters of a backend that can be shared (EdgeTPU, or a
+    // plugin whose manifest says so) get the same instance, so the library and the device
+    // context are set up once. Each pointer handed out holds a reference, and the delegate is
+    // destroyed when the last interpreter holding it is destroyed.
+    // GPU and NNAPI delegates keep the state of the one graph they were applied to, so every
+    // interpreter still gets its own instance of them, and that is reported once per key.
+    class DelegateCache
+    {
+    public:
+        typedef struct Counters
+        {
+            uint64_t created;       // instances created, shared or not
+            uint64_t reused;        // times a shared instance was handed out again
+            uint64_t unshared;      // instances created because the backend can not be shared
+        } Counters;
+
+        static DelegateCache& getInstance();
+
+        // Returns the delegate of key, or one made with create() if there is none or shareable
+        // is false. destroy() releases what create() made. Returns a null pointer if create() fails.
+        tflite::Interpreter::TfLiteDelegatePtr acquire(const std::string &key, bool shareable,
+                                                       const std::function<TfLiteDelegate *()> &create,
+                                                       void (*destroy)(TfLiteDelegate *));
+
+        // interpreters holding the shared delegate of key, 0 if there is none
+        int getRefCount(const std::string &key);
+        Counters getCounters();
+
+    private:
+        typedef struct Entry
+        {
+            TfLiteDelegate *delegate;
+            void (*destroy)(TfLiteDelegate *);
+            int refs;
+        } Entry;
+
+        DelegateCache() = default;
+        DelegateCache(const DelegateCache &) = delete;
+        DelegateCache& operator=(const DelegateCache &) = delete;
+
+        // deleter of the shared pointers
+        static void release(TfLiteDelegate *delegate);
+
+        std::mutex m_mutex;
+        std::map<std::string, Entry> m_entries;
+        std::map<TfLiteDelegate *, std::string> m_keys;
+        std::set<std::string> m_reportedKeys;   // unshareable keys already logged
+        Counters m_counters = {0, 0, 0};
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DELEGATEDECISIONCACHE_H_
+#define DELEGATEDECISIONCACHE_H_
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+
+namespace aif
+{
+    // On-disk store of delegate decisions, keyed by model content, device and policy.
+    // A stored decision lets AutoDelegateSelector skip the plan walk, the OpenCL probe
+    // and delegates that already failed on this device.
+    class DelegateDecisionCache
+    {
+    public:
+        typedef struct Decision
+        {
+            std::vector<std::string> backends;        // applied in this order
+            std::vector<std::string> failedBackends;
+            int gpuVendorIMG;                         // -1 if it was never probed
+            bool result;
+        } Decision;
+
+        DelegateDecisionCache(const std::string &path);
+        virtual ~DelegateDecisionCache();
+
+        static std::string makeKey(const tflite::FlatBufferModel &model, AccelerationPolicyManager &apm);
+        static std::string getDeviceFingerprint();
+
+        bool load();
+        bool save();
+
+        bool lookup(const std::string &key, Decision &decision);
+        void store(const std::string &key, Decision decision);
+        void erase(const std::string &key);
+
+    private:
+        bool read(std::map<std::string, Decision> &decisions);
+
+        std::string m_path;
+        std::map<std::string, Decision> m_decisions;
+        std::set<std::string> m_changedKeys;
+    };
+} // end of namespace aif
+
+#endif
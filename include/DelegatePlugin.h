@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DELEGATEPLUGIN_H_
+#define DELEGATEPLUGIN_H_
+
+#include <tensorflow/lite/c/common.h>
+
+/*
+ * C ABI of a delegate provider module, a shared library that DelegateRegistry dlopen()s the
+ * first time one of its delegates is needed. Each module comes with a JSON manifest in the
+ * plugin directory that declares what it can do, so that nothing is loaded to decide whether
+ * it applies:
+ *
+ *   {
+ *     "name" : "NPU",
+ *     "library" : "libaif-npu-delegate-plugin.so",   (absolute, or relative to the manifest)
+ *     "custom_ops" : [ "lgnpu_custom_op" ],          (the model is compiled for the provider)
+ *     "policies" : [ "MIN_LATENCY" ],                (the provider accelerates plain graphs)
+ *     "shareable" : false                            (one delegate may serve every interpreter)
+ *   }
+ *
+ * The module exports AIF_DELEGATE_PLUGIN_SYMBOL, which returns a static AifDelegatePlugin.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AIF_DELEGATE_PLUGIN_ABI_VERSION 1
+#define AIF_DELEGATE_PLUGIN_SYMBOL "aif_delegate_plugin_get"
+
+typedef struct AifDelegatePlugin
+{
+    int abi_version;    /* AIF_DELEGATE_PLUGIN_ABI_VERSION the module was built with */
+    const char *name;   /* must match the manifest */
+
+    /* options is the JSON object given for the plugin in "delegate_plugins", or "{}".
+       Returns NULL if the delegate can not be created on this device. */
+    TfLiteDelegate *(*create)(const char *options);
+    void (*destroy)(TfLiteDelegate *delegate);
+} AifDelegatePlugin;
+
+typedef const AifDelegatePlugin *(*AifDelegatePluginGetFunc)(void);
+
+const AifDelegatePlugin *aif_delegate_plugin_get(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
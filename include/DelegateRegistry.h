@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DELEGATEREGISTRY_H_
+#define DELEGATEREGISTRY_H_
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+
+#include "AccelerationPolicyManager.h"
+#include "DelegatePlugin.h"
+
+namespace aif
+{
+    // Process-wide registry of the delegate provider modules described in DelegatePlugin.h.
+    // The manifests of a directory are read the first time it is looked up, and a module is
+    // only dlopen()ed when a delegate is created from it, so a CPU-only process never maps a
+    // GPU or NPU driver stack. Loaded modules stay loaded until the process exits, because
+    // delegates created from them may outlive any owner the registry could track.
+    class DelegateRegistry
+    {
+    public:
+        typedef struct Manifest
+        {
+            std::string name;
+            std::string library;                    // resolved to an absolute path
+            std::vector<std::string> customOps;
+            std::vector<AccelerationPolicyManager::Policy> policies;
+            bool shareable = false;                 // one delegate can serve several interpreters
+        } Manifest;
+
+        static DelegateRegistry& getInstance();
+
+        // Reads the *.json manifests of dir, once. Invalid manifests and second manifests of
+        // a name are skipped. Returns false if dir can not be read.
+        bool scan(const std::string &dir);
+        static bool parseManifest(const std::string &json, const std::string &dir, Manifest &manifest);
+
+        // the first plugin of dir, in file name order, that declares customOp or serves policy
+        bool findByCustomOp(const std::string &dir, const std::string &customOp, Manifest &manifest);
+        bool findByPolicy(const std::string &dir, AccelerationPolicyManager::Policy policy, Manifest &manifest);
+        bool find(const std::string &dir, const std::string &name, Manifest &manifest);
+        std::vector<Manifest> getManifests(const std::string &dir);
+
+        // Loads the module of manifest if needed, and creates a delegate with options (a JSON
+        // object). The delegate is released through the module. A shareable plugin creates one
+        // delegate per options, which DelegateCache hands to every interpreter asking for it.
+        // Returns a null pointer if the module does not load or refuses to create the delegate.
+        tflite::Interpreter::TfLiteDelegatePtr createDelegate(const Manifest &manifest, const std::string &options = "{}");
+        bool isLoaded(const Manifest &manifest);
+
+    private:
+        DelegateRegistry() = default;
+        DelegateRegistry(const DelegateRegistry &) = delete;
+        DelegateRegistry& operator=(const DelegateRegistry &) = delete;
+
+        // with m_mutex held
+        const std::vector<Manifest>* scanLocked(const std::string &dir);
+        const AifDelegatePlugin* loadLocked(const Manifest &manifest);
+
+        std::mutex m_mutex;
+        std::map<std::string, std::vector<Manifest>> m_manifests;       // by directory
+        std::map<std::string, const AifDelegatePlugin *> m_plugins;     // loaded modules, by library
+    };
+} // end of namespace aif
+
+#endif
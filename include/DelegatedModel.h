@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DELEGATEDMODEL_H_
+#define DELEGATEDMODEL_H_
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+
+#include <tensorflow/lite/interpreter.h>
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+#include "DelegationStats.h"
+#include "FallbackController.h"
+
+namespace aif
+{
+    // Serves a model from a CPU interpreter right after init() while an interpreter with the
+    // delegate chosen by AutoDelegateSelector is prepared in the background. The accelerated
+    // interpreter replaces the CPU one at the next acquire(), never during a Session.
+    // With adaptive_fallback under LOAD_BALANCING or PYTORCH_MODEL_GPU, the invokes of the
+    // accelerated interpreter drive a FallbackController, and the interpreters it asks for are
+    // prepared and swapped in the same way.
+    // With GPU_DELEGATE_ONLY_GL the delegate can only be invoked from the thread that created it,
+    // so there is no background preparation: the first acquire() after init(), or after the
+    // controller asked for another interpreter, builds it on the calling thread and blocks. All
+    // sessions have to be acquired from that thread, and so does waitForAcceleration().
+    class DelegatedModel
+    {
+    public:
+        // Exclusive access to the interpreter that is serving now. Tensor pointers must not be
+        // kept across sessions because the interpreter may have been swapped in between.
+        class Session
+        {
+        public:
+            bool isValid() const;
+            bool isAccelerated() const;
+            tflite::Interpreter &interpreter();
+            // Invoke() with its latency recorded to the model's DelegationStats
+            TfLiteStatus invoke();
+
+            // Makes a caller-owned buffer the storage of input or output i (in the order of
+            // Interpreter::inputs() or outputs()), so that frames are neither copied in nor out.
+            // data must be aligned to kTensorAlignment and hold at least the bytes of the tensor.
+            // Binding again with the next frame's buffer costs no copy either. The tensor keeps
+            // pointing at the last buffer bound, also in later sessions, so a caller that binds
+            // has to bind before every invoke and keep the buffer alive until the invoke returns.
+            bool bindInput(int i, void *data, size_t bytes);
+            bool bindOutput(int i, void *data, size_t bytes);
+
+        private:
+            friend class DelegatedModel;
+            Session(std::unique_lock<std::mutex> lock, std::shared_ptr<tflite::Interpreter> interpreter, bool accelerated,
+                    DelegatedModel *owner);
+            bool bindTensor(int index, void *data, size_t bytes);
+
+            std::unique_lock<std::mutex> m_lock;
+            std::shared_ptr<tflite::Interpreter> m_interpreter;
+            bool m_accelerated;
+            DelegatedModel *m_owner;
+        };
+
+        // alignment SetCustomAllocationForTensor() requires, tflite::kDefaultTensorAlignment
+        static const size_t kTensorAlignment = 64;
+
+        DelegatedModel(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm);
+        // waits for the background preparation
+        virtual ~DelegatedModel();
+
+        bool init();
+        Session acquire();
+
+        bool isAccelerated();
+        // blocks until the background preparation ends, and returns whether it succeeded
+        bool waitForAcceleration();
+
+        // Delegation of the CPU interpreter and then of the accelerated one, and the invokes
+        // of whichever interpreter is serving. Safe to read from any thread.
+        std::shared_ptr<const DelegationStats> getStats();
+
+        // cpu_fallback_percentage of the serving interpreter, the configured one without adaptation
+        int getCPUFallbackPercentage();
+
+    private:
+        std::shared_ptr<tflite::Interpreter> buildInterpreter(AccelerationPolicyManager &apm);
+        void prepare(AccelerationPolicyManager apm);
+        void swapIfReady();
+        // called by Session with m_mutex held
+        void adapt(double latencyUs);
+
+        std::shared_ptr<tflite::FlatBufferModel> m_model;
+        AccelerationPolicyManager m_apm;
+
+        std::mutex m_mutex;
+        std::shared_ptr<tflite::Interpreter> m_interpreter;
+        std::shared_future<std::shared_ptr<tflite::Interpreter>> m_pending;
+        std::atomic<bool> m_accelerated;
+        std::shared_ptr<DelegationStats> m_stats;
+        std::unique_ptr<FallbackController> m_controller;
+        std::atomic<long long> m_preparationUs;
+    };
+} // end of namespace aif
+
+#endif
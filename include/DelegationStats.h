@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DELEGATIONSTATS_H_
+#define DELEGATIONSTATS_H_
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <tensorflow/lite/interpreter.h>
+
+namespace aif
+{
+    // Delegation and inference counters of one interpreter. Every getter and snapshot() is
+    // lock-free, so a monitoring thread can poll them while other threads invoke.
+    // recordDelegation() must not be called from two threads at once; the record* calls for
+    // invokes and fallbacks may come from any thread.
+    class DelegationStats
+    {
+    public:
+        // bucket 0 counts latencies below 2 us, bucket i [2^i, 2^(i+1)) us and the last one
+        // everything above
+        static const int kLatencyBucketNum = 32;
+
+        typedef struct Delegation
+        {
+            uint32_t backend_mask;          // 1 << AutoDelegateSelector::Backend of every applied backend
+            uint32_t failed_backend_mask;
+            int64_t delegation_us;
+            int node_num;                   // nodes in the execution plan before delegation
+            int cpu_node_num;               // nodes left on CPU after delegation
+            int partition_num;
+            int delegated_partition_num;
+            bool accelerated;               // a backend other than CPU and XNNPACK was applied
+            bool result;
+        } Delegation;
+
+        typedef struct Snapshot
+        {
+            uint64_t delegation_count;
+            Delegation delegation;          // of the last recordDelegation()
+            uint64_t fallback_count;
+            uint64_t invoke_count;
+            uint64_t failed_invoke_count;
+            uint64_t total_latency_us;
+            uint64_t max_latency_us;
+            std::array<uint64_t, kLatencyBucketNum> latency_histogram;
+
+            // upper bound of the bucket holding the given percentile, 0 without invokes
+            uint64_t getPercentileUs(double percentile) const;
+        } Snapshot;
+
+        DelegationStats();
+        virtual ~DelegationStats() = default;
+        DelegationStats(const DelegationStats &) = delete;
+        DelegationStats &operator=(const DelegationStats &) = delete;
+
+        void recordDelegation(const Delegation &delegation);
+        void recordFallback();
+        void recordInvoke(uint64_t latencyUs, bool success);
+        // runs Invoke() and records its latency
+        TfLiteStatus invoke(tflite::Interpreter &interpreter);
+
+        Snapshot snapshot() const;
+        bool isAccelerated() const;
+        uint64_t getInvokeCount() const;
+        uint64_t getFallbackCount() const;
+
+        static int getLatencyBucket(uint64_t latencyUs);
+        static uint64_t getLatencyBucketUpperUs(int bucket);
+
+    private:
+        Delegation readDelegation() const;
+
+        // Delegation fields are guarded by a sequence counter, so readers retry instead of
+        // seeing half of an update.
+        std::atomic<uint32_t> m_sequence;
+        std::atomic<uint64_t> m_delegationCount;
+        std::atomic<uint32_t> m_backendMask;
+        std::atomic<uint32_t> m_failedBackendMask;
+        std::atomic<int64_t> m_delegationUs;
+        std::atomic<int> m_nodeNum;
+        std::atomic<int> m_cpuNodeNum;
+        std::atomic<int> m_partitionNum;
+        std::atomic<int> m_delegatedPartitionNum;
+        std::atomic<bool> m_accelerated;
+        std::atomic<bool> m_result;
+
+        std::atomic<uint64_t> m_fallbackCount;
+        std::atomic<uint64_t> m_invokeCount;
+        std::atomic<uint64_t> m_failedInvokeCount;
+        std::atomic<uint64_t> m_totalLatencyUs;
+        std::atomic<uint64_t> m_maxLatencyUs;
+        std::array<std::atomic<uint64_t>, kLatencyBucketNum> m_latencyHistogram;
+    };
+} // end of namespace aif
+
+#endif
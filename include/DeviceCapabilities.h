@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef DEVICECAPABILITIES_H_
+#define DEVICECAPABILITIES_H_
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aif
+{
+    // What the device can run delegates on, probed once per process when it is first asked for.
+    // Probing the GPU initializes the OpenCL driver, so the result is also kept in a file and
+    // reused by later processes as long as the device fingerprint, which is cheap to compute,
+    // does not change. The CPU queries only read sysfs and /proc, and leave the accelerators
+    // unprobed until something asks for them.
+    class DeviceCapabilities
+    {
+    public:
+        typedef struct CpuCluster
+        {
+            long maxFrequency;      // kHz, 0 if cpufreq is not available
+            int coreNum;
+        } CpuCluster;
+
+        typedef struct Capabilities
+        {
+            std::string fingerprint;                // kernel, CPU, board and driver libraries, hashed
+            std::string cpuArch;
+            std::vector<std::string> cpuFeatures;   // as /proc/cpuinfo lists them
+            int cpuCoreNum;
+            std::vector<CpuCluster> cpuClusters;    // from the slowest to the fastest one
+            std::string gpuVendor;                  // the GPU fields are empty without OpenCL
+            std::string gpuName;
+            std::string gpuDriverVersion;
+            std::string openCLVersion;
+            bool hasNPU;
+            bool hasEdgeTPU;
+        } Capabilities;
+
+        // Where the capabilities come from. getFingerprint() and probeCpu() must be cheap,
+        // the former decides whether the stored capabilities still describe the device.
+        // probeAccelerators() fills the GPU, NPU and EdgeTPU fields and may initialize drivers.
+        class Prober
+        {
+        public:
+            virtual ~Prober() = default;
+            virtual std::string getFingerprint() = 0;
+            virtual bool probeCpu(Capabilities &capabilities) = 0;
+            virtual bool probeAccelerators(Capabilities &capabilities) = 0;
+        };
+
+        static DeviceCapabilities& getInstance();
+
+        // Replaces the prober, nullptr for the one that reads the system, and the file the
+        // capabilities are kept in, empty for none. What was probed before is forgotten.
+        void configure(std::unique_ptr<Prober> prober, const std::string &cachePath);
+        static std::string getDefaultCachePath();
+
+        // probes the accelerators as well
+        Capabilities get();
+        std::string getFingerprint();
+        bool isGpuVendorIMG();
+
+        // do not probe the accelerators
+        bool hasCpuFeature(const std::string &feature);
+        int getCpuCoreNum();
+        // every core except the slowest cluster, or all of them on a uniform CPU
+        int getBigCoreNum();
+        int getLittleCoreNum();
+
+        static bool parse(const std::string &json, Capabilities &capabilities);
+        static std::string serialize(const Capabilities &capabilities);
+
+    private:
+        DeviceCapabilities();
+        DeviceCapabilities(const DeviceCapabilities &) = delete;
+        DeviceCapabilities& operator=(const DeviceCapabilities &) = delete;
+
+        // with m_mutex held
+        const Capabilities& getLocked();
+        const Capabilities& getCpuLocked();
+        const std::string& getFingerprintLocked();
+        bool loadLocked(const std::string &fingerprint);
+        void saveLocked();
+
+        std::mutex m_mutex;
+        std::unique_ptr<Prober> m_prober;
+        std::string m_cachePath;
+        std::string m_fingerprint;
+        bool m_cpuProbed = false;
+        bool m_cpuValid = false;
+        bool m_probed = false;
+        Capabilities m_capabilities;
+    };
+} // end of namespace aif
+
+#endif
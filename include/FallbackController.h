@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef FALLBACKCONTROLLER_H_
+#define FALLBACKCONTROLLER_H_
+#include <vector>
+
+#include "AccelerationPolicyManager.h"
+
+namespace aif
+{
+    // Hill climbing on the GPU cpu_fallback_percentage. The median latency of a window of
+    // invokes is taken for each percentage. The controller keeps moving in one direction while
+    // latency improves by more than the hysteresis, and turns around with half the step when
+    // it does not, until the step reaches zero. After converging it keeps watching, and starts
+    // over when latency drifts away, e.g. because CPU or GPU contention changed.
+    // Re-delegations are only asked for while the time spent on them stays within the budget
+    // share of the serving time. It does no delegation itself, so it can be driven by a
+    // simulated latency model.
+    class FallbackController
+    {
+    public:
+        FallbackController(int percentage, AccelerationPolicyManager::AdaptiveFallback options);
+        virtual ~FallbackController() = default;
+
+        // Latency of an invoke at the current percentage. Returns true when the caller should
+        // re-delegate with getPercentage() and then call onRedelegated().
+        bool onInvoke(double latencyUs);
+        // applied is false if the re-delegation failed and the old percentage keeps serving
+        void onRedelegated(double costUs, bool applied);
+
+        // the percentage to delegate with after onInvoke() returned true, the serving one otherwise
+        int getPercentage() const;
+        int getServingPercentage() const;
+        bool isConverged() const;
+        int getRedelegationCount() const;
+
+    private:
+        void measured(double latencyUs);
+        void turnAround();
+        void propose(int percentage);
+        bool isWithinBudget() const;
+
+        AccelerationPolicyManager::AdaptiveFallback m_options;
+        int m_serving;
+        int m_candidate;
+        int m_pending;              // -1 if nothing waits for the budget
+        bool m_waiting;             // for onRedelegated()
+
+        std::vector<double> m_samples;
+        bool m_hasBest;
+        int m_bestPercentage;
+        double m_bestLatencyUs;
+        int m_direction;
+        int m_step;
+        bool m_converged;
+
+        double m_servingUs;
+        double m_redelegationUs;
+        int m_redelegationCount;
+    };
+} // end of namespace aif
+
+#endif
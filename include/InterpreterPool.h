@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef INTERPRETERPOOL_H_
+#define INTERPRETERPOOL_H_
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+#include "DelegationStats.h"
+
+namespace aif
+{
+    // Interpreters built from one FlatBufferModel and delegated with the same decision, so that
+    // several threads can run the model at once. Checkout and return are lock-free while an
+    // interpreter is free. acquire() sleeps until one is returned otherwise.
+    // The interpreters are delegated by init() and leased to any thread, so a GPU delegate
+    // built with GPU_DELEGATE_ONLY_GL, which only runs on the thread that created it, makes
+    // init() fail.
+    class InterpreterPool
+    {
+    public:
+        // Exclusive use of one interpreter until the lease is destroyed.
+        class Lease
+        {
+        public:
+            Lease();
+            Lease(Lease &&other);
+            Lease &operator=(Lease &&other);
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+            ~Lease();
+
+            bool isValid() const;
+            tflite::Interpreter &interpreter();
+            // Invoke() with its latency recorded to the DelegationStats of this interpreter
+            TfLiteStatus invoke();
+            void release();
+
+        private:
+            friend class InterpreterPool;
+            Lease(InterpreterPool *pool, int slot);
+
+            InterpreterPool *m_pool;
+            int m_slot;
+        };
+
+        InterpreterPool(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm);
+        virtual ~InterpreterPool();
+
+        bool init();
+
+        // returns an invalid lease if every interpreter is in use
+        Lease tryAcquire();
+        // waits until an interpreter is returned
+        Lease acquire();
+
+        int size() const;
+        int getAvailableNum() const;
+        // nullptr if index is out of range
+        std::shared_ptr<const DelegationStats> getStats(int index) const;
+
+    private:
+        int getAutoPoolSize();
+        void release(int slot);
+
+        std::shared_ptr<tflite::FlatBufferModel> m_model;
+        AccelerationPolicyManager m_apm;
+
+        std::vector<std::unique_ptr<tflite::Interpreter>> m_interpreters;
+        std::vector<std::shared_ptr<DelegationStats>> m_stats;
+        std::unique_ptr<std::atomic<bool>[]> m_busy;
+        std::atomic<unsigned int> m_next;
+        // acquire() calls sleeping until release() wakes them up
+        std::mutex m_waitMutex;
+        std::condition_variable m_released;
+        std::atomic<int> m_waiters;
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef MODELLOADER_H_
+#define MODELLOADER_H_
+#include <memory>
+#include <string>
+
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+
+namespace aif
+{
+    // Loads .tflite files through a read-only shared mapping. Loading a file that is already
+    // loaded in this process returns the same FlatBufferModel, and other processes mapping the
+    // same file share its page cache pages, so the weights are resident only once.
+    class ModelLoader
+    {
+    public:
+        // nullptr if the file can not be mapped or is not a valid model
+        static std::shared_ptr<tflite::FlatBufferModel> load(const std::string &path, AccelerationPolicyManager &apm);
+        static std::shared_ptr<tflite::FlatBufferModel> load(const std::string &path,
+                                                             const AccelerationPolicyManager::ModelLoading &options);
+
+        // number of files mapped by load() that are still in use
+        static int getLoadedNum();
+
+    private:
+        ModelLoader() = delete;
+    };
+} // end of namespace aif
+
+#endif
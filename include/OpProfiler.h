@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef OPPROFILER_H_
+#define OPPROFILER_H_
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tensorflow/lite/core/api/profiler.h>
+#include <tensorflow/lite/interpreter.h>
+
+namespace aif
+{
+    // Aggregates the operator events of an interpreter over many invokes. Every node of the
+    // execution plan, including the DELEGATE nodes that stand for a delegated partition, gets
+    // one entry, so the report shows which CPU fallback ops take the time after delegation.
+    // AutoDelegateSelector attaches one when the policy has "profiling" set.
+    class OpProfiler : public tflite::Profiler
+    {
+    public:
+        typedef struct OpStat
+        {
+            int subgraph_index;
+            int node_index;
+            std::string op_name;        // EnumNameBuiltinOperator(), or the custom op name
+            std::string delegate_name;  // the delegate kernel name for a DELEGATE node
+            int partition;              // delegated partition in plan order, -1 on CPU
+            int64_t count;
+            int64_t total_us;
+            int64_t min_us;
+            int64_t max_us;
+        } OpStat;
+
+        OpProfiler(tflite::Interpreter &interpreter, const std::string &reportPath = "");
+        // writes the report if a path was given
+        virtual ~OpProfiler();
+
+        uint32_t BeginEvent(const char *tag, EventType event_type, int64_t event_metadata1, int64_t event_metadata2) override;
+        void EndEvent(uint32_t event_handle) override;
+        using tflite::Profiler::EndEvent;
+
+        int64_t getInvokeCount();
+        int64_t getInvokeTotalUs();
+        // sorted by total time, the largest first
+        std::vector<OpStat> getHotspots();
+        std::string getReport();
+        bool writeReport(const std::string &path);
+        void reset();
+
+    private:
+        typedef std::pair<int, int> OpKey;  // subgraph, node
+        typedef struct Event
+        {
+            std::chrono::steady_clock::time_point start;
+            EventType type;
+            const char *tag;
+            int64_t metadata1;
+            int64_t metadata2;
+        } Event;
+
+        OpStat &getOpStat(const OpKey &key, const char *tag);
+
+        tflite::Interpreter &m_interpreter;
+        std::string m_reportPath;
+        std::mutex m_mutex;
+        std::vector<Event> m_events;
+        std::vector<uint32_t> m_freeEvents;
+        std::map<OpKey, OpStat> m_stats;
+        int m_invokeDepth = 0;
+        int64_t m_invokeCount = 0;
+        int64_t m_invokeTotalUs = 0;
+    };
+} // end of namespace aif
+#endif
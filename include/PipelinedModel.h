@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PIPELINEDMODEL_H_
+#define PIPELINEDMODEL_H_
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+#include "DelegationStats.h"
+#include "tools/BoundedQueue.h"
+
+namespace aif
+{
+    // Runs a stream of frames through the delegated execution plan split at partition
+    // boundaries. Every stage has its own thread and interpreter executing only the nodes of
+    // its stage, and bounded queues connect the stages. While the accelerator runs the
+    // delegated partition of frame N, the CPU can run the CPU partition of frame N+1, so
+    // throughput follows the slowest stage rather than the sum of them. Latency of a single
+    // frame does not improve.
+    // Stages of CPU nodes only get an interpreter without delegates. Every stage with a
+    // delegate node is delegated with the whole decision, so each one prepares the delegate
+    // for the entire graph; max_stages also bounds how many times that happens.
+    // The interpreters are delegated by init() and invoked on the stage threads, so a GPU
+    // delegate built with GPU_DELEGATE_ONLY_GL, which only runs on the thread that created it,
+    // makes init() fail.
+    class PipelinedModel
+    {
+    public:
+        // one buffer per tensor, in the order of Interpreter::inputs() or outputs()
+        typedef std::vector<std::vector<uint8_t>> Buffers;
+
+        typedef struct Stage
+        {
+            int begin;      // position in the execution plan
+            int end;        // one past the last position
+            bool delegated;
+            std::vector<int> input_tensors;     // produced by earlier stages or fed by push()
+            std::vector<int> output_tensors;    // read by later stages or pop()
+        } Stage;
+
+        PipelinedModel(std::shared_ptr<tflite::FlatBufferModel> model, AccelerationPolicyManager apm);
+        // aborts the frames in flight and joins the stage threads
+        virtual ~PipelinedModel();
+
+        bool init();
+
+        // Queues one frame. Blocks while the first stage has queue_size frames waiting. Returns
+        // false after stop() or if a buffer does not match the size of its input tensor.
+        bool push(const Buffers &inputs);
+        // Blocks for the outputs of the oldest frame. outputs is empty if the frame failed.
+        // Returns false once stop() was called and every frame pushed before has been popped.
+        bool pop(Buffers &outputs);
+        // refuses further frames and lets the queued ones finish
+        void stop();
+
+        int getStageNum() const;
+        const std::vector<Stage>& getStages() const;
+        // Invokes of one stage. nullptr if stage is out of range.
+        std::shared_ptr<const DelegationStats> getStats(int stage) const;
+
+        // Splits the execution plan into partitions, one per delegate node and one per run of
+        // CPU nodes, and merges neighbouring partitions into at most maxStages stages (0: no
+        // limit). delegated has one entry per position in the execution plan.
+        static std::vector<Stage> split(const std::vector<bool> &delegated, int maxStages);
+        static std::vector<Stage> split(const tflite::Subgraph &subgraph, int maxStages);
+
+    private:
+        typedef struct Frame
+        {
+            bool ok;
+            std::map<int, std::vector<uint8_t>> tensors;    // by tensor index
+        } Frame;
+        typedef BoundedQueue<std::unique_ptr<Frame>> FrameQueue;
+
+        bool findStageTensors(tflite::Interpreter &interpreter);
+        std::unique_ptr<tflite::Interpreter> buildCPUStage(int stage, const std::vector<int> &stagePlan, tflite::Interpreter &reference);
+        void run(int stage);
+
+        std::shared_ptr<tflite::FlatBufferModel> m_model;
+        AccelerationPolicyManager m_apm;
+
+        std::vector<Stage> m_stages;
+        std::vector<std::unique_ptr<tflite::Interpreter>> m_interpreters;
+        std::vector<size_t> m_inputBytes;
+        // memory of the tensors carried into CPU stages, see buildCPUStage()
+        std::vector<std::vector<uint8_t>> m_carriedBuffers;
+        std::vector<std::shared_ptr<DelegationStats>> m_stats;
+        // m_queues[i] feeds stage i, and the last one feeds pop()
+        std::vector<std::unique_ptr<FrameQueue>> m_queues;
+        std::vector<std::thread> m_threads;
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef POLICYMANIFEST_H_
+#define POLICYMANIFEST_H_
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tensorflow/lite/model.h>
+
+#include "AccelerationPolicyManager.h"
+
+namespace aif
+{
+    // The AccelerationPolicyManager configs of all the models of a service, in one document:
+    //
+    //   {
+    //     "defaults" : { "policy" : "MIN_LATENCY", "xnnpack" : { "num_threads" : 2 } },
+    //     "models" : {
+    //       "face_detection" : { "model_hash" : "3f2a...", "xnnpack" : { "force_fp16" : true } },
+    //       "pose_estimation" : { "policy" : "LOAD_BALANCING", "cpu_fallback_percentage" : 20 }
+    //     }
+    //   }
+    //
+    // Each model entry is merged over the defaults, objects key by key, and turned into an
+    // AccelerationPolicyManager when the manifest is constructed. The manifest does not change
+    // afterwards, so lookups are map lookups without parsing and may be done from any thread.
+    // Entries that fail AccelerationPolicyManager::validate() are left out and reported.
+    class PolicyManifest
+    {
+    public:
+        PolicyManifest(const std::string &json);
+        virtual ~PolicyManifest();
+
+        // false if anything was left out, see getErrors()
+        bool isValid() const;
+        const std::vector<std::string>& getErrors() const;
+
+        // the merged config of the model, by its name or by hashModel() of its file
+        bool find(const std::string &name, AccelerationPolicyManager &apm) const;
+        bool findByHash(const std::string &modelHash, AccelerationPolicyManager &apm) const;
+        bool findByModel(const tflite::FlatBufferModel &model, AccelerationPolicyManager &apm) const;
+        AccelerationPolicyManager getDefaults() const;
+        std::vector<std::string> getModelNames() const;     // sorted
+
+        static std::string hashModel(const tflite::FlatBufferModel &model);
+
+    private:
+        void addError(const std::string &error);
+
+        AccelerationPolicyManager m_defaults;
+        std::unordered_map<std::string, AccelerationPolicyManager> m_models;    // by name
+        std::unordered_map<std::string, std::string> m_names;                   // by model_hash
+        std::vector<std::string> m_errors;
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PREPROCESSOR_H_
+#define PREPROCESSOR_H_
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+
+namespace aif
+{
+    // Converts interleaved uint8 frames (e.g. RGB) straight into an input tensor, in one pass
+    // instead of a per-element loop through typed_input_tensor<T>(). Every channel is normalized
+    // as (pixel - mean) / stddev and then stored as the tensor type: float32, float16, or int8 and
+    // uint8 requantized with the tensor's scale and zero point. The tensor may be NHWC or NCHW.
+    // Kernels are picked for the CPU at runtime: AVX2 (with F16C) or SSE2 on x86-64, NEON on
+    // AArch64, and a scalar reference everywhere else.
+    class Preprocessor
+    {
+    public:
+        enum Layout
+        {
+            kLayoutHWC = 0,     // tensor is [1, H, W, C] like the frame
+            kLayoutCHW,         // tensor is [1, C, H, W], e.g. models converted from PyTorch
+        };
+
+        enum Isa
+        {
+            kIsaScalar = 0,
+            kIsaSSE2,
+            kIsaAVX2,
+            kIsaNEON,
+        };
+
+        typedef struct Options
+        {
+            std::vector<float> mean;    // one per channel or one for all, none means 0
+            std::vector<float> stddev;  // one per channel or one for all, none means 1
+            Layout layout;
+        } Options;
+
+        static const int kMaxChannels = 4;
+
+        explicit Preprocessor(Options options);
+        virtual ~Preprocessor() = default;
+
+        // Checks that tensor is [1, H, W, C] (or [1, C, H, W]) of a supported type, and fills it.
+        bool fill(const uint8_t *frame, int height, int width, int channels, TfLiteTensor &tensor);
+        bool fill(const uint8_t *frame, int height, int width, int channels, tflite::Interpreter &interpreter, int input = 0);
+
+        // The same into any buffer of bytes, which must be exactly height * width * channels
+        // elements of type.
+        bool convert(const uint8_t *frame, int height, int width, int channels, TfLiteType type,
+                     const TfLiteQuantizationParams &quantization, void *dst, size_t bytes);
+
+        // the best kernels this CPU runs
+        static Isa getBestIsa();
+        // forces other kernels, e.g. the scalar reference. Isas the CPU lacks fall back to scalar.
+        void setIsa(Isa isa);
+        Isa getIsa() const;
+
+    private:
+        Options m_options;
+        Isa m_isa;
+        std::vector<uint8_t> m_plane;   // one channel of the frame, for kLayoutCHW
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef XNNPACKDELEGATEOPTIONS_H_
+#define XNNPACKDELEGATEOPTIONS_H_
+// Not installed, shared by the library and its tests only.
+#ifdef USE_XNNPACK
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+
+#include "AccelerationPolicyManager.h"
+
+namespace aif
+{
+    // The options an XNNPACK delegate is created with under apm. defaultNumThreads is used
+    // unless the xnnpack options set num_threads. force_fp16 is dropped under kMaximumPrecision.
+    TfLiteXNNPackDelegateOptions makeXnnpackDelegateOptions(AccelerationPolicyManager &apm, int defaultNumThreads);
+} // end of namespace aif
+#endif
+
+#endif
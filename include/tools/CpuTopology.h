@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef CPUTOPOLOGY_H_
+#define CPUTOPOLOGY_H_
+
+#include <string>
+#include <vector>
+
+namespace aif
+{
+    // Online cores grouped into clusters by their maximum frequency, read from sysfs.
+    class CpuTopology
+    {
+    public:
+        typedef struct Cluster
+        {
+            long max_frequency;     // kHz, 0 if cpufreq is not available
+            std::vector<int> cpus;
+        } Cluster;
+
+        CpuTopology(const std::string &sysfsRoot = "/sys/devices/system/cpu");
+        virtual ~CpuTopology();
+
+        int getOnlineCoreNum() const;
+        // clusters are sorted from the slowest to the fastest one
+        const std::vector<Cluster>& getClusters() const;
+        // every core except the slowest cluster, or all of them on a uniform CPU
+        int getBigCoreNum() const;
+        int getLittleCoreNum() const;
+
+        static bool parseCpuList(const std::string &list, std::vector<int> &cpus);
+
+    private:
+        std::vector<int> m_onlineCpus;
+        std::vector<Cluster> m_clusters;
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aif
+{
+    // 64-bit XXH64 compatible hash. It is not meant to be cryptographically secure.
+    uint64_t hash64(const void *data, size_t size, uint64_t seed = 0);
+
+    // The same hash over data given in pieces, e.g. a mapped model followed by options,
+    // without copying them into one buffer.
+    class Hash64
+    {
+    public:
+        explicit Hash64(uint64_t seed = 0);
+
+        void update(const void *data, size_t size);
+        void update(const std::string &data);
+        uint64_t digest() const;
+
+    private:
+        uint64_t m_v1;
+        uint64_t m_v2;
+        uint64_t m_v3;
+        uint64_t m_v4;
+        uint64_t m_seed;
+        uint64_t m_totalSize;
+        uint8_t m_buffer[32];
+        size_t m_bufferSize;
+    };
+
+    std::string hashToString(uint64_t hash);
+} // end of namespace aif
+
+#endif
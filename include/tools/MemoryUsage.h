@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef MEMORYUSAGE_H_
+#define MEMORYUSAGE_H_
+
+#include <cstddef>
+#include <string>
+
+#include <tensorflow/lite/interpreter.h>
+
+namespace aif
+{
+    // Memory accounting for interpreters. None of the delegates report their own allocations,
+    // so what they take on the CPU side only shows up in the resident set size.
+    class MemoryUsage
+    {
+    public:
+        typedef struct TensorMemory
+        {
+            // Sum over the arena tensors. The arena reuses memory between tensors whose lifetimes
+            // do not overlap, so this is an upper bound of the planned arena size.
+            size_t arena_bytes;
+            size_t persistent_bytes;    // kTfLiteArenaRwPersistent and kTfLitePersistentRo
+            size_t dynamic_bytes;
+            size_t read_only_bytes;     // weights mapped from the model
+        } TensorMemory;
+
+        typedef struct Footprint
+        {
+            TensorMemory tensors;
+            long rss_delta_bytes;       // across delegation and AllocateTensors, -1 if unknown
+        } Footprint;
+
+        // -1 if statm could not be read
+        static long getResidentBytes(const std::string &statmPath = "/proc/self/statm");
+        // only the tensors with memory assigned, so call it after AllocateTensors()
+        static TensorMemory getTensorMemory(const tflite::Interpreter &interpreter);
+        // Memory the interpreter adds to the process: the RSS growth, or the writable tensor
+        // memory if that is larger because freed memory was reused.
+        static size_t getCost(const Footprint &footprint);
+    };
+} // end of namespace aif
+
+#endif
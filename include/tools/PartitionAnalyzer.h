@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef PARTITIONANALYZER_H_
+#define PARTITIONANALYZER_H_
+
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+
+namespace aif
+{
+    // Predicts how a delegate would split the execution plan before ModifyGraphWithDelegate()
+    // is called, from a table of the builtin ops each delegate accepts. The tables only look
+    // at the op type, so a node the delegate later rejects for its parameters is still counted.
+    class PartitionAnalyzer
+    {
+    public:
+        enum Target
+        {
+            kTargetGPU = 0,
+            kTargetNNAPI,
+        };
+
+        enum NodeClass
+        {
+            kNodeCPU = 0,           // the delegate does not support it
+            kNodeSupported,         // the delegate would take it
+            kNodeDelegated,         // an earlier delegate already took it
+        };
+
+        typedef struct Prediction
+        {
+            int node_num;               // nodes still running on CPU before this delegate
+            int supported_node_num;
+            int partition_num;          // before max_delegated_partitions is applied
+            int delegated_partition_num;
+            int delegated_node_num;     // after max_delegated_partitions is applied
+            double delegated_node_ratio;
+        } Prediction;
+
+        static bool isSupported(Target target, const TfLiteRegistration &registration);
+        static std::vector<NodeClass> classify(const tflite::Subgraph &subgraph, Target target);
+        // maxPartitions 0 means every partition is delegated. Otherwise the largest ones are
+        // kept, the way the delegates themselves cap partitions.
+        static Prediction predict(const std::vector<NodeClass> &nodes, int maxPartitions);
+        static Prediction predict(const tflite::Subgraph &subgraph, Target target, int maxPartitions);
+    };
+} // end of namespace aif
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measures every stage of bringing up a model with each acceleration policy and prints
+ * the result as JSON, along with the memory taken by delegation and AllocateTensors().
+ *
+ * usage: auto_delegation_benchmark [--iterations N] [--warmup N] [--policy POLICY]...
+ *                                  [--output FILE] [MODEL]...
+ */
+
+#include <AutoDelegateSelector.h>
+#include <ModelLoader.h>
+#include <tools/MemoryUsage.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+
+using namespace aif;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const char *kPolicies[] = {
+        "CPU_ONLY",
+        "MAX_PRECISION",
+        "MIN_LATENCY",
+        "LOAD_BALANCING",
+        "PYTORCH_MODEL_GPU",
+        "MIN_RES",
+        "MIN_LATENCY_MIN_RES",
+        "AUTO_TUNE",
+    };
+
+    typedef struct Options
+    {
+        int iterations;
+        int warmup;
+        std::vector<std::string> policies;
+        std::vector<std::string> models;
+        std::string output;
+    } Options;
+
+    typedef struct Result
+    {
+        std::string model;
+        std::string policy;
+        bool success;
+        std::string error;
+        std::vector<std::string> backends;
+        double load_ms;
+        double build_interpreter_ms;
+        double select_delegate_ms;
+        double allocate_tensors_ms;
+        double first_invoke_ms;
+        double mean_ms;
+        double p50_ms;
+        double p90_ms;
+        double p99_ms;
+        long rss_delta_bytes;
+        MemoryUsage::TensorMemory tensor_memory;
+    } Result;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // nearest-rank percentile of sorted values
+    double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+        rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+        return sorted[rank - 1];
+    }
+
+    void fillInputs(tflite::Interpreter &interpreter)
+    {
+        for (int index : interpreter.inputs())
+        {
+            TfLiteTensor *tensor = interpreter.tensor(index);
+            if (tensor != nullptr && tensor->data.raw != nullptr)
+                memset(tensor->data.raw, 0, tensor->bytes);
+        }
+    }
+
+    Result runBenchmark(const std::string &modelPath, const std::string &policy, const Options &options)
+    {
+        Result result = {modelPath, policy, false, "", {}, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, -1, {0, 0, 0, 0}};
+
+        AccelerationPolicyManager apm("{ \"policy\" : \"" + policy + "\" }");
+
+        auto start = Clock::now();
+        std::shared_ptr<tflite::FlatBufferModel> model = ModelLoader::load(modelPath, apm);
+        result.load_ms = elapsedMs(start);
+        if (model == nullptr)
+        {
+            result.error = "failed to load the model";
+            return result;
+        }
+
+        start = Clock::now();
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        if (tflite::InterpreterBuilder(*model, resolver)(&interpreter) != kTfLiteOk || interpreter == nullptr)
+        {
+            result.error = "failed to build the interpreter";
+            return result;
+        }
+        result.build_interpreter_ms = elapsedMs(start);
+
+        AutoDelegateSelector ads;
+        long rssBefore = MemoryUsage::getResidentBytes();
+        start = Clock::now();
+        if (!ads.selectDelegate(*interpreter, apm, *model))
+        {
+            result.error = "selectDelegate failed";
+            return result;
+        }
+        result.select_delegate_ms = elapsedMs(start);
+        result.backends = ads.getLastDecision().backends;
+
+        start = Clock::now();
+        if (interpreter->AllocateTensors() != kTfLiteOk)
+        {
+            result.error = "AllocateTensors failed";
+            return result;
+        }
+        result.allocate_tensors_ms = elapsedMs(start);
+        long rssAfter = MemoryUsage::getResidentBytes();
+        result.rss_delta_bytes = (rssBefore < 0 || rssAfter < 0) ? -1 : rssAfter - rssBefore;
+        result.tensor_memory = MemoryUsage::getTensorMemory(*interpreter);
+        fillInputs(*interpreter);
+
+        start = Clock::now();
+        if (interpreter->Invoke() != kTfLiteOk)
+        {
+            result.error = "first Invoke failed";
+            return result;
+        }
+        result.first_invoke_ms = elapsedMs(start);
+
+        for (int i = 0; i < options.warmup; i++)
+        {
+            if (interpreter->Invoke() != kTfLiteOk)
+            {
+                result.error = "Invoke failed";
+                return result;
+            }
+        }
+
+        std::vector<double> latencies;
+        latencies.reserve(options.iterations);
+        for (int i = 0; i < options.iterations; i++)
+        {
+            start = Clock::now();
+            if (interpreter->Invoke() != kTfLiteOk)
+            {
+                result.error = "Invoke failed";
+                return result;
+            }
+            latencies.push_back(elapsedMs(start));
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0.0;
+        for (double latency : latencies)
+            sum += latency;
+        result.mean_ms = latencies.empty() ? 0.0 : sum / latencies.size();
+        result.p50_ms = percentile(latencies, 50.0);
+        result.p90_ms = percentile(latencies, 90.0);
+        result.p99_ms = percentile(latencies, 99.0);
+        result.success = true;
+        return result;
+    }
+
+    std::string toJson(const Options &options, const std::vector<Result> &results)
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+        writer.StartObject();
+        writer.Key("iterations");
+        writer.Int(options.iterations);
+        writer.Key("warmup");
+        writer.Int(options.warmup);
+        writer.Key("results");
+        writer.StartArray();
+        for (const auto &result : results)
+        {
+            writer.StartObject();
+            writer.Key("model");
+            writer.String(result.model.c_str());
+            writer.Key("policy");
+            writer.String(result.policy.c_str());
+            writer.Key("success");
+            writer.Bool(result.success);
+            if (!result.success)
+            {
+                writer.Key("error");
+                writer.String(result.error.c_str());
+            }
+            writer.Key("backends");
+            writer.StartArray();
+            for (const auto &backend : result.backends)
+                writer.String(backend.c_str());
+            writer.EndArray();
+
+            const std::pair<const char *, double> timings[] = {
+                {"load_ms", result.load_ms},
+                {"build_interpreter_ms", result.build_interpreter_ms},
+                {"select_delegate_ms", result.select_delegate_ms},
+                {"allocate_tensors_ms", result.allocate_tensors_ms},
+                {"first_invoke_ms", result.first_invoke_ms},
+                {"mean_ms", result.mean_ms},
+                {"p50_ms", result.p50_ms},
+                {"p90_ms", result.p90_ms},
+                {"p99_ms", result.p99_ms},
+            };
+            for (const auto &timing : timings)
+            {
+                writer.Key(timing.first);
+                writer.Double(timing.second);
+            }
+
+            const std::pair<const char *, int64_t> memory[] = {
+                {"rss_delta_bytes", result.rss_delta_bytes},
+                {"arena_bytes", static_cast<int64_t>(result.tensor_memory.arena_bytes)},
+                {"persistent_bytes", static_cast<int64_t>(result.tensor_memory.persistent_bytes)},
+                {"dynamic_bytes", static_cast<int64_t>(result.tensor_memory.dynamic_bytes)},
+                {"read_only_bytes", static_cast<int64_t>(result.tensor_memory.read_only_bytes)},
+            };
+            for (const auto &entry : memory)
+            {
+                writer.Key(entry.first);
+                writer.Int64(entry.second);
+            }
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+
+        return std::string(buffer.GetString(), buffer.GetSize()) + "\n";
+    }
+
+    void printUsage(const char *name)
+    {
+        std::cerr << "usage: " << name << " [--iterations N] [--warmup N] [--policy POLICY]... [--output FILE] [MODEL]..." << std::endl;
+        std::cerr << "policies:";
+        for (const char *policy : kPolicies)
+            std::cerr << " " << policy;
+        std::cerr << std::endl;
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool hasValue = (i + 1 < argc);
+            if (arg == "--iterations" && hasValue)
+            {
+                options.iterations = std::max(1, atoi(argv[++i]));
+            }
+            else if (arg == "--warmup" && hasValue)
+            {
+                options.warmup = std::max(0, atoi(argv[++i]));
+            }
+            else if (arg == "--policy" && hasValue)
+            {
+                std::string policy = argv[++i];
+                if (std::find_if(std::begin(kPolicies), std::end(kPolicies),
+                                 [&policy](const char *p) { return policy.compare(p) == 0; }) == std::end(kPolicies))
+                {
+                    std::cerr << "unknown policy " << policy << std::endl;
+                    return false;
+                }
+                options.policies.push_back(policy);
+            }
+            else if (arg == "--output" && hasValue)
+            {
+                options.output = argv[++i];
+            }
+            else if (!arg.empty() && arg[0] != '-')
+            {
+                options.models.push_back(arg);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (options.policies.empty())
+            options.policies.assign(std::begin(kPolicies), std::end(kPolicies));
+        if (options.models.empty())
+            options.models.push_back(std::string(AIF_INSTALL_DIR) + "/model/face_detection_short_range.tflite");
+        return true;
+    }
+} // end of anonymous namespace
+
+int main(int argc, char **argv)
+{
+    Options options = {50, 5, {}, {}, ""};
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Result> results;
+    bool success = true;
+    for (const auto &model : options.models)
+    {
+        for (const auto &policy : options.policies)
+        {
+            results.push_back(runBenchmark(model, policy, options));
+            success = success && results.back().success;
+        }
+    }
+
+    std::string json = toJson(options, results);
+    if (options.output.empty())
+    {
+        std::cout << json;
+    }
+    else
+    {
+        std::ofstream file(options.output);
+        if (!file.is_open())
+        {
+            std::cerr << "failed to open " << options.output << std::endl;
+            return 1;
+        }
+        file << json;
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "DelegatePlugin.h"
+
+#include <cstring>
+#include <string>
+
+// Provider module for DelegateRegistry_test. Its delegate claims no node, and {"fail":true}
+// in the options makes create() fail like a device that is not there.
+namespace
+{
+    int s_createdNum = 0;
+    int s_destroyedNum = 0;
+    std::string s_lastOptions;
+
+    TfLiteStatus prepare(TfLiteContext *context, TfLiteDelegate *delegate)
+    {
+        (void)context;
+        (void)delegate;
+        return kTfLiteOk;
+    }
+
+    TfLiteDelegate *create(const char *options)
+    {
+        s_lastOptions = options;
+        if (strstr(options, "\"fail\":true") != nullptr)
+        {
+            return nullptr;
+        }
+        TfLiteDelegate *delegate = new TfLiteDelegate(TfLiteDelegateCreate());
+        delegate->Prepare = prepare;
+        s_createdNum++;
+        return delegate;
+    }
+
+    void destroy(TfLiteDelegate *delegate)
+    {
+        delete delegate;
+        s_destroyedNum++;
+    }
+
+    const AifDelegatePlugin s_plugin = {
+        AIF_DELEGATE_PLUGIN_ABI_VERSION,
+        "MOCK",
+        create,
+        destroy,
+    };
+} // end of anonymous namespace
+
+extern "C" {
+
+__attribute__((visibility("default"))) const AifDelegatePlugin *aif_delegate_plugin_get(void)
+{
+    return &s_plugin;
+}
+
+__attribute__((visibility("default"))) int aif_mock_delegate_plugin_get_created_num(void)
+{
+    return s_createdNum;
+}
+
+__attribute__((visibility("default"))) int aif_mock_delegate_plugin_get_destroyed_num(void)
+{
+    return s_destroyedNum;
+}
+
+__attribute__((visibility("default"))) const char *aif_mock_delegate_plugin_get_last_options(void)
+{
+    return s_lastOptions.c_str();
+}
+
+} // extern "C"
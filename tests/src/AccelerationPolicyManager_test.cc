@@ -211,4 +211,301 @@ TEST_F(AccelerationPolicyManagerTest, 09_set_and_get_NNAPI_Caching)
     EXPECT_EQ(apm.getNnapiCache().cache_dir, "/usr/share/aif/model_caches/");
     EXPECT_EQ(apm.getNnapiCache().model_token, "yolov3_qat_soc_model");
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef USE_XNNPACK
+TEST_F(AccelerationPolicyManagerTest, 10_01_set_and_get_XNNPACK_options)
+{
+    std::string config = R"(
+        {
+            "policy" : "CPU_ONLY",
+            "xnnpack" : {
+                "num_threads" : 4,
+                "enable_qs8" : true,
+                "force_fp16" : true
+            }
+        }
+    )";
+
+    APM apm(config);
+    EXPECT_EQ(apm.getPolicy(), APM::kCPUOnly);
+    EXPECT_EQ(apm.getXnnpackOptions().num_threads, 4);
+    EXPECT_TRUE(apm.getXnnpackOptions().enable_qs8);
+    EXPECT_FALSE(apm.getXnnpackOptions().enable_qu8);
+    EXPECT_TRUE(apm.getXnnpackOptions().force_fp16);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 10_02_set_and_get_XNNPACK_options)
+{
+    APM apm;
+    EXPECT_EQ(apm.getXnnpackOptions().num_threads, 0);
+
+    apm.setXnnpackOptions({-3, false, true, false});
+    EXPECT_EQ(apm.getXnnpackOptions().num_threads, 0);
+    EXPECT_TRUE(apm.getXnnpackOptions().enable_qu8);
+}
+#endif
+
+TEST_F(AccelerationPolicyManagerTest, 11_01_set_and_get_AUTO_TUNE_policy)
+{
+    std::string config = R"(
+        {
+            "policy" : "AUTO_TUNE",
+            "auto_tune" : {
+                "warmup_runs" : 1,
+                "runs" : 5
+            }
+        }
+    )";
+
+    APM apm(config);
+    EXPECT_EQ(apm.getPolicy(), APM::kAutoTune);
+    EXPECT_EQ(apm.getAutoTuning().warmup_runs, 1);
+    EXPECT_EQ(apm.getAutoTuning().runs, 5);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 11_02_set_and_get_AUTO_TUNE_policy)
+{
+    APM apm;
+
+    EXPECT_TRUE(apm.setPolicy(APM::kAutoTune));
+    EXPECT_EQ(apm.getPolicy(), APM::kAutoTune);
+    EXPECT_EQ(apm.getAutoTuning().warmup_runs, 2);
+    EXPECT_EQ(apm.getAutoTuning().runs, 10);
+
+    apm.setAutoTuning({-1, 0});
+    EXPECT_EQ(apm.getAutoTuning().warmup_runs, 0);
+    EXPECT_EQ(apm.getAutoTuning().runs, 1);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 12_01_set_and_get_thread_policy)
+{
+    APM apm;
+    EXPECT_EQ(apm.getThreadPolicy().num_threads, -1);
+
+    APM fixedApm(R"({ "threads" : { "num_threads" : 3 } })");
+    EXPECT_EQ(fixedApm.getThreadPolicy().num_threads, 3);
+
+    APM autoApm(R"({ "threads" : { "num_threads" : "auto" } })");
+    EXPECT_EQ(autoApm.getThreadPolicy().num_threads, 0);
+    EXPECT_EQ(autoApm.getThreadPolicy().cluster, APM::kClusterAuto);
+
+    APM bigApm(R"({ "threads" : { "cluster" : "big" } })");
+    EXPECT_EQ(bigApm.getThreadPolicy().num_threads, 0);
+    EXPECT_EQ(bigApm.getThreadPolicy().cluster, APM::kClusterBig);
+
+    APM littleApm(R"({ "threads" : { "cluster" : "little" } })");
+    EXPECT_EQ(littleApm.getThreadPolicy().cluster, APM::kClusterLittle);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 12_02_set_and_get_thread_policy)
+{
+    APM apm;
+
+    apm.setThreadPolicy({2, APM::kClusterAuto});
+    EXPECT_EQ(apm.getThreadPolicy().num_threads, 2);
+
+    apm.setThreadPolicy({-5, APM::kClusterAll});
+    EXPECT_EQ(apm.getThreadPolicy().num_threads, -1);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 13_01_set_and_get_pool_size)
+{
+    APM apm;
+    EXPECT_EQ(apm.getPoolSize(), 0);
+
+    APM fixedApm(R"({ "pool" : { "size" : 4 } })");
+    EXPECT_EQ(fixedApm.getPoolSize(), 4);
+
+    APM autoApm(R"({ "pool" : { "size" : "auto" } })");
+    EXPECT_EQ(autoApm.getPoolSize(), 0);
+
+    APM invalidApm(R"({ "pool" : 4 })");
+    EXPECT_EQ(invalidApm.getPoolSize(), 0);
+
+    apm.setPoolSize(-3);
+    EXPECT_EQ(apm.getPoolSize(), 0);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 14_01_set_and_get_partition_limits)
+{
+    APM apm;
+    EXPECT_EQ(apm.getPartitionLimits().max_delegated_partitions, 0);
+    EXPECT_DOUBLE_EQ(apm.getPartitionLimits().min_delegated_node_ratio, 0.0);
+
+    APM limitApm(R"({ "partition_limits" : { "max_delegated_partitions" : 2, "min_delegated_node_ratio" : 0.7 } })");
+    EXPECT_EQ(limitApm.getPartitionLimits().max_delegated_partitions, 2);
+    EXPECT_DOUBLE_EQ(limitApm.getPartitionLimits().min_delegated_node_ratio, 0.7);
+
+    apm.setPartitionLimits({-1, 1.5});
+    EXPECT_EQ(apm.getPartitionLimits().max_delegated_partitions, 0);
+    EXPECT_DOUBLE_EQ(apm.getPartitionLimits().min_delegated_node_ratio, 1.0);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 15_01_set_and_get_profiling)
+{
+    APM apm;
+    EXPECT_FALSE(apm.getProfiling().enabled);
+
+    APM profilingApm(R"({ "profiling" : { "report_path" : "/tmp/profile.json" } })");
+    EXPECT_TRUE(profilingApm.getProfiling().enabled);
+    EXPECT_EQ(profilingApm.getProfiling().report_path, "/tmp/profile.json");
+
+    APM disabledApm(R"({ "profiling" : { "enabled" : false } })");
+    EXPECT_FALSE(disabledApm.getProfiling().enabled);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 16_01_set_and_get_max_memory)
+{
+    APM apm;
+    EXPECT_EQ(apm.getMaxMemoryMB(), 0);
+
+    APM budgetApm(R"({ "policy" : "MIN_RES", "max_memory_mb" : 64 })");
+    EXPECT_EQ(budgetApm.getMaxMemoryMB(), 64);
+
+    apm.setMaxMemoryMB(-1);
+    EXPECT_EQ(apm.getMaxMemoryMB(), 0);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 17_01_set_and_get_model_loading)
+{
+    APM apm;
+    EXPECT_FALSE(apm.getModelLoading().populate);
+    EXPECT_EQ(apm.getModelLoading().advice, APM::kAdviceNormal);
+    EXPECT_TRUE(apm.getModelLoading().verify);
+
+    APM loadingApm(R"({ "model_loading" : { "populate" : true, "advice" : "willneed", "verify" : false } })");
+    EXPECT_TRUE(loadingApm.getModelLoading().populate);
+    EXPECT_EQ(loadingApm.getModelLoading().advice, APM::kAdviceWillNeed);
+    EXPECT_FALSE(loadingApm.getModelLoading().verify);
+
+    APM invalidApm(R"({ "model_loading" : { "advice" : "someday" } })");
+    EXPECT_EQ(invalidApm.getModelLoading().advice, APM::kAdviceNormal);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 18_01_set_and_get_cache_management)
+{
+    APM apm;
+    EXPECT_FALSE(apm.getCacheManagement().enabled);
+
+    APM managedApm(R"({ "serialization" : { "dir_path" : "/tmp/gpu_cache", "model_token" : "fdshort" },
+                        "cache_manager" : { "max_mb" : 64 } })");
+    EXPECT_TRUE(managedApm.getCacheManagement().enabled);
+    EXPECT_EQ(managedApm.getCacheManagement().max_mb, 64);
+
+    APM disabledApm(R"({ "cache_manager" : { "enabled" : false } })");
+    EXPECT_FALSE(disabledApm.getCacheManagement().enabled);
+
+    apm.setCacheManagement({true, -1});
+    EXPECT_EQ(apm.getCacheManagement().max_mb, 0);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 19_01_set_and_get_adaptive_fallback)
+{
+    APM apm;
+    EXPECT_FALSE(apm.getAdaptiveFallback().enabled);
+
+    APM adaptiveApm(R"({ "policy" : "LOAD_BALANCING", "cpu_fallback_percentage" : 30,
+                         "adaptive_fallback" : { "step" : 10, "window" : 50, "hysteresis" : 0.1 } })");
+    EXPECT_TRUE(adaptiveApm.getAdaptiveFallback().enabled);
+    EXPECT_EQ(adaptiveApm.getAdaptiveFallback().step, 10);
+    EXPECT_EQ(adaptiveApm.getAdaptiveFallback().window, 50);
+    EXPECT_DOUBLE_EQ(adaptiveApm.getAdaptiveFallback().hysteresis, 0.1);
+    EXPECT_DOUBLE_EQ(adaptiveApm.getAdaptiveFallback().redelegation_budget, 0.05);
+
+    APM disabledApm(R"({ "adaptive_fallback" : { "enabled" : false } })");
+    EXPECT_FALSE(disabledApm.getAdaptiveFallback().enabled);
+
+    apm.setAdaptiveFallback({true, 200, 0, -1.0, -1.0});
+    EXPECT_EQ(apm.getAdaptiveFallback().step, 100);
+    EXPECT_EQ(apm.getAdaptiveFallback().window, 1);
+    EXPECT_DOUBLE_EQ(apm.getAdaptiveFallback().hysteresis, 0.0);
+    EXPECT_DOUBLE_EQ(apm.getAdaptiveFallback().redelegation_budget, 0.0);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 20_01_set_and_get_pipeline)
+{
+    APM apm;
+    EXPECT_EQ(apm.getPipeline().max_stages, 0);
+    EXPECT_EQ(apm.getPipeline().queue_size, 2);
+
+    APM pipelineApm(R"({ "pipeline" : { "max_stages" : 3, "queue_size" : 4 } })");
+    EXPECT_EQ(pipelineApm.getPipeline().max_stages, 3);
+    EXPECT_EQ(pipelineApm.getPipeline().queue_size, 4);
+
+    apm.setPipeline({-1, 0});
+    EXPECT_EQ(apm.getPipeline().max_stages, 0);
+    EXPECT_EQ(apm.getPipeline().queue_size, 1);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 21_01_set_and_get_batching)
+{
+    APM apm;
+    EXPECT_EQ(apm.getBatching().max_batch_size, 1);
+    EXPECT_EQ(apm.getBatching().window_ms, 2);
+
+    APM batchingApm(R"({ "batching" : { "max_batch_size" : 8, "window_ms" : 5 } })");
+    EXPECT_EQ(batchingApm.getBatching().max_batch_size, 8);
+    EXPECT_EQ(batchingApm.getBatching().window_ms, 5);
+
+    apm.setBatching({0, -1});
+    EXPECT_EQ(apm.getBatching().max_batch_size, 1);
+    EXPECT_EQ(apm.getBatching().window_ms, 0);
+}
+
+TEST_F(AccelerationPolicyManagerTest, 22_01_set_and_get_delegate_plugins)
+{
+    APM apm;
+    EXPECT_EQ(apm.getDelegatePlugins().dir, APM::getDefaultDelegatePluginDir());
+    EXPECT_TRUE(apm.getDelegatePlugins().options.empty());
+
+    APM pluginApm(R"({ "delegate_plugins" : { "dir" : "/opt/plugins", "options" : { "NPU" : { "level" : 2 } } } })");
+    EXPECT_EQ(pluginApm.getDelegatePlugins().dir, "/opt/plugins");
+    ASSERT_EQ(pluginApm.getDelegatePlugins().options.count("NPU"), 1);
+    EXPECT_EQ(pluginApm.getDelegatePlugins().options.at("NPU"), R"({"level":2})");
+
+    APM disabledApm(R"({ "delegate_plugins" : { "dir" : "" } })");
+    EXPECT_TRUE(disabledApm.getDelegatePlugins().dir.empty());
+
+    APM::Policy policy = APM::kCPUOnly;
+    EXPECT_TRUE(APM::stringToPolicy("MIN_RES", policy));
+    EXPECT_EQ(policy, APM::kMinRes);
+    EXPECT_FALSE(APM::stringToPolicy("FASTEST", policy));
+}
+
+TEST_F(AccelerationPolicyManagerTest, 23_01_parsed_config_and_validation)
+{
+    rapidjson::Document d;
+    d.Parse(R"({ "policy" : "MIN_RES", "batching" : { "max_batch_size" : 4 } })");
+    APM apm(d);
+    EXPECT_EQ(apm.getPolicy(), APM::kMinRes);
+    EXPECT_EQ(apm.getBatching().max_batch_size, 4);
+
+    std::vector<std::string> errors;
+    EXPECT_TRUE(APM::validate(d, "", errors));
+    EXPECT_TRUE(errors.empty());
+
+    d.Parse(R"({ "policy" : "MIN_RES", "pool" : { "size" : "auto" }, "threads" : { "num_threads" : "auto" } })");
+    EXPECT_TRUE(APM::validate(d, "", errors));
+
+    d.Parse(R"({ "polcy" : "MIN_RES", "pool" : { "size" : "all" }, "partition_limits" : 1 })");
+    EXPECT_FALSE(APM::validate(d, "face", errors));
+    EXPECT_EQ(errors, std::vector<std::string>({"face.polcy: unknown option",
+                                                "face.pool.size: must be an integer or \"auto\"",
+                                                "face.partition_limits: must be an object"}));
+
+    // a config that is not JSON leaves everything at the defaults
+    APM broken(R"({ "policy" : "MIN_RES", )");
+    EXPECT_EQ(broken.getPolicy(), APM::kCPUOnly);
+    // sections that are not objects are reported and skipped
+    APM badSerialization(R"({ "policy" : "MIN_RES", "serialization" : "x" })");
+    EXPECT_EQ(badSerialization.getPolicy(), APM::kMinRes);
+    EXPECT_FALSE(badSerialization.getCache().useCache);
+    APM badCaching(R"({ "policy" : "MIN_RES", "caching" : 1 })");
+    EXPECT_EQ(badCaching.getPolicy(), APM::kMinRes);
+    EXPECT_TRUE(badCaching.getNnapiCache().cache_dir.empty());
+    d.Parse(R"({ "serialization" : "x", "caching" : 1 })");
+    errors.clear();
+    EXPECT_FALSE(APM::validate(d, "", errors));
+    EXPECT_EQ(errors, std::vector<std::string>({"serialization: must be an object", "caching: must be an object"}));
+}
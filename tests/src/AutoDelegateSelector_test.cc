@@ -5,6 +5,10 @@
 #include <gtest/gtest.h>
 #include <AutoDelegateSelector.h>
 #include <GraphTester.h>
+#include <XnnpackDelegateOptions.h>
+
+#include <algorithm>
+#include <cstdio>
 
 using namespace aif;
 
@@ -306,3 +310,397 @@ TEST_F(AutoDelegateSelectorTest, 05_02_selectDelegate_yoloqat_MinLatencyMinRes_t
 }
 #endif
 #endif
+
+#ifdef USE_XNNPACK
+TEST_F(AutoDelegateSelectorTest, 06_01_selectDelegate_fdshort_CPUOnly_xnnpack)
+{
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+    std::string config = R"(
+        {
+            "policy" : "CPU_ONLY",
+            "xnnpack" : {
+                "num_threads" : 2
+            }
+        }
+    )";
+    APM apm(config);
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm));
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.isDelegated());
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
+TEST_F(AutoDelegateSelectorTest, 06_02_selectDelegate_pose2d_CPUOnly_xnnpack)
+{
+    std::string model_path = model_paths[2];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kCPUOnly));
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm));
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.isDelegated());
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
+#ifndef USE_GPU
+TEST_F(AutoDelegateSelectorTest, 06_03_selectDelegate_fdshort_MaximumPrecision_xnnpack)
+{
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kMaximumPrecision));
+    apm.setXnnpackOptions({0, false, false, true});
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm));
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.isDelegated());
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+#endif
+
+TEST_F(AutoDelegateSelectorTest, 06_04_xnnpackDelegateOptions_MaximumPrecision)
+{
+    APM apm;
+    apm.setXnnpackOptions({2, true, false, true});
+    EXPECT_TRUE(apm.setPolicy(APM::kMaximumPrecision));
+    TfLiteXNNPackDelegateOptions options = makeXnnpackDelegateOptions(apm, 4);
+    // the delegate must keep full precision even though force_fp16 is requested
+    EXPECT_EQ(options.flags & TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16, 0u);
+    EXPECT_NE(options.flags & TFLITE_XNNPACK_DELEGATE_FLAG_QS8, 0u);
+    EXPECT_EQ(options.num_threads, 2);
+
+    EXPECT_TRUE(apm.setPolicy(APM::kCPUOnly));
+    options = makeXnnpackDelegateOptions(apm, 4);
+    EXPECT_NE(options.flags & TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16, 0u);
+
+    apm.setXnnpackOptions({0, false, false, false});
+    options = makeXnnpackDelegateOptions(apm, 4);
+    EXPECT_EQ(options.num_threads, 4);
+    EXPECT_EQ(options.flags & TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16, 0u);
+}
+#endif
+
+TEST_F(AutoDelegateSelectorTest, 07_01_selectDelegate_fdshort_AutoTune)
+{
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+    std::string config = R"(
+        {
+            "policy" : "AUTO_TUNE",
+            "auto_tune" : {
+                "warmup_runs" : 1,
+                "runs" : 3
+            }
+        }
+    )";
+    APM apm(config);
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm, *model.get()));
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
+TEST_F(AutoDelegateSelectorTest, 07_02_selectDelegate_fdshort_AutoTune_without_model)
+{
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kAutoTune));
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kAutoTune);
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
+TEST_F(AutoDelegateSelectorTest, 08_01_selectDelegate_fdshort_decision_cache)
+{
+    std::string cache_path = std::string(AIF_INSTALL_DIR) + std::string("/delegate_decisions_ads_test.json");
+    std::remove(cache_path.c_str());
+
+    std::string config =
+        "{\n"
+        "    \"policy\" : \"CPU_ONLY\",\n"
+        "    \"decision_cache\" : {\n"
+        "        \"path\" : \"" + cache_path + "\"\n"
+        "    }\n"
+        "}";
+
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    for (int i = 0; i < 2; i++)
+    {
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+        APM apm(config);
+        ADS ads;
+        EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm, *model.get()));
+
+        DelegateDecisionCache cache(cache_path);
+        EXPECT_TRUE(cache.load());
+        DelegateDecisionCache::Decision decision;
+        EXPECT_TRUE(cache.lookup(DelegateDecisionCache::makeKey(*model.get(), apm), decision));
+        EXPECT_TRUE(decision.result);
+
+        GraphTester graphTester(*interpreter.get());
+#ifdef USE_XNNPACK
+        EXPECT_TRUE(graphTester.isDelegated());
+#endif
+
+        EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+        EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+        EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    }
+
+    std::remove(cache_path.c_str());
+}
+
+TEST_F(AutoDelegateSelectorTest, 08_02_selectDelegate_fdshort_stale_decision)
+{
+    std::string cache_path = std::string(AIF_INSTALL_DIR) + std::string("/delegate_decisions_ads_test.json");
+    std::remove(cache_path.c_str());
+
+    std::string config = R"({ "policy" : "CPU_ONLY", "decision_cache" : { "path" : ")" + cache_path + R"(" } })";
+
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+    // a decision of a backend this build does not have, e.g. from an older release
+    APM apm(config);
+    std::string key = DelegateDecisionCache::makeKey(*model.get(), apm);
+    DelegateDecisionCache stale(cache_path);
+    stale.store(key, {{"UNKNOWN"}, {}, -1, true});
+    EXPECT_TRUE(stale.save());
+
+    // it is dropped and the delegate is selected again
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm, *model.get()));
+
+    DelegateDecisionCache cache(cache_path);
+    EXPECT_TRUE(cache.load());
+    DelegateDecisionCache::Decision decision;
+    EXPECT_TRUE(cache.lookup(key, decision));
+    EXPECT_TRUE(decision.result);
+    EXPECT_EQ(std::find(decision.backends.begin(), decision.backends.end(), "UNKNOWN"), decision.backends.end());
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+
+    std::remove(cache_path.c_str());
+}
+
+TEST_F(AutoDelegateSelectorTest, 09_01_selectDelegate_fdshort_thread_policy)
+{
+    std::vector<std::string> configs = {
+        R"({ "policy" : "CPU_ONLY", "threads" : { "num_threads" : 2 } })",
+        R"({ "policy" : "CPU_ONLY", "threads" : { "num_threads" : "auto" } })",
+        R"({ "policy" : "CPU_ONLY", "threads" : { "cluster" : "little" } })",
+    };
+
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    for (const auto &config : configs)
+    {
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+        APM apm(config);
+        ADS ads;
+        EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm));
+
+        EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+        GraphTester graphTester(*interpreter.get());
+        EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+        EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    }
+}
+
+TEST_F(AutoDelegateSelectorTest, 10_01_selectDelegateAsync_fdshort_CPUOnly)
+{
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> builtInterpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&builtInterpreter), kTfLiteOk);
+    std::shared_ptr<tflite::Interpreter> interpreter(std::move(builtInterpreter));
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kCPUOnly));
+    std::future<bool> prepared = ADS::selectDelegateAsync(interpreter, apm);
+    EXPECT_TRUE(prepared.get());
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
+TEST_F(AutoDelegateSelectorTest, 10_02_selectDelegateAsync_fdshort_AutoTune)
+{
+    std::string model_path = model_paths[0];
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    std::unique_ptr<tflite::Interpreter> builtInterpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&builtInterpreter), kTfLiteOk);
+    std::shared_ptr<tflite::Interpreter> interpreter(std::move(builtInterpreter));
+
+    std::future<bool> prepared;
+    {
+        // the worker keeps its own copy of the policy
+        APM apm(R"({ "policy" : "AUTO_TUNE", "auto_tune" : { "warmup_runs" : 1, "runs" : 2 } })");
+        prepared = ADS::selectDelegateAsync(interpreter, apm, model);
+    }
+    EXPECT_TRUE(prepared.get());
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+    GraphTester graphTester(*interpreter.get());
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+}
+
+TEST_F(AutoDelegateSelectorTest, 10_03_selectDelegateAsync_null_interpreter)
+{
+    APM apm;
+    std::future<bool> prepared = ADS::selectDelegateAsync(nullptr, apm);
+    EXPECT_FALSE(prepared.get());
+}
+
+TEST_F(AutoDelegateSelectorTest, 11_01_selectDelegate_fdshort_memory_budget)
+{
+    std::vector<std::string> configs = {
+        R"({ "policy" : "MIN_LATENCY", "max_memory_mb" : 4096 })",
+        // nothing fits in 1 MB, so the configuration that needs the least memory is taken
+        R"({ "policy" : "MIN_LATENCY", "max_memory_mb" : 1 })",
+        R"({ "policy" : "AUTO_TUNE", "max_memory_mb" : 1, "auto_tune" : { "warmup_runs" : 0, "runs" : 1 } })",
+    };
+
+    std::string model_path = model_paths[0];
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    for (const auto &config : configs)
+    {
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        EXPECT_EQ(tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter), kTfLiteOk);
+
+        APM apm(config);
+        ADS ads;
+        EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm, *model.get()));
+
+        const auto &footprint = ads.getLastFootprint();
+        EXPECT_GT(MemoryUsage::getCost(footprint), 0);
+        EXPECT_GT(footprint.tensors.arena_bytes, 0);
+
+        EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+        GraphTester graphTester(*interpreter.get());
+        EXPECT_TRUE(graphTester.fillRandomInputTensor());
+
+        EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    }
+}
+
+TEST_F(AutoDelegateSelectorTest, 12_01_resolve_auto_model_tokens)
+{
+    std::string config = R"({ "policy" : "MIN_LATENCY",
+                              "serialization" : { "dir_path" : "/tmp", "model_token" : "auto" },
+                              "caching" : { "cache_dir" : "/tmp", "model_token" : "auto" } })";
+
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_paths[0].c_str());
+    std::unique_ptr<tflite::FlatBufferModel> otherModel = tflite::FlatBufferModel::BuildFromFile(model_paths[2].c_str());
+
+    APM apm(config);
+    EXPECT_TRUE(ADS::resolveModelTokens(apm, *model.get()));
+    std::string gpuToken = apm.getCache().model_token;
+    std::string nnapiToken = apm.getNnapiCache().model_token;
+    EXPECT_EQ(gpuToken.size(), 16u);
+    EXPECT_EQ(nnapiToken.size(), 16u);
+    EXPECT_NE(gpuToken, nnapiToken);
+    EXPECT_EQ(gpuToken, ADS::deriveModelToken(*model.get(), ADS::kBackendGPU, apm));
+
+    // the same model and options give the same token, a different model another one
+    APM sameApm(config);
+    EXPECT_TRUE(ADS::resolveModelTokens(sameApm, *model.get()));
+    EXPECT_EQ(sameApm.getCache().model_token, gpuToken);
+
+    APM otherApm(config);
+    EXPECT_TRUE(ADS::resolveModelTokens(otherApm, *otherModel.get()));
+    EXPECT_NE(otherApm.getCache().model_token, gpuToken);
+
+    // tokens that are already set are kept
+    APM fixedApm(R"({ "serialization" : { "dir_path" : "/tmp", "model_token" : "fdshort" } })");
+    EXPECT_TRUE(ADS::resolveModelTokens(fixedApm, *model.get()));
+    EXPECT_EQ(fixedApm.getCache().model_token, "fdshort");
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <AutoDelegateSelector.h>
+#include <BatchedModel.h>
+
+#include <cstring>
+#include <thread>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+
+class BatchedModelTest : public ::testing::Test
+{
+protected:
+    BatchedModelTest() = default;
+    ~BatchedModelTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    // request i filled with a pattern of its own
+    static BatchedModel::Buffers makeInputs(tflite::Interpreter &interpreter, int i)
+    {
+        BatchedModel::Buffers inputs;
+        for (int index : interpreter.inputs())
+        {
+            const TfLiteTensor *tensor = interpreter.tensor(index);
+            std::vector<uint8_t> buffer(tensor->bytes);
+            if (tensor->type == kTfLiteFloat32)
+            {
+                float *values = reinterpret_cast<float *>(buffer.data());
+                for (size_t j = 0; j < buffer.size() / sizeof(float); j++)
+                    values[j] = static_cast<float>((j * 5 + i * 31) % 256) / 256.0f;
+            }
+            else
+            {
+                for (size_t j = 0; j < buffer.size(); j++)
+                    buffer[j] = static_cast<uint8_t>(j * 5 + i * 31);
+            }
+            inputs.push_back(std::move(buffer));
+        }
+        return inputs;
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(BatchedModelTest, 01_make_buckets)
+{
+    EXPECT_EQ(BatchedModel::makeBuckets(1), std::vector<int>({1}));
+    EXPECT_EQ(BatchedModel::makeBuckets(8), std::vector<int>({1, 2, 4, 8}));
+    EXPECT_EQ(BatchedModel::makeBuckets(6), std::vector<int>({1, 2, 4, 6}));
+    EXPECT_EQ(BatchedModel::makeBuckets(0), std::vector<int>({1}));
+}
+
+TEST_F(BatchedModelTest, 02_batched_outputs_match_single_invoke)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "batching" : { "max_batch_size" : 4, "window_ms" : 50 } })");
+    BatchedModel batchedModel(model, apm);
+    ASSERT_TRUE(batchedModel.init());
+    EXPECT_EQ(batchedModel.getBuckets(), std::vector<int>({1, 2, 4}));
+
+    std::unique_ptr<tflite::Interpreter> reference;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&reference), kTfLiteOk);
+    AutoDelegateSelector ads;
+    ASSERT_TRUE(ads.selectDelegate(*reference, apm));
+    ASSERT_EQ(reference->AllocateTensors(), kTfLiteOk);
+
+    const int requestNum = 3;
+    std::vector<BatchedModel::Buffers> inputs;
+    for (int i = 0; i < requestNum; i++)
+    {
+        inputs.push_back(makeInputs(*reference, i));
+    }
+    std::vector<BatchedModel::Buffers> outputs(requestNum);
+    std::vector<int> results(requestNum, 0);
+    std::vector<std::thread> callers;
+    for (int i = 0; i < requestNum; i++)
+    {
+        callers.emplace_back([&, i]() {
+            results[i] = batchedModel.infer(inputs[i], outputs[i]);
+        });
+    }
+    for (auto &caller : callers)
+    {
+        caller.join();
+    }
+
+    EXPECT_EQ(batchedModel.getRequestCount(), static_cast<uint64_t>(requestNum));
+    EXPECT_GE(batchedModel.getStats()->getInvokeCount(), 1u);
+    EXPECT_LE(batchedModel.getStats()->getInvokeCount(), static_cast<uint64_t>(requestNum));
+
+    for (int i = 0; i < requestNum; i++)
+    {
+        ASSERT_TRUE(results[i]);
+        ASSERT_EQ(outputs[i].size(), reference->outputs().size());
+
+        for (size_t j = 0; j < inputs[i].size(); j++)
+        {
+            memcpy(reference->tensor(reference->inputs()[j])->data.raw, inputs[i][j].data(), inputs[i][j].size());
+        }
+        ASSERT_EQ(reference->Invoke(), kTfLiteOk);
+
+        for (size_t j = 0; j < outputs[i].size(); j++)
+        {
+            const TfLiteTensor *expected = reference->tensor(reference->outputs()[j]);
+            ASSERT_EQ(outputs[i][j].size(), expected->bytes);
+            if (expected->type == kTfLiteFloat32)
+            {
+                const float *actual = reinterpret_cast<const float *>(outputs[i][j].data());
+                for (size_t k = 0; k < expected->bytes / sizeof(float); k++)
+                    ASSERT_NEAR(actual[k], expected->data.f[k], 1e-3);
+            }
+        }
+    }
+}
+
+TEST_F(BatchedModelTest, 03_reject_invalid_inputs)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "batching" : { "max_batch_size" : 2, "window_ms" : 0 } })");
+    BatchedModel batchedModel(model, apm);
+
+    BatchedModel::Buffers outputs;
+    EXPECT_FALSE(batchedModel.infer(BatchedModel::Buffers(), outputs));
+
+    ASSERT_TRUE(batchedModel.init());
+    EXPECT_FALSE(batchedModel.infer(BatchedModel::Buffers(), outputs));
+    EXPECT_FALSE(batchedModel.infer(BatchedModel::Buffers(1, std::vector<uint8_t>(3)), outputs));
+    EXPECT_EQ(batchedModel.getRequestCount(), 0u);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <CacheManager.h>
+#include <tools/Hash.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace aif;
+
+class CacheManagerTest : public ::testing::Test
+{
+protected:
+    CacheManagerTest() = default;
+    ~CacheManagerTest() = default;
+
+    void SetUp() override
+    {
+        char dir[] = "/tmp/cache_manager_test.XXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != nullptr);
+        cache_dir = dir;
+    }
+
+    void TearDown() override
+    {
+        std::system(("rm -rf " + cache_dir).c_str());
+    }
+
+    static void writeFile(const std::string &path, const std::string &content)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+    }
+
+    static std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    static bool exists(const std::string &path)
+    {
+        return access(path.c_str(), F_OK) == 0;
+    }
+
+    std::string cache_dir;
+};
+
+TEST_F(CacheManagerTest, 01_stage_and_publish)
+{
+    std::string stagingDir;
+    {
+        CacheManager manager(cache_dir, 0);
+        EXPECT_TRUE(manager.open());
+        const char *dir = manager.stage("fdshort");
+        ASSERT_TRUE(dir != nullptr);
+        stagingDir = dir;
+        EXPECT_NE(stagingDir, cache_dir);
+
+        // what a delegate writes is not visible until it is published
+        writeFile(stagingDir + "/fdshort.bin", "serialized");
+        EXPECT_FALSE(exists(cache_dir + "/fdshort.bin"));
+
+        EXPECT_TRUE(manager.publish("fdshort"));
+        EXPECT_EQ(readFile(cache_dir + "/fdshort.bin"), "serialized");
+        EXPECT_TRUE(manager.hasEntry("fdshort"));
+        EXPECT_EQ(manager.getTotalBytes(), 10);
+    }
+    EXPECT_FALSE(exists(stagingDir));
+
+    CacheManager manager(cache_dir, 0);
+    EXPECT_TRUE(manager.open());
+    EXPECT_TRUE(manager.hasEntry("fdshort"));
+    const char *dir = manager.stage("fdshort");
+    ASSERT_TRUE(dir != nullptr);
+    EXPECT_EQ(readFile(std::string(dir) + "/fdshort.bin"), "serialized");
+
+    // a token is required, and only the staged one can be published
+    EXPECT_TRUE(manager.stage("") == nullptr);
+    EXPECT_FALSE(manager.publish("other"));
+}
+
+TEST_F(CacheManagerTest, 02_evict_least_recently_used)
+{
+    CacheManager manager(cache_dir, 100);
+    EXPECT_TRUE(manager.open());
+
+    const char *dir = manager.stage("first");
+    ASSERT_TRUE(dir != nullptr);
+    writeFile(std::string(dir) + "/first.bin", std::string(60, 'a'));
+    EXPECT_TRUE(manager.publish("first"));
+
+    dir = manager.stage("second");
+    ASSERT_TRUE(dir != nullptr);
+    writeFile(std::string(dir) + "/second.bin", std::string(60, 'b'));
+    EXPECT_TRUE(manager.publish("second"));
+
+    EXPECT_FALSE(manager.hasEntry("first"));
+    EXPECT_TRUE(manager.hasEntry("second"));
+    EXPECT_FALSE(exists(cache_dir + "/first.bin"));
+    EXPECT_TRUE(exists(cache_dir + "/second.bin"));
+    EXPECT_EQ(manager.getEntryNum(), 1);
+    EXPECT_EQ(manager.getTotalBytes(), 60);
+
+    // the token just published stays even if it alone is over the cap
+    dir = manager.stage("large");
+    ASSERT_TRUE(dir != nullptr);
+    writeFile(std::string(dir) + "/large.bin", std::string(120, 'c'));
+    EXPECT_TRUE(manager.publish("large"));
+    EXPECT_TRUE(manager.hasEntry("large"));
+    EXPECT_EQ(manager.getEntryNum(), 1);
+}
+
+TEST_F(CacheManagerTest, 03_validate_at_startup)
+{
+    writeFile(cache_dir + "/good.bin", "abc");
+    writeFile(cache_dir + "/bad.bin", "xyz");
+    writeFile(cache_dir + "/index.json.tmp.1", "partial");
+    mkdir((cache_dir + "/.staging.1").c_str(), 0755);
+    // data of others in a shared directory
+    writeFile(cache_dir + "/other.bin", "other");
+    mkdir((cache_dir + "/model").c_str(), 0755);
+    writeFile(cache_dir + "/model/face.tflite", "model");
+
+    std::string goodHash = hashToString(hash64("abc", 3));
+    writeFile(cache_dir + "/index.json",
+              "{ \"version\" : 1, \"entries\" : {"
+              " \"good\" : { \"last_use\" : 1, \"files\" : [ { \"name\" : \"good.bin\", \"bytes\" : 3, \"hash\" : \"" + goodHash + "\" } ] },"
+              " \"bad\" : { \"last_use\" : 1, \"files\" : [ { \"name\" : \"bad.bin\", \"bytes\" : 3, \"hash\" : \"0000000000000000\" } ] },"
+              " \"missing\" : { \"last_use\" : 1, \"files\" : [ { \"name\" : \"missing.bin\", \"bytes\" : 3, \"hash\" : \"" + goodHash + "\" } ] } } }");
+
+    CacheManager manager(cache_dir, 0);
+    EXPECT_TRUE(manager.open());
+    EXPECT_TRUE(manager.hasEntry("good"));
+    EXPECT_FALSE(manager.hasEntry("bad"));
+    EXPECT_FALSE(manager.hasEntry("missing"));
+    EXPECT_TRUE(exists(cache_dir + "/good.bin"));
+    EXPECT_FALSE(exists(cache_dir + "/bad.bin"));
+    EXPECT_FALSE(exists(cache_dir + "/index.json.tmp.1"));
+    EXPECT_FALSE(exists(cache_dir + "/.staging.1"));
+    EXPECT_TRUE(exists(cache_dir + "/other.bin"));
+    EXPECT_TRUE(exists(cache_dir + "/model/face.tflite"));
+
+    // the checked files are not read again as long as they keep their size and mtime
+    EXPECT_NE(readFile(cache_dir + "/index.json").find("\"mtime\""), std::string::npos);
+}
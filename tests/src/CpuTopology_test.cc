@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <tools/CpuTopology.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace aif;
+
+class CpuTopologyTest : public ::testing::Test
+{
+protected:
+    CpuTopologyTest() = default;
+    ~CpuTopologyTest() = default;
+
+    void SetUp() override
+    {
+        mkdir(sysfs_root.c_str(), 0755);
+    }
+
+    void TearDown() override
+    {
+        for (auto it = created_files.rbegin(); it != created_files.rend(); ++it)
+        {
+            std::remove(it->c_str());
+        }
+        for (auto it = created_dirs.rbegin(); it != created_dirs.rend(); ++it)
+        {
+            rmdir(it->c_str());
+        }
+        rmdir(sysfs_root.c_str());
+    }
+
+    void writeFile(const std::string &relativePath, const std::string &content)
+    {
+        std::string path = sysfs_root;
+        size_t pos = 0;
+        size_t next;
+        while ((next = relativePath.find('/', pos)) != std::string::npos)
+        {
+            path = sysfs_root + "/" + relativePath.substr(0, next);
+            if (mkdir(path.c_str(), 0755) == 0)
+            {
+                created_dirs.push_back(path);
+            }
+            pos = next + 1;
+        }
+
+        path = sysfs_root + "/" + relativePath;
+        std::ofstream file(path);
+        file << content << std::endl;
+        created_files.push_back(path);
+    }
+
+    void writeCpuFreq(int cpu, long freq)
+    {
+        writeFile("cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq", std::to_string(freq));
+    }
+
+    std::string sysfs_root = std::string(AIF_INSTALL_DIR) + std::string("/fake_sysfs_cpu");
+    std::vector<std::string> created_files;
+    std::vector<std::string> created_dirs;
+};
+
+TEST_F(CpuTopologyTest, 01_parse_cpu_list)
+{
+    std::vector<int> cpus;
+    EXPECT_TRUE(CpuTopology::parseCpuList("0-3,6,8-9", cpus));
+    EXPECT_EQ(cpus, std::vector<int>({0, 1, 2, 3, 6, 8, 9}));
+
+    EXPECT_TRUE(CpuTopology::parseCpuList("5\n", cpus));
+    EXPECT_EQ(cpus, std::vector<int>({5}));
+
+    EXPECT_FALSE(CpuTopology::parseCpuList("", cpus));
+    EXPECT_FALSE(CpuTopology::parseCpuList("3-1", cpus));
+    EXPECT_FALSE(CpuTopology::parseCpuList("a-b", cpus));
+    EXPECT_EQ(cpus, std::vector<int>({5}));
+}
+
+TEST_F(CpuTopologyTest, 02_big_little)
+{
+    writeFile("online", "0-5");
+    for (int cpu = 0; cpu < 4; cpu++)
+        writeCpuFreq(cpu, 1800000);
+    for (int cpu = 4; cpu < 6; cpu++)
+        writeCpuFreq(cpu, 2400000);
+
+    CpuTopology topology(sysfs_root);
+    EXPECT_EQ(topology.getOnlineCoreNum(), 6);
+    ASSERT_EQ(topology.getClusters().size(), 2u);
+    EXPECT_EQ(topology.getClusters()[0].max_frequency, 1800000);
+    EXPECT_EQ(topology.getClusters()[1].cpus, std::vector<int>({4, 5}));
+    EXPECT_EQ(topology.getBigCoreNum(), 2);
+    EXPECT_EQ(topology.getLittleCoreNum(), 4);
+}
+
+TEST_F(CpuTopologyTest, 03_uniform_with_offline_core)
+{
+    writeFile("online", "0-2");
+    for (int cpu = 0; cpu < 4; cpu++)
+        writeCpuFreq(cpu, 1500000);
+
+    CpuTopology topology(sysfs_root);
+    EXPECT_EQ(topology.getOnlineCoreNum(), 3);
+    EXPECT_EQ(topology.getClusters().size(), 1u);
+    EXPECT_EQ(topology.getBigCoreNum(), 3);
+    EXPECT_EQ(topology.getLittleCoreNum(), 3);
+}
+
+TEST_F(CpuTopologyTest, 04_no_sysfs)
+{
+    CpuTopology topology(sysfs_root + "/not_exist");
+    EXPECT_GT(topology.getOnlineCoreNum(), 0);
+    EXPECT_EQ(topology.getBigCoreNum(), topology.getOnlineCoreNum());
+}
+
+TEST_F(CpuTopologyTest, 05_system)
+{
+    CpuTopology topology;
+    EXPECT_GT(topology.getOnlineCoreNum(), 0);
+    EXPECT_GT(topology.getBigCoreNum(), 0);
+    EXPECT_GT(topology.getLittleCoreNum(), 0);
+}
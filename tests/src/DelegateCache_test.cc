@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <DelegateCache.h>
+
+#include <thread>
+#include <vector>
+
+using namespace aif;
+
+typedef DelegateCache DC;
+
+// The cache lives as long as the process, so each test uses keys of its own and compares
+// the counters with what they were when it started.
+class DelegateCacheTest : public ::testing::Test
+{
+protected:
+    DelegateCacheTest() = default;
+    ~DelegateCacheTest() = default;
+
+    void SetUp() override
+    {
+        created_num = 0;
+        destroyed_num = 0;
+        counters = DC::getInstance().getCounters();
+    }
+
+    void TearDown() override
+    {
+    }
+
+    static TfLiteDelegate *createDelegate()
+    {
+        created_num++;
+        return new TfLiteDelegate(TfLiteDelegateCreate());
+    }
+
+    static void destroyDelegate(TfLiteDelegate *delegate)
+    {
+        destroyed_num++;
+        delete delegate;
+    }
+
+    static int created_num;
+    static int destroyed_num;
+    DC::Counters counters;
+};
+
+int DelegateCacheTest::created_num = 0;
+int DelegateCacheTest::destroyed_num = 0;
+
+TEST_F(DelegateCacheTest, 01_shared_delegate)
+{
+    DC &cache = DC::getInstance();
+    EXPECT_EQ(cache.getRefCount("TEST;01"), 0);
+    {
+        auto first = cache.acquire("TEST;01", true, createDelegate, destroyDelegate);
+        auto second = cache.acquire("TEST;01", true, createDelegate, destroyDelegate);
+        ASSERT_NE(first, nullptr);
+        EXPECT_EQ(first.get(), second.get());
+        EXPECT_EQ(created_num, 1);
+        EXPECT_EQ(cache.getRefCount("TEST;01"), 2);
+
+        // other options are another delegate
+        auto other = cache.acquire("TEST;01;other", true, createDelegate, destroyDelegate);
+        EXPECT_NE(other.get(), first.get());
+        EXPECT_EQ(created_num, 2);
+
+        first.reset();
+        EXPECT_EQ(cache.getRefCount("TEST;01"), 1);
+        EXPECT_EQ(destroyed_num, 0);
+        second.reset();
+        EXPECT_EQ(cache.getRefCount("TEST;01"), 0);
+        EXPECT_EQ(destroyed_num, 1);
+    }
+    EXPECT_EQ(destroyed_num, 2);
+    EXPECT_EQ(cache.getRefCount("TEST;01;other"), 0);
+
+    // created again once the last holder is gone
+    auto again = cache.acquire("TEST;01", true, createDelegate, destroyDelegate);
+    EXPECT_EQ(created_num, 3);
+    EXPECT_EQ(cache.getRefCount("TEST;01"), 1);
+    again.reset();
+
+    DC::Counters now = cache.getCounters();
+    EXPECT_EQ(now.created - counters.created, 3u);
+    EXPECT_EQ(now.reused - counters.reused, 1u);
+    EXPECT_EQ(now.unshared - counters.unshared, 0u);
+}
+
+TEST_F(DelegateCacheTest, 02_unshareable_delegate)
+{
+    DC &cache = DC::getInstance();
+    {
+        auto first = cache.acquire("TEST;02", false, createDelegate, destroyDelegate);
+        auto second = cache.acquire("TEST;02", false, createDelegate, destroyDelegate);
+        ASSERT_NE(first, nullptr);
+        ASSERT_NE(second, nullptr);
+        EXPECT_NE(first.get(), second.get());
+        EXPECT_EQ(created_num, 2);
+        EXPECT_EQ(cache.getRefCount("TEST;02"), 0);
+    }
+    EXPECT_EQ(destroyed_num, 2);
+
+    DC::Counters now = cache.getCounters();
+    EXPECT_EQ(now.created - counters.created, 2u);
+    EXPECT_EQ(now.reused - counters.reused, 0u);
+    EXPECT_EQ(now.unshared - counters.unshared, 2u);
+}
+
+TEST_F(DelegateCacheTest, 03_create_failure)
+{
+    DC &cache = DC::getInstance();
+    auto shared = cache.acquire("TEST;03", true, []() -> TfLiteDelegate * { return nullptr; }, destroyDelegate);
+    auto unshared = cache.acquire("TEST;03", false, []() -> TfLiteDelegate * { return nullptr; }, destroyDelegate);
+    EXPECT_EQ(shared, nullptr);
+    EXPECT_EQ(unshared, nullptr);
+    EXPECT_EQ(cache.getRefCount("TEST;03"), 0);
+
+    // a failure is not cached, the next interpreter tries again
+    auto delegate = cache.acquire("TEST;03", true, createDelegate, destroyDelegate);
+    EXPECT_NE(delegate, nullptr);
+    EXPECT_EQ(created_num, 1);
+    EXPECT_EQ(cache.getCounters().created - counters.created, 1u);
+}
+
+TEST_F(DelegateCacheTest, 04_concurrent_acquire)
+{
+    DC &cache = DC::getInstance();
+    const int threadNum = 8;
+    std::vector<tflite::Interpreter::TfLiteDelegatePtr> delegates;
+    for (int i = 0; i < threadNum; i++)
+    {
+        delegates.emplace_back(nullptr, [](TfLiteDelegate *) {});
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadNum; i++)
+    {
+        threads.emplace_back([&cache, &delegates, i]() {
+            delegates[i] = cache.acquire("TEST;04", true, createDelegate, destroyDelegate);
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(created_num, 1);
+    EXPECT_EQ(cache.getRefCount("TEST;04"), threadNum);
+    for (const auto &delegate : delegates)
+    {
+        EXPECT_EQ(delegate.get(), delegates[0].get());
+    }
+    delegates.clear();
+    EXPECT_EQ(destroyed_num, 1);
+    EXPECT_EQ(cache.getRefCount("TEST;04"), 0);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <DelegateDecisionCache.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include <tensorflow/lite/model.h>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+typedef DelegateDecisionCache DDC;
+
+class DelegateDecisionCacheTest : public ::testing::Test
+{
+protected:
+    DelegateDecisionCacheTest() = default;
+    ~DelegateDecisionCacheTest() = default;
+
+    void SetUp() override
+    {
+        std::remove(cache_path.c_str());
+    }
+
+    void TearDown() override
+    {
+        std::remove(cache_path.c_str());
+    }
+
+    std::string cache_path = std::string(AIF_INSTALL_DIR) + std::string("/delegate_decisions_test.json");
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(DelegateDecisionCacheTest, 01_store_save_and_load)
+{
+    DDC cache(cache_path);
+    EXPECT_FALSE(cache.load());
+
+    cache.store("model-a", {{"GPU"}, {"NNAPI"}, 1, true});
+    cache.store("model-b", {{}, {"GPU"}, 0, false});
+    EXPECT_TRUE(cache.save());
+
+    DDC loaded(cache_path);
+    EXPECT_TRUE(loaded.load());
+
+    DDC::Decision decision;
+    EXPECT_TRUE(loaded.lookup("model-a", decision));
+    ASSERT_EQ(decision.backends.size(), 1u);
+    EXPECT_EQ(decision.backends[0], "GPU");
+    ASSERT_EQ(decision.failedBackends.size(), 1u);
+    EXPECT_EQ(decision.failedBackends[0], "NNAPI");
+    EXPECT_EQ(decision.gpuVendorIMG, 1);
+    EXPECT_TRUE(decision.result);
+
+    EXPECT_TRUE(loaded.lookup("model-b", decision));
+    EXPECT_TRUE(decision.backends.empty());
+    EXPECT_FALSE(decision.result);
+
+    EXPECT_FALSE(loaded.lookup("model-c", decision));
+}
+
+TEST_F(DelegateDecisionCacheTest, 02_save_merges_and_erases)
+{
+    DDC first(cache_path);
+    first.load();
+    DDC second(cache_path);
+    second.load();
+
+    first.store("model-a", {{"XNNPACK"}, {}, -1, true});
+    EXPECT_TRUE(first.save());
+    second.store("model-b", {{"CPU"}, {}, -1, true});
+    EXPECT_TRUE(second.save());
+
+    DDC merged(cache_path);
+    EXPECT_TRUE(merged.load());
+    DDC::Decision decision;
+    EXPECT_TRUE(merged.lookup("model-a", decision));
+    EXPECT_TRUE(merged.lookup("model-b", decision));
+
+    merged.erase("model-a");
+    EXPECT_TRUE(merged.save());
+
+    DDC erased(cache_path);
+    EXPECT_TRUE(erased.load());
+    EXPECT_FALSE(erased.lookup("model-a", decision));
+    EXPECT_TRUE(erased.lookup("model-b", decision));
+}
+
+TEST_F(DelegateDecisionCacheTest, 03_corrupted_file)
+{
+    {
+        std::ofstream file(cache_path);
+        file << "{ \"version\" : 1, \"decisions\" : { \"model-a\" : ";
+    }
+
+    DDC cache(cache_path);
+    EXPECT_FALSE(cache.load());
+
+    cache.store("model-a", {{"CPU"}, {}, -1, true});
+    EXPECT_TRUE(cache.save());
+
+    DDC loaded(cache_path);
+    EXPECT_TRUE(loaded.load());
+}
+
+TEST_F(DelegateDecisionCacheTest, 04_make_key)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    ASSERT_TRUE(model != nullptr);
+
+    EXPECT_FALSE(DDC::getDeviceFingerprint().empty());
+    EXPECT_EQ(DDC::getDeviceFingerprint(), DDC::getDeviceFingerprint());
+
+    APM cpuApm;
+    EXPECT_TRUE(cpuApm.setPolicy(APM::kCPUOnly));
+    APM gpuApm;
+    EXPECT_TRUE(gpuApm.setPolicy(APM::kMinimumLatency));
+
+    std::string cpuKey = DDC::makeKey(*model.get(), cpuApm);
+    EXPECT_FALSE(cpuKey.empty());
+    EXPECT_EQ(cpuKey, DDC::makeKey(*model.get(), cpuApm));
+    EXPECT_NE(cpuKey, DDC::makeKey(*model.get(), gpuApm));
+}
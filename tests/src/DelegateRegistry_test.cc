@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <AutoDelegateSelector.h>
+#include <DelegateRegistry.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include <dlfcn.h>
+
+using namespace aif;
+
+typedef AutoDelegateSelector ADS;
+typedef AccelerationPolicyManager APM;
+typedef DelegateRegistry DR;
+
+// The registry lives as long as the process, so all tests share one plugin directory.
+// MOCK is the module built from tests/plugin/MockDelegatePlugin.cc, BROKEN has no library.
+class DelegateRegistryTest : public ::testing::Test
+{
+protected:
+    DelegateRegistryTest() = default;
+    ~DelegateRegistryTest() = default;
+
+    static void SetUpTestCase()
+    {
+        char dir[] = "/tmp/delegate_registry_test.XXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != nullptr);
+        plugin_dir = dir;
+
+        writeFile(plugin_dir + "/mock.json",
+                  std::string(R"({ "name" : "MOCK", "library" : ")") + MOCK_DELEGATE_PLUGIN_PATH + R"(",
+                                   "custom_ops" : [ "edgetpu-custom-op" ], "policies" : [ "MIN_LATENCY" ] })");
+        writeFile(plugin_dir + "/broken.json",
+                  R"({ "name" : "BROKEN", "library" : "libaif-missing-delegate-plugin.so", "policies" : [ "MAX_PRECISION" ] })");
+        writeFile(plugin_dir + "/invalid.json", "{ \"name\" : ");
+        writeFile(plugin_dir + "/README", "not a manifest");
+    }
+
+    static void TearDownTestCase()
+    {
+        std::system(("rm -rf " + plugin_dir).c_str());
+    }
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    static void writeFile(const std::string &path, const std::string &content)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+    }
+
+    // the mock module as loaded by the registry, or nullptr if it is not loaded
+    static void *getMockModule()
+    {
+        return dlopen(MOCK_DELEGATE_PLUGIN_PATH, RTLD_NOW | RTLD_NOLOAD);
+    }
+
+    static int getMockCount(void *module, const char *symbol)
+    {
+        auto count = reinterpret_cast<int (*)(void)>(dlsym(module, symbol));
+        return count != nullptr ? count() : -1;
+    }
+
+    static std::string getMockLastOptions(void *module)
+    {
+        auto options = reinterpret_cast<const char *(*)(void)>(dlsym(module, "aif_mock_delegate_plugin_get_last_options"));
+        return options != nullptr ? options() : "";
+    }
+
+    APM makeApm(const std::string &policy, const std::string &options = "{}")
+    {
+        return APM(R"({ "policy" : ")" + policy + R"(", "delegate_plugins" : { "dir" : ")" + plugin_dir +
+                   R"(", "options" : { "MOCK" : )" + options + " } } }");
+    }
+
+    static std::string plugin_dir;
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+std::string DelegateRegistryTest::plugin_dir;
+
+TEST_F(DelegateRegistryTest, 01_scan_without_loading)
+{
+    DR &registry = DR::getInstance();
+    EXPECT_FALSE(registry.scan(plugin_dir + "/missing"));
+    EXPECT_TRUE(registry.scan(plugin_dir));
+    EXPECT_TRUE(registry.scan(plugin_dir));
+
+    // sorted by file name, the invalid manifest and the README are skipped
+    auto manifests = registry.getManifests(plugin_dir);
+    ASSERT_EQ(manifests.size(), 2u);
+    EXPECT_EQ(manifests[0].name, "BROKEN");
+    EXPECT_EQ(manifests[0].library, plugin_dir + "/libaif-missing-delegate-plugin.so");
+    EXPECT_EQ(manifests[1].name, "MOCK");
+    EXPECT_EQ(manifests[1].library, MOCK_DELEGATE_PLUGIN_PATH);
+
+    DR::Manifest manifest;
+    EXPECT_TRUE(registry.findByCustomOp(plugin_dir, "edgetpu-custom-op", manifest));
+    EXPECT_EQ(manifest.name, "MOCK");
+    EXPECT_FALSE(registry.findByCustomOp(plugin_dir, "lgnpu_custom_op", manifest));
+    EXPECT_TRUE(registry.findByPolicy(plugin_dir, APM::kMaximumPrecision, manifest));
+    EXPECT_EQ(manifest.name, "BROKEN");
+    EXPECT_FALSE(registry.findByPolicy(plugin_dir, APM::kCPUOnly, manifest));
+    EXPECT_FALSE(registry.find(plugin_dir + "/missing", "MOCK", manifest));
+    ASSERT_TRUE(registry.find(plugin_dir, "MOCK", manifest));
+
+    // nothing is loaded until a delegate is created
+    EXPECT_FALSE(registry.isLoaded(manifest));
+    EXPECT_EQ(getMockModule(), nullptr);
+}
+
+TEST_F(DelegateRegistryTest, 02_parse_manifest)
+{
+    DR::Manifest manifest;
+    ASSERT_TRUE(DR::parseManifest(R"({ "name" : "A", "library" : "liba.so", "policies" : [ "MIN_RES", "AUTO_TUNE" ] })", "/opt", manifest));
+    EXPECT_EQ(manifest.name, "A");
+    EXPECT_EQ(manifest.library, "/opt/liba.so");
+    EXPECT_TRUE(manifest.customOps.empty());
+    EXPECT_EQ(manifest.policies, std::vector<APM::Policy>({APM::kMinRes, APM::kAutoTune}));
+    EXPECT_FALSE(manifest.shareable);
+
+    ASSERT_TRUE(DR::parseManifest(R"({ "name" : "B", "library" : "/usr/lib/libb.so", "custom_ops" : [ "b-op" ] })", "/opt", manifest));
+    EXPECT_EQ(manifest.library, "/usr/lib/libb.so");
+    EXPECT_EQ(manifest.customOps, std::vector<std::string>({"b-op"}));
+    EXPECT_TRUE(manifest.policies.empty());
+
+    ASSERT_TRUE(DR::parseManifest(R"({ "name" : "C", "library" : "libc.so", "custom_ops" : [ "c-op" ], "shareable" : true })", "/opt", manifest));
+    EXPECT_TRUE(manifest.shareable);
+
+    EXPECT_FALSE(DR::parseManifest("", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"([ "A" ])", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"({ "library" : "liba.so", "custom_ops" : [ "a-op" ] })", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"({ "name" : "A", "custom_ops" : [ "a-op" ] })", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"({ "name" : "A", "library" : "liba.so" })", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"({ "name" : "A", "library" : "liba.so", "custom_ops" : "a-op" })", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"({ "name" : "A", "library" : "liba.so", "policies" : [ "FASTEST" ] })", "/opt", manifest));
+    EXPECT_FALSE(DR::parseManifest(R"({ "name" : "A", "library" : "liba.so", "policies" : [ "MIN_RES" ], "shareable" : "yes" })", "/opt", manifest));
+}
+
+TEST_F(DelegateRegistryTest, 03_create_delegate)
+{
+    DR &registry = DR::getInstance();
+    DR::Manifest mock, broken;
+    ASSERT_TRUE(registry.find(plugin_dir, "MOCK", mock));
+    ASSERT_TRUE(registry.find(plugin_dir, "BROKEN", broken));
+
+    auto delegate = registry.createDelegate(mock, R"({"level":1})");
+    ASSERT_TRUE(delegate != nullptr);
+    EXPECT_TRUE(registry.isLoaded(mock));
+
+    void *module = getMockModule();
+    ASSERT_NE(module, nullptr);
+    int created = getMockCount(module, "aif_mock_delegate_plugin_get_created_num");
+    int destroyed = getMockCount(module, "aif_mock_delegate_plugin_get_destroyed_num");
+    EXPECT_GE(created, 1);
+    EXPECT_EQ(getMockLastOptions(module), R"({"level":1})");
+
+    // released through the module
+    delegate.reset();
+    EXPECT_EQ(getMockCount(module, "aif_mock_delegate_plugin_get_destroyed_num"), destroyed + 1);
+
+    EXPECT_TRUE(registry.createDelegate(mock, R"({"fail":true})") == nullptr);
+    EXPECT_EQ(getMockCount(module, "aif_mock_delegate_plugin_get_created_num"), created);
+
+    EXPECT_TRUE(registry.createDelegate(broken) == nullptr);
+    EXPECT_FALSE(registry.isLoaded(broken));
+    dlclose(module);
+}
+
+TEST_F(DelegateRegistryTest, 04_select_plugin_by_policy)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    ASSERT_TRUE(model != nullptr);
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+    APM apm = makeApm("MIN_LATENCY", R"({ "level" : 2 })");
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+    EXPECT_EQ(ads.getLastDecision().backends, std::vector<std::string>({"plugin:MOCK"}));
+
+    void *module = getMockModule();
+    ASSERT_NE(module, nullptr);
+    EXPECT_EQ(getMockLastOptions(module), R"({"level":2})");
+    dlclose(module);
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+
+    // the decision is replayed through the registry as well
+    std::unique_ptr<tflite::Interpreter> replayed;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&replayed), kTfLiteOk);
+    ADS replayAds;
+    EXPECT_TRUE(replayAds.applyDecision(*replayed, apm, ads.getLastDecision()));
+    EXPECT_EQ(replayAds.getLastDecision().backends, std::vector<std::string>({"plugin:MOCK"}));
+    EXPECT_EQ(replayed->AllocateTensors(), kTfLiteOk);
+
+    // without the plugin directory the built-in backends are used
+    std::unique_ptr<tflite::Interpreter> builtIn;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&builtIn), kTfLiteOk);
+    APM builtInApm(R"({ "policy" : "MIN_LATENCY", "delegate_plugins" : { "dir" : "" } })");
+    ADS builtInAds;
+    EXPECT_TRUE(builtInAds.selectDelegate(*builtIn, builtInApm));
+    const auto &backends = builtInAds.getLastDecision().backends;
+    EXPECT_TRUE(std::find(backends.begin(), backends.end(), "plugin:MOCK") == backends.end());
+}
+
+TEST_F(DelegateRegistryTest, 05_failed_plugin_falls_back)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    ASSERT_TRUE(model != nullptr);
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+
+    // BROKEN serves MAX_PRECISION but its library does not exist
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+    APM apm = makeApm("MAX_PRECISION");
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+    EXPECT_EQ(ads.getLastDecision().failedBackends, std::vector<std::string>({"plugin:BROKEN"}));
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+
+    // MOCK refuses to create its delegate
+    std::unique_ptr<tflite::Interpreter> refused;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&refused), kTfLiteOk);
+    APM refusedApm = makeApm("MIN_LATENCY", R"({ "fail" : true })");
+    ADS refusedAds;
+    EXPECT_TRUE(refusedAds.selectDelegate(*refused, refusedApm));
+    EXPECT_EQ(refusedAds.getLastDecision().failedBackends, std::vector<std::string>({"plugin:MOCK"}));
+}
+
+#ifndef USE_EDGETPU
+TEST_F(DelegateRegistryTest, 06_select_plugin_by_custom_op)
+{
+    // the custom op of an EdgeTPU compiled model goes to the plugin that declares it
+    std::string edgetpu_model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face-detector-quantized_edgetpu.tflite");
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(edgetpu_model_path.c_str());
+    ASSERT_TRUE(model != nullptr);
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+
+    APM apm = makeApm("CPU_ONLY");
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+    const auto &backends = ads.getLastDecision().backends;
+    ASSERT_FALSE(backends.empty());
+    EXPECT_EQ(backends[0], "plugin:MOCK");
+}
+#endif
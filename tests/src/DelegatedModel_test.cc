@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <DelegatedModel.h>
+#include <GraphTester.h>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+
+class DelegatedModelTest : public ::testing::Test
+{
+protected:
+    DelegatedModelTest() = default;
+    ~DelegatedModelTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(DelegatedModelTest, 01_cpu_only)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kCPUOnly));
+    DelegatedModel delegatedModel(model, apm);
+    EXPECT_TRUE(delegatedModel.init());
+    EXPECT_FALSE(delegatedModel.waitForAcceleration());
+
+    for (int i = 0; i < 2; i++)
+    {
+        auto session = delegatedModel.acquire();
+        ASSERT_TRUE(session.isValid());
+        EXPECT_FALSE(session.isAccelerated());
+
+        GraphTester graphTester(session.interpreter());
+        EXPECT_TRUE(graphTester.fillRandomInputTensor());
+        EXPECT_EQ(session.invoke(), kTfLiteOk);
+    }
+}
+
+TEST_F(DelegatedModelTest, 02_serve_before_and_after_swap)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "AUTO_TUNE", "auto_tune" : { "warmup_runs" : 1, "runs" : 2 } })");
+    DelegatedModel delegatedModel(model, apm);
+    EXPECT_TRUE(delegatedModel.init());
+
+    {
+        auto session = delegatedModel.acquire();
+        ASSERT_TRUE(session.isValid());
+
+        GraphTester graphTester(session.interpreter());
+        EXPECT_TRUE(graphTester.fillRandomInputTensor());
+        EXPECT_EQ(session.invoke(), kTfLiteOk);
+    }
+
+    bool accelerated = delegatedModel.waitForAcceleration();
+
+    auto session = delegatedModel.acquire();
+    ASSERT_TRUE(session.isValid());
+    EXPECT_EQ(session.isAccelerated(), accelerated);
+    EXPECT_EQ(delegatedModel.isAccelerated(), accelerated);
+
+    GraphTester graphTester(session.interpreter());
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+    EXPECT_EQ(session.invoke(), kTfLiteOk);
+}
+
+TEST_F(DelegatedModelTest, 03_null_model)
+{
+    APM apm;
+    DelegatedModel delegatedModel(nullptr, apm);
+    EXPECT_FALSE(delegatedModel.init());
+
+    auto session = delegatedModel.acquire();
+    EXPECT_FALSE(session.isValid());
+    EXPECT_EQ(session.invoke(), kTfLiteError);
+}
+
+TEST_F(DelegatedModelTest, 04_bind_caller_buffers)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kCPUOnly));
+    DelegatedModel delegatedModel(model, apm);
+    ASSERT_TRUE(delegatedModel.init());
+
+    auto session = delegatedModel.acquire();
+    ASSERT_TRUE(session.isValid());
+    tflite::Interpreter &interpreter = session.interpreter();
+    TfLiteTensor *input = interpreter.tensor(interpreter.inputs()[0]);
+    TfLiteTensor *output = interpreter.tensor(interpreter.outputs()[0]);
+
+    // the copying path gives the expected output
+    GraphTester graphTester(interpreter);
+    EXPECT_TRUE(graphTester.fillRandomInputTensor());
+    std::vector<uint8_t> frame(input->data.raw, input->data.raw + input->bytes);
+    ASSERT_EQ(session.invoke(), kTfLiteOk);
+    std::vector<uint8_t> expected(output->data.raw, output->data.raw + output->bytes);
+
+    size_t inputBytes = input->bytes;
+    size_t outputBytes = output->bytes;
+    void *inputBuffer = nullptr;
+    void *otherInputBuffer = nullptr;
+    void *outputBuffer = nullptr;
+    ASSERT_EQ(posix_memalign(&inputBuffer, DelegatedModel::kTensorAlignment, inputBytes + DelegatedModel::kTensorAlignment), 0);
+    ASSERT_EQ(posix_memalign(&otherInputBuffer, DelegatedModel::kTensorAlignment, inputBytes), 0);
+    ASSERT_EQ(posix_memalign(&outputBuffer, DelegatedModel::kTensorAlignment, outputBytes), 0);
+
+    // misaligned, too small or nonexistent bindings are refused
+    EXPECT_FALSE(session.bindInput(0, static_cast<uint8_t *>(inputBuffer) + 1, inputBytes));
+    EXPECT_FALSE(session.bindInput(0, inputBuffer, inputBytes - 1));
+    EXPECT_FALSE(session.bindInput(static_cast<int>(interpreter.inputs().size()), inputBuffer, inputBytes));
+    EXPECT_FALSE(session.bindOutput(-1, outputBuffer, outputBytes));
+
+    memcpy(inputBuffer, frame.data(), inputBytes);
+    ASSERT_TRUE(session.bindInput(0, inputBuffer, inputBytes));
+    ASSERT_TRUE(session.bindOutput(0, outputBuffer, outputBytes));
+    EXPECT_EQ(interpreter.tensor(interpreter.inputs()[0])->data.raw, inputBuffer);
+    EXPECT_EQ(interpreter.tensor(interpreter.outputs()[0])->data.raw, outputBuffer);
+
+    memset(outputBuffer, 0, outputBytes);
+    ASSERT_EQ(session.invoke(), kTfLiteOk);
+    EXPECT_EQ(memcmp(outputBuffer, expected.data(), outputBytes), 0);
+
+    // the next frame is only a rebind
+    memcpy(otherInputBuffer, frame.data(), inputBytes);
+    ASSERT_TRUE(session.bindInput(0, otherInputBuffer, inputBytes));
+    EXPECT_EQ(interpreter.tensor(interpreter.inputs()[0])->data.raw, otherInputBuffer);
+    memset(outputBuffer, 0, outputBytes);
+    ASSERT_EQ(session.invoke(), kTfLiteOk);
+    EXPECT_EQ(memcmp(outputBuffer, expected.data(), outputBytes), 0);
+
+    free(inputBuffer);
+    free(otherInputBuffer);
+    free(outputBuffer);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <AutoDelegateSelector.h>
+#include <DelegationStats.h>
+#include <GraphTester.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+
+class DelegationStatsTest : public ::testing::Test
+{
+protected:
+    DelegationStatsTest() = default;
+    ~DelegationStatsTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(DelegationStatsTest, 01_latency_buckets)
+{
+    EXPECT_EQ(DelegationStats::getLatencyBucket(0), 0);
+    EXPECT_EQ(DelegationStats::getLatencyBucket(1), 0);
+    EXPECT_EQ(DelegationStats::getLatencyBucket(2), 1);
+    EXPECT_EQ(DelegationStats::getLatencyBucket(3), 1);
+    EXPECT_EQ(DelegationStats::getLatencyBucket(1024), 10);
+    EXPECT_EQ(DelegationStats::getLatencyBucket(UINT64_MAX), DelegationStats::kLatencyBucketNum - 1);
+
+    EXPECT_EQ(DelegationStats::getLatencyBucketUpperUs(0), 1);
+    EXPECT_EQ(DelegationStats::getLatencyBucketUpperUs(10), 2047);
+}
+
+TEST_F(DelegationStatsTest, 02_invoke_histogram)
+{
+    DelegationStats stats;
+    for (int i = 0; i < 90; i++)
+    {
+        stats.recordInvoke(100, true);
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        stats.recordInvoke(5000, true);
+    }
+    stats.recordInvoke(0, false);
+
+    auto snapshot = stats.snapshot();
+    EXPECT_EQ(snapshot.invoke_count, 100);
+    EXPECT_EQ(snapshot.failed_invoke_count, 1);
+    EXPECT_EQ(snapshot.total_latency_us, 90 * 100 + 10 * 5000);
+    EXPECT_EQ(snapshot.max_latency_us, 5000);
+    EXPECT_EQ(snapshot.latency_histogram[DelegationStats::getLatencyBucket(100)], 90);
+
+    // percentiles are reported as the upper bound of their bucket
+    EXPECT_EQ(snapshot.getPercentileUs(50.0), DelegationStats::getLatencyBucketUpperUs(DelegationStats::getLatencyBucket(100)));
+    EXPECT_EQ(snapshot.getPercentileUs(90.0), DelegationStats::getLatencyBucketUpperUs(DelegationStats::getLatencyBucket(100)));
+    EXPECT_EQ(snapshot.getPercentileUs(99.0), 5000);
+
+    DelegationStats empty;
+    EXPECT_EQ(empty.snapshot().getPercentileUs(50.0), 0);
+}
+
+TEST_F(DelegationStatsTest, 03_concurrent_record_and_read)
+{
+    DelegationStats stats;
+    std::atomic<bool> done(false);
+
+    std::thread reader([&]() {
+        while (!done)
+        {
+            auto snapshot = stats.snapshot();
+            // a delegation record is never seen half written
+            EXPECT_EQ(snapshot.delegation.node_num, snapshot.delegation.cpu_node_num * 2);
+        }
+    });
+
+    std::vector<std::thread> invokers;
+    for (int t = 0; t < 4; t++)
+    {
+        invokers.emplace_back([&]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                stats.recordInvoke(i, true);
+            }
+        });
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        stats.recordDelegation({0, 0, i, i * 2, i, 0, 0, false, true});
+    }
+    for (auto &invoker : invokers)
+    {
+        invoker.join();
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(stats.getInvokeCount(), 4000);
+    EXPECT_EQ(stats.snapshot().delegation_count, 1000);
+    EXPECT_EQ(stats.snapshot().max_latency_us, 999);
+}
+
+TEST_F(DelegationStatsTest, 04_selectDelegate_records_delegation)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter);
+    int nodeNum = interpreter->primary_subgraph().execution_plan().size();
+
+    auto stats = std::make_shared<DelegationStats>();
+    APM apm;
+    AutoDelegateSelector ads;
+    ads.setStats(stats);
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+
+    auto snapshot = stats->snapshot();
+    EXPECT_EQ(snapshot.delegation_count, 1);
+    EXPECT_TRUE(snapshot.delegation.result);
+    EXPECT_FALSE(snapshot.delegation.accelerated);
+    EXPECT_FALSE(stats->isAccelerated());
+    EXPECT_EQ(snapshot.delegation.node_num, nodeNum);
+    EXPECT_GE(snapshot.delegation.partition_num, 1);
+    EXPECT_EQ(snapshot.fallback_count, 0);
+#ifdef USE_XNNPACK
+    EXPECT_NE(snapshot.delegation.backend_mask & (1u << AutoDelegateSelector::kBackendXNNPack), 0);
+    EXPECT_EQ(snapshot.delegation.delegated_partition_num, 1);
+#else
+    EXPECT_EQ(snapshot.delegation.backend_mask, 0);
+    EXPECT_EQ(snapshot.delegation.cpu_node_num, nodeNum);
+#endif
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    GraphTester graphTester(*interpreter.get());
+    graphTester.fillRandomInputTensor();
+    EXPECT_EQ(stats->invoke(*interpreter), kTfLiteOk);
+    EXPECT_EQ(stats->getInvokeCount(), 1);
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <DeviceCapabilities.h>
+#include <DelegateDecisionCache.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace aif;
+
+typedef DeviceCapabilities DC;
+
+// Describes a device with an IMG GPU, one LITTLE and one big cluster, without a real GPU.
+class FakeProber : public DC::Prober
+{
+public:
+    FakeProber(std::atomic<int> &probeNum, const std::string &fingerprint = "fake-device", bool fail = false,
+               std::atomic<int> *cpuProbeNum = nullptr)
+        : m_probeNum(probeNum), m_cpuProbeNum(cpuProbeNum), m_fingerprint(fingerprint), m_fail(fail)
+    {
+    }
+
+    std::string getFingerprint() override
+    {
+        return m_fingerprint;
+    }
+
+    bool probeCpu(DC::Capabilities &capabilities) override
+    {
+        if (m_cpuProbeNum != nullptr)
+        {
+            (*m_cpuProbeNum)++;
+        }
+        capabilities.cpuArch = "aarch64";
+        capabilities.cpuFeatures = {"fp", "asimd", "asimddp"};
+        capabilities.cpuCoreNum = 6;
+        capabilities.cpuClusters = {{1800000, 4}, {2400000, 2}};
+        return true;
+    }
+
+    bool probeAccelerators(DC::Capabilities &capabilities) override
+    {
+        m_probeNum++;
+        if (m_fail)
+        {
+            return false;
+        }
+        capabilities.gpuVendor = "Imagination Technologies";
+        capabilities.gpuName = "PowerVR B-Series BXE-4-32";
+        capabilities.gpuDriverVersion = "1.17@6210866";
+        capabilities.openCLVersion = "OpenCL 3.0";
+        capabilities.hasNPU = true;
+        capabilities.hasEdgeTPU = false;
+        return true;
+    }
+
+private:
+    std::atomic<int> &m_probeNum;      // of the accelerators
+    std::atomic<int> *m_cpuProbeNum;
+    std::string m_fingerprint;
+    bool m_fail;
+};
+
+class DeviceCapabilitiesTest : public ::testing::Test
+{
+protected:
+    DeviceCapabilitiesTest() = default;
+    ~DeviceCapabilitiesTest() = default;
+
+    void SetUp() override
+    {
+        probe_num = 0;
+        std::remove(cache_path.c_str());
+    }
+
+    void TearDown() override
+    {
+        std::remove(cache_path.c_str());
+        // back to the real device for the other tests
+        DC::getInstance().configure(nullptr, DC::getDefaultCachePath());
+    }
+
+    std::atomic<int> probe_num{0};
+    std::string cache_path = std::string(AIF_INSTALL_DIR) + std::string("/device_capabilities_test.json");
+};
+
+TEST_F(DeviceCapabilitiesTest, 01_fake_device)
+{
+    DC &capabilities = DC::getInstance();
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num)), "");
+
+    DC::Capabilities caps = capabilities.get();
+    EXPECT_EQ(caps.fingerprint, "fake-device");
+    EXPECT_EQ(caps.cpuArch, "aarch64");
+    EXPECT_EQ(caps.gpuName, "PowerVR B-Series BXE-4-32");
+    EXPECT_TRUE(caps.hasNPU);
+    EXPECT_FALSE(caps.hasEdgeTPU);
+
+    EXPECT_TRUE(capabilities.isGpuVendorIMG());
+    EXPECT_TRUE(capabilities.hasCpuFeature("asimddp"));
+    EXPECT_FALSE(capabilities.hasCpuFeature("sve"));
+    EXPECT_EQ(capabilities.getBigCoreNum(), 2);
+    EXPECT_EQ(capabilities.getLittleCoreNum(), 4);
+    EXPECT_EQ(DelegateDecisionCache::getDeviceFingerprint(), "fake-device");
+    EXPECT_EQ(probe_num, 1);
+}
+
+TEST_F(DeviceCapabilitiesTest, 02_probe_once_across_threads)
+{
+    DC &capabilities = DC::getInstance();
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num)), "");
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&capabilities]() {
+            EXPECT_TRUE(capabilities.isGpuVendorIMG());
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(probe_num, 1);
+}
+
+TEST_F(DeviceCapabilitiesTest, 03_cache_file)
+{
+    DC &capabilities = DC::getInstance();
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num)), cache_path);
+    EXPECT_EQ(capabilities.get().cpuCoreNum, 6);
+    EXPECT_EQ(probe_num, 1);
+
+    // another process of the same device reads the file instead of probing
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num)), cache_path);
+    DC::Capabilities caps = capabilities.get();
+    EXPECT_EQ(probe_num, 1);
+    EXPECT_EQ(caps.cpuFeatures, std::vector<std::string>({"fp", "asimd", "asimddp"}));
+    ASSERT_EQ(caps.cpuClusters.size(), 2u);
+    EXPECT_EQ(caps.cpuClusters[1].maxFrequency, 2400000);
+    EXPECT_EQ(caps.cpuClusters[1].coreNum, 2);
+    EXPECT_EQ(caps.openCLVersion, "OpenCL 3.0");
+
+    // a driver update changes the fingerprint, so the file is not used
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num, "updated-device")), cache_path);
+    EXPECT_EQ(capabilities.getFingerprint(), "updated-device");
+    EXPECT_EQ(probe_num, 1);
+    EXPECT_EQ(capabilities.get().fingerprint, "updated-device");
+    EXPECT_EQ(probe_num, 2);
+}
+
+TEST_F(DeviceCapabilitiesTest, 04_probe_failure)
+{
+    DC &capabilities = DC::getInstance();
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num, "fake-device", true)), cache_path);
+    EXPECT_FALSE(capabilities.isGpuVendorIMG());
+    EXPECT_TRUE(capabilities.get().gpuVendor.empty());
+    // the CPU was probed on its own
+    EXPECT_EQ(capabilities.getCpuCoreNum(), 6);
+    EXPECT_EQ(probe_num, 1);
+
+    // nothing was stored, the next process probes again
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num)), cache_path);
+    EXPECT_TRUE(capabilities.isGpuVendorIMG());
+    EXPECT_EQ(probe_num, 2);
+}
+
+TEST_F(DeviceCapabilitiesTest, 05_parse)
+{
+    DC::Capabilities caps;
+    EXPECT_FALSE(DC::parse("", caps));
+    EXPECT_FALSE(DC::parse(R"({ "version" : 0, "fingerprint" : "a", "cpu_core_num" : 1 })", caps));
+    EXPECT_FALSE(DC::parse(R"({ "version" : 1, "cpu_core_num" : 1 })", caps));
+    EXPECT_FALSE(DC::parse(R"({ "version" : 1, "fingerprint" : "a", "cpu_core_num" : 1, "cpu_clusters" : [ 1 ] })", caps));
+
+    ASSERT_TRUE(DC::parse(R"({ "version" : 1, "fingerprint" : "a", "cpu_core_num" : 4 })", caps));
+    EXPECT_EQ(caps.fingerprint, "a");
+    EXPECT_EQ(caps.cpuCoreNum, 4);
+    EXPECT_TRUE(caps.cpuClusters.empty());
+    EXPECT_TRUE(caps.gpuVendor.empty());
+    EXPECT_FALSE(caps.hasNPU);
+}
+
+TEST_F(DeviceCapabilitiesTest, 06_system_device)
+{
+    DC &capabilities = DC::getInstance();
+    capabilities.configure(nullptr, cache_path);
+    DC::Capabilities caps = capabilities.get();
+    EXPECT_FALSE(caps.fingerprint.empty());
+    EXPECT_FALSE(caps.cpuArch.empty());
+    EXPECT_GT(caps.cpuCoreNum, 0);
+    EXPECT_GT(capabilities.getBigCoreNum(), 0);
+    EXPECT_GT(capabilities.getLittleCoreNum(), 0);
+    EXPECT_EQ(capabilities.getFingerprint(), DelegateDecisionCache::getDeviceFingerprint());
+}
+
+TEST_F(DeviceCapabilitiesTest, 07_cpu_queries_do_not_probe_accelerators)
+{
+    std::atomic<int> cpu_probe_num{0};
+    DC &capabilities = DC::getInstance();
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num, "fake-device", false, &cpu_probe_num)), cache_path);
+    EXPECT_EQ(capabilities.getCpuCoreNum(), 6);
+    EXPECT_EQ(capabilities.getBigCoreNum(), 2);
+    EXPECT_EQ(capabilities.getLittleCoreNum(), 4);
+    EXPECT_TRUE(capabilities.hasCpuFeature("asimd"));
+    EXPECT_EQ(cpu_probe_num, 1);
+    EXPECT_EQ(probe_num, 0);
+
+    // a GPU query probes the accelerators, and the CPU is not probed again
+    EXPECT_TRUE(capabilities.isGpuVendorIMG());
+    EXPECT_EQ(cpu_probe_num, 1);
+    EXPECT_EQ(probe_num, 1);
+
+    // the CPU queries of another process read the stored file
+    capabilities.configure(std::unique_ptr<DC::Prober>(new FakeProber(probe_num, "fake-device", false, &cpu_probe_num)), cache_path);
+    EXPECT_EQ(capabilities.getCpuCoreNum(), 6);
+    EXPECT_TRUE(capabilities.isGpuVendorIMG());
+    EXPECT_EQ(cpu_probe_num, 1);
+    EXPECT_EQ(probe_num, 1);
+}
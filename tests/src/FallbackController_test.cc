@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <FallbackController.h>
+
+#include <cstdlib>
+#include <functional>
+
+using namespace aif;
+
+class FallbackControllerTest : public ::testing::Test
+{
+protected:
+    FallbackControllerTest() = default;
+    ~FallbackControllerTest() = default;
+
+    // Invokes with latencies from model at the serving percentage, and re-delegates at once
+    // with costUs whenever the controller asks for it.
+    static void run(FallbackController &controller, int invokes, const std::function<double(int)> &model,
+                    double costUs = 1000.0)
+    {
+        for (int i = 0; i < invokes; i++)
+        {
+            if (controller.onInvoke(model(controller.getServingPercentage())))
+            {
+                controller.onRedelegated(costUs, true);
+            }
+        }
+    }
+
+    // GPU and CPU are balanced best at 30%
+    static double bowl(int percentage)
+    {
+        return 10000.0 + 40.0 * (percentage - 30) * (percentage - 30);
+    }
+
+    AccelerationPolicyManager::AdaptiveFallback options = {true, 20, 30, 0.05, 0.05};
+};
+
+TEST_F(FallbackControllerTest, 01_converges_near_the_minimum)
+{
+    FallbackController controller(0, options);
+    run(controller, 20000, bowl);
+
+    EXPECT_TRUE(controller.isConverged());
+    EXPECT_NEAR(controller.getServingPercentage(), 30, 5);
+    EXPECT_GT(controller.getRedelegationCount(), 0);
+
+    FallbackController fromTop(100, options);
+    run(fromTop, 20000, bowl);
+
+    EXPECT_TRUE(fromTop.isConverged());
+    EXPECT_NEAR(fromTop.getServingPercentage(), 30, 5);
+}
+
+TEST_F(FallbackControllerTest, 02_hysteresis_ignores_noise)
+{
+    std::srand(17);
+    auto noisy = [](int) {
+        return 10000.0 * (1.0 + 0.02 * (std::rand() / static_cast<double>(RAND_MAX) - 0.5));
+    };
+
+    FallbackController controller(50, options);
+    run(controller, 20000, noisy);
+
+    // nothing is better by more than the hysteresis, so the search ends after a few turns
+    // and the noise never restarts it
+    EXPECT_TRUE(controller.isConverged());
+    EXPECT_LE(controller.getRedelegationCount(), 12);
+    EXPECT_NEAR(controller.getServingPercentage(), 50, 20);
+}
+
+TEST_F(FallbackControllerTest, 03_budget_limits_redelegation)
+{
+    // every re-delegation costs as much as 1000 invokes, with a budget of 5% of the serving time
+    FallbackController controller(0, options);
+    run(controller, 2000, bowl, 1000 * bowl(30));
+
+    EXPECT_FALSE(controller.isConverged());
+    EXPECT_LE(controller.getRedelegationCount(), 1);
+
+    AccelerationPolicyManager::AdaptiveFallback noBudget = options;
+    noBudget.redelegation_budget = 0.0;
+    FallbackController frozen(0, noBudget);
+    run(frozen, 2000, bowl);
+
+    EXPECT_EQ(frozen.getRedelegationCount(), 0);
+    EXPECT_EQ(frozen.getServingPercentage(), 0);
+}
+
+TEST_F(FallbackControllerTest, 04_drift_restarts_the_search)
+{
+    FallbackController controller(0, options);
+    run(controller, 20000, bowl);
+    ASSERT_TRUE(controller.isConverged());
+    ASSERT_NEAR(controller.getServingPercentage(), 30, 5);
+
+    // the GPU got busy, so more should stay on the CPU
+    auto busyGpu = [](int percentage) {
+        return 12000.0 + 40.0 * (percentage - 70) * (percentage - 70);
+    };
+    run(controller, 40000, busyGpu);
+
+    EXPECT_TRUE(controller.isConverged());
+    EXPECT_NEAR(controller.getServingPercentage(), 70, 5);
+}
+
+TEST_F(FallbackControllerTest, 05_failed_redelegation_keeps_serving)
+{
+    FallbackController controller(30, options);
+    for (int i = 0; i < 100; i++)
+    {
+        if (controller.onInvoke(bowl(controller.getServingPercentage())))
+        {
+            int candidate = controller.getPercentage();
+            EXPECT_NE(candidate, 30);
+            controller.onRedelegated(1000.0, false);
+            EXPECT_EQ(controller.getServingPercentage(), 30);
+        }
+    }
+    EXPECT_EQ(controller.getServingPercentage(), 30);
+}
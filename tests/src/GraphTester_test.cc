@@ -47,10 +47,17 @@ TEST_F(GraphTesterTest, 01_graphTester_fdshort_CpuOnly)
     ADS ads;
     EXPECT_TRUE(ads.selectDelegate(*interpreter.get(), apm));
 
+#ifdef USE_XNNPACK
+    EXPECT_EQ(graphTester.getTotalNodeNum(), 1);
+    EXPECT_EQ(graphTester.getDelegatedPartitionNum(), 1);
+    EXPECT_EQ(graphTester.getTotalPartitionNum(), 1);
+    EXPECT_TRUE(graphTester.isDelegated());
+#else
     EXPECT_EQ(graphTester.getTotalNodeNum(), 164);
     EXPECT_EQ(graphTester.getDelegatedPartitionNum(), 0);
     EXPECT_EQ(graphTester.getTotalPartitionNum(), 1);
     EXPECT_FALSE(graphTester.isDelegated());
+#endif
 
     EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <tools/Hash.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace aif;
+
+class HashTest : public ::testing::Test
+{
+protected:
+    HashTest() = default;
+    ~HashTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+};
+
+TEST_F(HashTest, 01_hash64_known_values)
+{
+    EXPECT_EQ(hash64("", 0), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(hashToString(hash64("", 0)), "ef46db3751d8e999");
+    EXPECT_EQ(hash64("a", 1), 0xD24EC4F1A98C6E5BULL);
+
+    // 32 bytes and more go through the stripes and their merge
+    const std::string spam = "Nobody inspects the spammish repetition";
+    EXPECT_EQ(hash64(spam.data(), spam.size()), 0xFBCEA83C8A378BF1ULL);
+    EXPECT_EQ(hash64(spam.data(), spam.size(), 42), 0x44582824CA1018B5ULL);
+    const std::string alnum = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    EXPECT_EQ(hash64(alnum.data(), alnum.size()), 0xFD5E2CE9520872DDULL);
+    EXPECT_EQ(hash64(alnum.data(), alnum.size(), 0x9E3779B185EBCA87ULL), 0xB7CA4BC915E75DE1ULL);
+}
+
+TEST_F(HashTest, 02_streaming_matches_one_shot)
+{
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    for (size_t chunk : {1, 5, 31, 32, 33, 100, 1000})
+    {
+        Hash64 hash(42);
+        for (size_t offset = 0; offset < data.size(); offset += chunk)
+        {
+            hash.update(data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+        EXPECT_EQ(hash.digest(), 0xEBBB006470311EBCULL) << "chunk " << chunk;
+    }
+    EXPECT_EQ(hash64(data.data(), data.size(), 42), 0xEBBB006470311EBCULL);
+
+    Hash64 hash;
+    hash.update(std::string("model"));
+    hash.update(std::string("token"));
+    EXPECT_EQ(hash.digest(), hash64("modeltoken", 10));
+}
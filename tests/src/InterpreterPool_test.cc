@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <InterpreterPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+
+class InterpreterPoolTest : public ::testing::Test
+{
+protected:
+    InterpreterPoolTest() = default;
+    ~InterpreterPoolTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(InterpreterPoolTest, 01_checkout_and_return)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "pool" : { "size" : 3 } })");
+    EXPECT_EQ(apm.getPoolSize(), 3);
+
+    InterpreterPool pool(model, apm);
+    EXPECT_TRUE(pool.init());
+    EXPECT_EQ(pool.size(), 3);
+    EXPECT_EQ(pool.getAvailableNum(), 3);
+
+    {
+        auto first = pool.tryAcquire();
+        auto second = pool.tryAcquire();
+        auto third = pool.tryAcquire();
+        EXPECT_TRUE(first.isValid());
+        EXPECT_TRUE(second.isValid());
+        EXPECT_TRUE(third.isValid());
+        EXPECT_NE(&first.interpreter(), &second.interpreter());
+        EXPECT_NE(&second.interpreter(), &third.interpreter());
+        EXPECT_EQ(pool.getAvailableNum(), 0);
+
+        EXPECT_FALSE(pool.tryAcquire().isValid());
+
+        second.release();
+        EXPECT_FALSE(second.isValid());
+        EXPECT_EQ(pool.getAvailableNum(), 1);
+
+        auto fourth = pool.tryAcquire();
+        EXPECT_TRUE(fourth.isValid());
+    }
+    EXPECT_EQ(pool.getAvailableNum(), 3);
+}
+
+TEST_F(InterpreterPoolTest, 02_concurrent_invoke)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm;
+    EXPECT_TRUE(apm.setPolicy(APM::kCPUOnly));
+    apm.setPoolSize(2);
+    InterpreterPool pool(model, apm);
+    EXPECT_TRUE(pool.init());
+
+    std::atomic<int> failures(0);
+    std::atomic<int> inUse(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++)
+    {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < 5; i++)
+            {
+                auto lease = pool.acquire();
+                if (!lease.isValid() || ++inUse > pool.size())
+                {
+                    failures++;
+                }
+
+                TfLiteTensor *input = lease.interpreter().input_tensor(0);
+                memset(input->data.raw, 0, input->bytes);
+                if (lease.interpreter().Invoke() != kTfLiteOk)
+                {
+                    failures++;
+                }
+                inUse--;
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(pool.getAvailableNum(), 2);
+}
+
+TEST_F(InterpreterPoolTest, 03_auto_size)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "pool" : { "size" : "auto" } })");
+    InterpreterPool pool(model, apm);
+    EXPECT_TRUE(pool.init());
+    EXPECT_GT(pool.size(), 0);
+}
+
+TEST_F(InterpreterPoolTest, 04_not_initialized)
+{
+    APM apm;
+    InterpreterPool pool(nullptr, apm);
+    EXPECT_FALSE(pool.init());
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_FALSE(pool.tryAcquire().isValid());
+    EXPECT_FALSE(pool.acquire().isValid());
+}
+
+TEST_F(InterpreterPoolTest, 05_acquire_waits_for_release)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "pool" : { "size" : 1 } })");
+    InterpreterPool pool(model, apm);
+    ASSERT_TRUE(pool.init());
+
+    auto lease = pool.tryAcquire();
+    ASSERT_TRUE(lease.isValid());
+
+    std::atomic<bool> acquired(false);
+    std::thread waiter([&pool, &acquired]() {
+        auto waited = pool.acquire();
+        acquired = waited.isValid();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(acquired);
+
+    lease.release();
+    waiter.join();
+    EXPECT_TRUE(acquired);
+    EXPECT_EQ(pool.getAvailableNum(), 1);
+}
+
+TEST_F(InterpreterPoolTest, 06_acquire_stress_single_interpreter)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "pool" : { "size" : 1 } })");
+    InterpreterPool pool(model, apm);
+    ASSERT_TRUE(pool.init());
+
+    // a release() that misses a waiter leaves it asleep for good, and the test hangs
+    std::atomic<int> failures(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 6; t++)
+    {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < 2000; i++)
+            {
+                auto lease = pool.acquire();
+                if (!lease.isValid())
+                {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(pool.getAvailableNum(), 1);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <tools/MemoryUsage.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include <tensorflow/lite/kernels/register.h>
+#include <unistd.h>
+
+using namespace aif;
+
+class MemoryUsageTest : public ::testing::Test
+{
+protected:
+    MemoryUsageTest() = default;
+    ~MemoryUsageTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+        std::remove(statm_path.c_str());
+    }
+
+    std::string statm_path = std::string(AIF_INSTALL_DIR) + std::string("/statm_test");
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(MemoryUsageTest, 01_resident_bytes)
+{
+    EXPECT_GT(MemoryUsage::getResidentBytes(), 0);
+
+    std::ofstream(statm_path) << "1000 25 10 1 0 100 0\n";
+    EXPECT_EQ(MemoryUsage::getResidentBytes(statm_path), 25 * sysconf(_SC_PAGESIZE));
+
+    EXPECT_EQ(MemoryUsage::getResidentBytes(statm_path + "_missing"), -1);
+}
+
+TEST_F(MemoryUsageTest, 02_cost)
+{
+    MemoryUsage::Footprint footprint = {{1000, 200, 30, 5000}, -1};
+    // read-only weights are mapped from the model and not counted
+    EXPECT_EQ(MemoryUsage::getCost(footprint), 1230);
+
+    footprint.rss_delta_bytes = 4096;
+    EXPECT_EQ(MemoryUsage::getCost(footprint), 4096);
+
+    footprint.rss_delta_bytes = 100;
+    EXPECT_EQ(MemoryUsage::getCost(footprint), 1230);
+}
+
+TEST_F(MemoryUsageTest, 03_tensor_memory)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter);
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+    auto memory = MemoryUsage::getTensorMemory(*interpreter);
+    EXPECT_GT(memory.arena_bytes, 0);
+    EXPECT_GT(memory.read_only_bytes + memory.persistent_bytes, 0);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <AutoDelegateSelector.h>
+#include <InterpreterPool.h>
+#include <ModelLoader.h>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+typedef AutoDelegateSelector ADS;
+
+class ModelLoaderTest : public ::testing::Test
+{
+protected:
+    ModelLoaderTest() = default;
+    ~ModelLoaderTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(ModelLoaderTest, 01_load_shares_one_mapping)
+{
+    int loadedNum = ModelLoader::getLoadedNum();
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "model_loading" : { "populate" : true, "advice" : "willneed" } })");
+    std::shared_ptr<tflite::FlatBufferModel> model = ModelLoader::load(model_path, apm);
+    ASSERT_TRUE(model != nullptr);
+    EXPECT_TRUE(model->initialized());
+    EXPECT_EQ(ModelLoader::getLoadedNum(), loadedNum + 1);
+
+    std::shared_ptr<tflite::FlatBufferModel> sameModel = ModelLoader::load(model_path, apm);
+    EXPECT_EQ(model.get(), sameModel.get());
+    EXPECT_EQ(ModelLoader::getLoadedNum(), loadedNum + 1);
+
+    model.reset();
+    sameModel.reset();
+    EXPECT_EQ(ModelLoader::getLoadedNum(), loadedNum);
+}
+
+TEST_F(ModelLoaderTest, 02_load_invalid_files)
+{
+    APM apm;
+    EXPECT_TRUE(ModelLoader::load("/nonexistent/model.tflite", apm) == nullptr);
+
+    std::string emptyPath = "/tmp/model_loader_test_empty.tflite";
+    std::ofstream(emptyPath).close();
+    EXPECT_TRUE(ModelLoader::load(emptyPath, apm) == nullptr);
+
+    std::string invalidPath = "/tmp/model_loader_test_invalid.tflite";
+    std::ofstream(invalidPath) << "this is not a flatbuffer model";
+    EXPECT_TRUE(ModelLoader::load(invalidPath, apm) == nullptr);
+
+    std::remove(emptyPath.c_str());
+    std::remove(invalidPath.c_str());
+}
+
+TEST_F(ModelLoaderTest, 03_select_delegate_with_loaded_model)
+{
+    APM apm(R"({ "policy" : "CPU_ONLY", "pool" : { "size" : 2 } })");
+    std::shared_ptr<tflite::FlatBufferModel> model = ModelLoader::load(model_path, apm);
+    ASSERT_TRUE(model != nullptr);
+
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+
+    ADS ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm, *model));
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+
+    InterpreterPool pool(ModelLoader::load(model_path, apm), apm);
+    EXPECT_TRUE(pool.init());
+    auto lease = pool.acquire();
+    EXPECT_EQ(lease.invoke(), kTfLiteOk);
+}
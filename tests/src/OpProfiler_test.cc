@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <AutoDelegateSelector.h>
+#include <GraphTester.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+
+class OpProfilerTest : public ::testing::Test
+{
+protected:
+    OpProfilerTest() = default;
+    ~OpProfilerTest() = default;
+
+    void SetUp() override
+    {
+        std::remove(report_path.c_str());
+    }
+
+    void TearDown() override
+    {
+        std::remove(report_path.c_str());
+    }
+
+    std::unique_ptr<tflite::Interpreter> buildInterpreter(const tflite::FlatBufferModel &model)
+    {
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        tflite::InterpreterBuilder(model, resolver)(&interpreter);
+        return interpreter;
+    }
+
+    std::string report_path = std::string(AIF_INSTALL_DIR) + std::string("/op_profile_test.json");
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(OpProfilerTest, 01_profiling_disabled)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    auto interpreter = buildInterpreter(*model);
+
+    APM apm;
+    AutoDelegateSelector ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+    EXPECT_EQ(interpreter->GetProfiler(), nullptr);
+}
+
+TEST_F(OpProfilerTest, 02_hotspots)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    auto interpreter = buildInterpreter(*model);
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "profiling" : { "enabled" : true } })");
+    AutoDelegateSelector ads;
+    EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+
+    OpProfiler *profiler = dynamic_cast<OpProfiler *>(interpreter->GetProfiler());
+    ASSERT_NE(profiler, nullptr);
+
+    EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    GraphTester graphTester(*interpreter.get());
+    graphTester.fillRandomInputTensor();
+
+    const int invokeNum = 3;
+    for (int i = 0; i < invokeNum; i++)
+    {
+        EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    }
+
+    EXPECT_EQ(profiler->getInvokeCount(), invokeNum);
+    auto hotspots = profiler->getHotspots();
+    EXPECT_EQ(hotspots.size(), interpreter->primary_subgraph().execution_plan().size());
+    for (size_t i = 0; i < hotspots.size(); i++)
+    {
+        EXPECT_EQ(hotspots[i].count, invokeNum);
+        EXPECT_FALSE(hotspots[i].op_name.empty());
+        EXPECT_LE(hotspots[i].min_us, hotspots[i].max_us);
+        if (i > 0)
+        {
+            EXPECT_GE(hotspots[i - 1].total_us, hotspots[i].total_us);
+        }
+        if (hotspots[i].op_name == "DELEGATE")
+        {
+            EXPECT_GE(hotspots[i].partition, 0);
+        }
+        else
+        {
+            EXPECT_EQ(hotspots[i].partition, -1);
+        }
+    }
+
+    profiler->reset();
+    EXPECT_EQ(profiler->getInvokeCount(), 0);
+    EXPECT_TRUE(profiler->getHotspots().empty());
+}
+
+TEST_F(OpProfilerTest, 03_report_is_written)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    {
+        auto interpreter = buildInterpreter(*model);
+
+        APM apm(R"({ "policy" : "CPU_ONLY" })");
+        apm.setProfiling({true, report_path});
+        AutoDelegateSelector ads;
+        EXPECT_TRUE(ads.selectDelegate(*interpreter, apm));
+        EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+        GraphTester graphTester(*interpreter.get());
+        graphTester.fillRandomInputTensor();
+        EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+    }
+
+    std::ifstream file(report_path);
+    ASSERT_TRUE(file.is_open());
+    std::stringstream content;
+    content << file.rdbuf();
+
+    rapidjson::Document d;
+    d.Parse(content.str().c_str());
+    ASSERT_FALSE(d.HasParseError());
+    EXPECT_EQ(d["invoke_count"].GetInt64(), 1);
+    EXPECT_TRUE(d["ops"].IsArray());
+    EXPECT_GT(d["ops"].Size(), 0);
+    const auto &hottest = d["ops"][rapidjson::SizeType(0)];
+    EXPECT_TRUE(hottest.HasMember("op_name"));
+    EXPECT_TRUE(hottest.HasMember("total_us"));
+}
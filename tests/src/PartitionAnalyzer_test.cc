@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <tools/PartitionAnalyzer.h>
+
+#include <tensorflow/lite/kernels/register.h>
+
+using namespace aif;
+
+typedef PartitionAnalyzer PA;
+
+class PartitionAnalyzerTest : public ::testing::Test
+{
+protected:
+    PartitionAnalyzerTest() = default;
+    ~PartitionAnalyzerTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    TfLiteRegistration makeRegistration(int builtinCode, const char *customName = nullptr)
+    {
+        TfLiteRegistration registration = {};
+        registration.builtin_code = builtinCode;
+        registration.custom_name = customName;
+        return registration;
+    }
+};
+
+TEST_F(PartitionAnalyzerTest, 01_predict_partitions)
+{
+    std::vector<PA::NodeClass> nodes = {PA::kNodeSupported, PA::kNodeSupported, PA::kNodeCPU,
+                                        PA::kNodeSupported, PA::kNodeCPU, PA::kNodeCPU,
+                                        PA::kNodeSupported, PA::kNodeSupported, PA::kNodeSupported};
+
+    auto prediction = PA::predict(nodes, 0);
+    EXPECT_EQ(prediction.node_num, 9);
+    EXPECT_EQ(prediction.supported_node_num, 6);
+    EXPECT_EQ(prediction.partition_num, 3);
+    EXPECT_EQ(prediction.delegated_partition_num, 3);
+    EXPECT_EQ(prediction.delegated_node_num, 6);
+    EXPECT_DOUBLE_EQ(prediction.delegated_node_ratio, 6.0 / 9.0);
+}
+
+TEST_F(PartitionAnalyzerTest, 02_predict_keeps_largest_partitions)
+{
+    std::vector<PA::NodeClass> nodes = {PA::kNodeSupported, PA::kNodeSupported, PA::kNodeCPU,
+                                        PA::kNodeSupported, PA::kNodeCPU, PA::kNodeCPU,
+                                        PA::kNodeSupported, PA::kNodeSupported, PA::kNodeSupported};
+
+    auto prediction = PA::predict(nodes, 1);
+    EXPECT_EQ(prediction.partition_num, 3);
+    EXPECT_EQ(prediction.delegated_partition_num, 1);
+    EXPECT_EQ(prediction.delegated_node_num, 3);
+    EXPECT_DOUBLE_EQ(prediction.delegated_node_ratio, 3.0 / 9.0);
+
+    prediction = PA::predict(nodes, 2);
+    EXPECT_EQ(prediction.delegated_partition_num, 2);
+    EXPECT_EQ(prediction.delegated_node_num, 5);
+}
+
+TEST_F(PartitionAnalyzerTest, 03_predict_after_other_delegate)
+{
+    // nodes taken by an earlier delegate split partitions but are not counted
+    std::vector<PA::NodeClass> nodes = {PA::kNodeSupported, PA::kNodeDelegated, PA::kNodeSupported, PA::kNodeCPU};
+
+    auto prediction = PA::predict(nodes, 0);
+    EXPECT_EQ(prediction.node_num, 3);
+    EXPECT_EQ(prediction.partition_num, 2);
+    EXPECT_EQ(prediction.delegated_node_num, 2);
+
+    prediction = PA::predict({}, 0);
+    EXPECT_EQ(prediction.node_num, 0);
+    EXPECT_EQ(prediction.partition_num, 0);
+    EXPECT_DOUBLE_EQ(prediction.delegated_node_ratio, 0.0);
+}
+
+TEST_F(PartitionAnalyzerTest, 04_supported_ops)
+{
+    EXPECT_TRUE(PA::isSupported(PA::kTargetGPU, makeRegistration(tflite::BuiltinOperator_CONV_2D)));
+    EXPECT_TRUE(PA::isSupported(PA::kTargetNNAPI, makeRegistration(tflite::BuiltinOperator_CONV_2D)));
+
+    EXPECT_TRUE(PA::isSupported(PA::kTargetGPU, makeRegistration(tflite::BuiltinOperator_CUSTOM, "Convolution2DTransposeBias")));
+    EXPECT_FALSE(PA::isSupported(PA::kTargetNNAPI, makeRegistration(tflite::BuiltinOperator_CUSTOM, "Convolution2DTransposeBias")));
+    EXPECT_FALSE(PA::isSupported(PA::kTargetGPU, makeRegistration(tflite::BuiltinOperator_CUSTOM, "edgetpu-custom-op")));
+
+    EXPECT_FALSE(PA::isSupported(PA::kTargetGPU, makeRegistration(tflite::BuiltinOperator_DELEGATE)));
+    EXPECT_FALSE(PA::isSupported(PA::kTargetNNAPI, makeRegistration(tflite::BuiltinOperator_DELEGATE)));
+}
+
+TEST_F(PartitionAnalyzerTest, 05_predict_model)
+{
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::InterpreterBuilder(*model.get(), resolver)(&interpreter);
+
+    const auto &subgraph = interpreter->primary_subgraph();
+    auto prediction = PA::predict(subgraph, PA::kTargetGPU, 0);
+    EXPECT_EQ(prediction.node_num, subgraph.execution_plan().size());
+    EXPECT_GT(prediction.supported_node_num, 0);
+    EXPECT_GE(prediction.partition_num, 1);
+
+    auto capped = PA::predict(subgraph, PA::kTargetGPU, 1);
+    EXPECT_EQ(capped.delegated_partition_num, 1);
+    EXPECT_LE(capped.delegated_node_num, prediction.delegated_node_num);
+}
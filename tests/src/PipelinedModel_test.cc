@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <AutoDelegateSelector.h>
+#include <PipelinedModel.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+typedef PipelinedModel::Stage Stage;
+
+class PipelinedModelTest : public ::testing::Test
+{
+protected:
+    PipelinedModelTest() = default;
+    ~PipelinedModelTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    // frame i filled with a pattern of its own
+    static PipelinedModel::Buffers makeInputs(tflite::Interpreter &interpreter, int i)
+    {
+        PipelinedModel::Buffers inputs;
+        for (int index : interpreter.inputs())
+        {
+            const TfLiteTensor *tensor = interpreter.tensor(index);
+            std::vector<uint8_t> buffer(tensor->bytes);
+            if (tensor->type == kTfLiteFloat32)
+            {
+                float *values = reinterpret_cast<float *>(buffer.data());
+                for (size_t j = 0; j < buffer.size() / sizeof(float); j++)
+                    values[j] = static_cast<float>((j * 7 + i * 13) % 256) / 256.0f;
+            }
+            else
+            {
+                for (size_t j = 0; j < buffer.size(); j++)
+                    buffer[j] = static_cast<uint8_t>(j * 7 + i * 13);
+            }
+            inputs.push_back(std::move(buffer));
+        }
+        return inputs;
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(PipelinedModelTest, 01_split_partitions)
+{
+    // CPU CPU GPU CPU GPU GPU CPU
+    std::vector<bool> delegated = {false, false, true, false, true, true, false};
+
+    std::vector<Stage> stages = PipelinedModel::split(delegated, 0);
+    ASSERT_EQ(stages.size(), 6u);
+    EXPECT_EQ(stages[0].begin, 0);
+    EXPECT_EQ(stages[0].end, 2);
+    EXPECT_FALSE(stages[0].delegated);
+    EXPECT_TRUE(stages[1].delegated);
+    EXPECT_EQ(stages[3].begin, 4);
+    EXPECT_EQ(stages[3].end, 5);
+    EXPECT_EQ(stages[4].begin, 5);
+    EXPECT_EQ(stages[5].end, 7);
+
+    stages = PipelinedModel::split(delegated, 2);
+    ASSERT_EQ(stages.size(), 2u);
+    EXPECT_EQ(stages[0].begin, 0);
+    EXPECT_EQ(stages[0].end, stages[1].begin);
+    EXPECT_EQ(stages[1].end, 7);
+    EXPECT_TRUE(stages[0].delegated);
+    EXPECT_TRUE(stages[1].delegated);
+
+    EXPECT_EQ(PipelinedModel::split(std::vector<bool>(5, false), 0).size(), 1u);
+    EXPECT_TRUE(PipelinedModel::split(std::vector<bool>(), 0).empty());
+}
+
+TEST_F(PipelinedModelTest, 02_outputs_match_sequential_invoke)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "pipeline" : { "queue_size" : 2 } })");
+    PipelinedModel pipelinedModel(model, apm);
+    ASSERT_TRUE(pipelinedModel.init());
+    ASSERT_GE(pipelinedModel.getStageNum(), 1);
+    EXPECT_EQ(pipelinedModel.getStages().front().begin, 0);
+
+    std::unique_ptr<tflite::Interpreter> reference;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&reference), kTfLiteOk);
+    AutoDelegateSelector ads;
+    ASSERT_TRUE(ads.selectDelegate(*reference, apm));
+    ASSERT_EQ(reference->AllocateTensors(), kTfLiteOk);
+
+    const int frameNum = 6;
+    std::thread producer([&]() {
+        for (int i = 0; i < frameNum; i++)
+        {
+            EXPECT_TRUE(pipelinedModel.push(makeInputs(*reference, i)));
+        }
+        pipelinedModel.stop();
+    });
+
+    int popped = 0;
+    PipelinedModel::Buffers outputs;
+    while (pipelinedModel.pop(outputs))
+    {
+        ASSERT_EQ(outputs.size(), reference->outputs().size());
+
+        PipelinedModel::Buffers inputs = makeInputs(*reference, popped);
+        for (size_t j = 0; j < inputs.size(); j++)
+        {
+            memcpy(reference->tensor(reference->inputs()[j])->data.raw, inputs[j].data(), inputs[j].size());
+        }
+        ASSERT_EQ(reference->Invoke(), kTfLiteOk);
+
+        for (size_t j = 0; j < outputs.size(); j++)
+        {
+            const TfLiteTensor *expected = reference->tensor(reference->outputs()[j]);
+            ASSERT_EQ(outputs[j].size(), expected->bytes);
+            if (expected->type == kTfLiteFloat32)
+            {
+                const float *actual = reinterpret_cast<const float *>(outputs[j].data());
+                for (size_t k = 0; k < expected->bytes / sizeof(float); k++)
+                    ASSERT_NEAR(actual[k], expected->data.f[k], 1e-4);
+            }
+            else
+            {
+                EXPECT_EQ(memcmp(outputs[j].data(), expected->data.raw, expected->bytes), 0);
+            }
+        }
+        popped++;
+    }
+    producer.join();
+
+    EXPECT_EQ(popped, frameNum);
+    EXPECT_EQ(pipelinedModel.getStats(0)->getInvokeCount(), static_cast<uint64_t>(frameNum));
+    EXPECT_EQ(pipelinedModel.getStats(pipelinedModel.getStageNum()), nullptr);
+
+    // stages without delegate nodes are not delegated, unless the plan has no delegate at all
+    uint64_t delegatedStageNum = 0;
+    uint64_t delegationCount = 0;
+    for (int i = 0; i < pipelinedModel.getStageNum(); i++)
+    {
+        delegatedStageNum += pipelinedModel.getStages()[i].delegated ? 1 : 0;
+        delegationCount += pipelinedModel.getStats(i)->snapshot().delegation_count;
+    }
+    EXPECT_EQ(delegationCount, std::max<uint64_t>(delegatedStageNum, 1));
+}
+
+TEST_F(PipelinedModelTest, 03_reject_frames_after_stop)
+{
+    std::shared_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+
+    APM apm(R"({ "policy" : "CPU_ONLY", "pipeline" : { "max_stages" : 1, "queue_size" : 1 } })");
+    PipelinedModel pipelinedModel(model, apm);
+    ASSERT_TRUE(pipelinedModel.init());
+    EXPECT_EQ(pipelinedModel.getStageNum(), 1);
+
+    EXPECT_FALSE(pipelinedModel.push(PipelinedModel::Buffers()));
+    EXPECT_FALSE(pipelinedModel.push(PipelinedModel::Buffers(1, std::vector<uint8_t>(3))));
+
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+    ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    EXPECT_TRUE(pipelinedModel.push(makeInputs(*interpreter, 0)));
+
+    pipelinedModel.stop();
+    EXPECT_FALSE(pipelinedModel.push(makeInputs(*interpreter, 1)));
+
+    PipelinedModel::Buffers outputs;
+    EXPECT_TRUE(pipelinedModel.pop(outputs));
+    EXPECT_FALSE(outputs.empty());
+    EXPECT_FALSE(pipelinedModel.pop(outputs));
+}
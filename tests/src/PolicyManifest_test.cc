@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <PolicyManifest.h>
+
+#include <algorithm>
+
+#include <tensorflow/lite/model.h>
+
+using namespace aif;
+
+typedef AccelerationPolicyManager APM;
+
+class PolicyManifestTest : public ::testing::Test
+{
+protected:
+    PolicyManifestTest() = default;
+    ~PolicyManifestTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    static bool hasError(const PolicyManifest &manifest, const std::string &error)
+    {
+        const auto &errors = manifest.getErrors();
+        return std::find(errors.begin(), errors.end(), error) != errors.end();
+    }
+
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+};
+
+TEST_F(PolicyManifestTest, 01_find_by_name)
+{
+    PolicyManifest manifest(R"({
+        "defaults" : { "policy" : "MIN_LATENCY" },
+        "models" : {
+            "face" : { },
+            "pose" : { "policy" : "LOAD_BALANCING", "cpu_fallback_percentage" : 20 }
+        }
+    })");
+    EXPECT_TRUE(manifest.isValid());
+    EXPECT_EQ(manifest.getModelNames(), std::vector<std::string>({"face", "pose"}));
+
+    APM apm;
+    ASSERT_TRUE(manifest.find("face", apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kMinimumLatency);
+    ASSERT_TRUE(manifest.find("pose", apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kEnableLoadBalancing);
+    EXPECT_EQ(apm.getCPUFallbackPercentage(), 20);
+    EXPECT_FALSE(manifest.find("hand", apm));
+    EXPECT_EQ(manifest.getDefaults().getPolicy(), APM::kMinimumLatency);
+}
+
+TEST_F(PolicyManifestTest, 02_defaults_are_merged)
+{
+    PolicyManifest manifest(R"({
+        "defaults" : {
+            "policy" : "CPU_ONLY",
+            "xnnpack" : { "num_threads" : 2, "enable_qs8" : true },
+            "delegate_plugins" : { "dir" : "/opt/plugins", "options" : { "NPU" : { "level" : 1 } } }
+        },
+        "models" : {
+            "face" : {
+                "xnnpack" : { "force_fp16" : true },
+                "delegate_plugins" : { "options" : { "TPU" : { } } }
+            }
+        }
+    })");
+    ASSERT_TRUE(manifest.isValid());
+
+    APM apm;
+    ASSERT_TRUE(manifest.find("face", apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kCPUOnly);
+    EXPECT_EQ(apm.getXnnpackOptions().num_threads, 2);
+    EXPECT_TRUE(apm.getXnnpackOptions().enable_qs8);
+    EXPECT_TRUE(apm.getXnnpackOptions().force_fp16);
+    EXPECT_EQ(apm.getDelegatePlugins().dir, "/opt/plugins");
+    EXPECT_EQ(apm.getDelegatePlugins().options.size(), 2u);
+
+    // the defaults themselves are not changed by the entries
+    APM defaults = manifest.getDefaults();
+    EXPECT_FALSE(defaults.getXnnpackOptions().force_fp16);
+    EXPECT_EQ(defaults.getDelegatePlugins().options.size(), 1u);
+}
+
+TEST_F(PolicyManifestTest, 03_find_by_hash)
+{
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    ASSERT_TRUE(model != nullptr);
+    std::string modelHash = PolicyManifest::hashModel(*model);
+    ASSERT_FALSE(modelHash.empty());
+
+    PolicyManifest manifest(R"({ "models" : { "face" : { "model_hash" : ")" + modelHash +
+                            R"(", "policy" : "MAX_PRECISION" }, "other" : { "model_hash" : "0123" } } })");
+    ASSERT_TRUE(manifest.isValid());
+
+    APM apm;
+    ASSERT_TRUE(manifest.findByModel(*model, apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kMaximumPrecision);
+    ASSERT_TRUE(manifest.findByHash("0123", apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kCPUOnly);
+    EXPECT_FALSE(manifest.findByHash("4567", apm));
+}
+
+TEST_F(PolicyManifestTest, 04_invalid_entries_are_reported)
+{
+    PolicyManifest manifest(R"({
+        "defaults" : { "policy" : "MIN_LATENCY" },
+        "models" : {
+            "face" : { "policy" : "FASTEST" },
+            "pose" : { "xnnpack" : { "num_threads" : "2" }, "threads" : { "cluster" : "middle" } },
+            "hand" : { "model_hash" : "0123", "max_memory_mb" : 64 },
+            "hand2" : { "model_hash" : "0123" },
+            "iris" : { "xnnpack" : { "fp16" : true } },
+            "palm" : 3
+        },
+        "version" : 2
+    })");
+    EXPECT_FALSE(manifest.isValid());
+    EXPECT_TRUE(hasError(manifest, "models.face.policy: \"FASTEST\" is not a policy"));
+    EXPECT_TRUE(hasError(manifest, "models.pose.xnnpack.num_threads: must be an integer"));
+    EXPECT_TRUE(hasError(manifest, "models.pose.threads.cluster: \"middle\" is not one of the allowed values"));
+    EXPECT_TRUE(hasError(manifest, "models.hand2.model_hash: already used by models.hand"));
+    EXPECT_TRUE(hasError(manifest, "models.iris.xnnpack.fp16: unknown option"));
+    EXPECT_TRUE(hasError(manifest, "models.palm: must be an object with a name"));
+    EXPECT_TRUE(hasError(manifest, "version: unknown option"));
+    EXPECT_EQ(manifest.getErrors().size(), 7u);
+
+    // the valid entries are still available
+    APM apm;
+    EXPECT_EQ(manifest.getModelNames(), std::vector<std::string>({"hand"}));
+    ASSERT_TRUE(manifest.find("hand", apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kMinimumLatency);
+    EXPECT_EQ(apm.getMaxMemoryMB(), 64);
+    EXPECT_FALSE(manifest.find("face", apm));
+}
+
+TEST_F(PolicyManifestTest, 05_invalid_manifest)
+{
+    PolicyManifest broken(R"({ "models" : { "face" : )");
+    EXPECT_FALSE(broken.isValid());
+    ASSERT_EQ(broken.getErrors().size(), 1u);
+    EXPECT_EQ(broken.getErrors()[0].compare(0, 37, "manifest is not valid JSON at offset "), 0);
+    EXPECT_TRUE(broken.getModelNames().empty());
+
+    PolicyManifest array(R"([ "face" ])");
+    EXPECT_TRUE(hasError(array, "manifest: must be an object"));
+
+    // invalid defaults are dropped, the models still get their own options
+    PolicyManifest defaults(R"({ "defaults" : { "policy" : 1 }, "models" : { "face" : { "max_memory_mb" : 64 } } })");
+    EXPECT_TRUE(hasError(defaults, "defaults.policy: must be a string"));
+    APM apm;
+    ASSERT_TRUE(defaults.find("face", apm));
+    EXPECT_EQ(apm.getPolicy(), APM::kCPUOnly);
+    EXPECT_EQ(apm.getMaxMemoryMB(), 64);
+
+    PolicyManifest models(R"({ "models" : [ "face" ] })");
+    EXPECT_TRUE(hasError(models, "models: must be an object"));
+}
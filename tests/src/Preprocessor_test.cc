@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2022 LG Electronics Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+#include <Preprocessor.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include <tensorflow/lite/kernels/register.h>
+
+using namespace aif;
+
+typedef Preprocessor PP;
+
+class PreprocessorTest : public ::testing::Test
+{
+protected:
+    PreprocessorTest() = default;
+    ~PreprocessorTest() = default;
+
+    void SetUp() override
+    {
+    }
+
+    void TearDown() override
+    {
+    }
+
+    static std::vector<uint8_t> makeFrame(int height, int width, int channels)
+    {
+        std::mt19937 gen(height * 1000 + width * 10 + channels);
+        std::uniform_int_distribution<> dist(0, 255);
+        std::vector<uint8_t> frame(height * width * channels);
+        for (auto &pixel : frame)
+            pixel = static_cast<uint8_t>(dist(gen));
+        // make sure both ends of the range are covered
+        frame[0] = 0;
+        frame[frame.size() - 1] = 255;
+        return frame;
+    }
+
+    static size_t getElementSize(TfLiteType type)
+    {
+        switch (type)
+        {
+        case kTfLiteFloat32:
+            return 4;
+        case kTfLiteFloat16:
+            return 2;
+        default:
+            return 1;
+        }
+    }
+
+    // vector and scalar results may differ by one rounding
+    static void expectClose(TfLiteType type, const std::vector<uint8_t> &actual, const std::vector<uint8_t> &expected)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        size_t n = actual.size() / getElementSize(type);
+        for (size_t i = 0; i < n; i++)
+        {
+            if (type == kTfLiteFloat32)
+            {
+                float a = reinterpret_cast<const float *>(actual.data())[i];
+                float e = reinterpret_cast<const float *>(expected.data())[i];
+                ASSERT_NEAR(a, e, 1e-5 * (1.0 + std::fabs(e))) << "element " << i;
+            }
+            else if (type == kTfLiteFloat16)
+            {
+                int a = reinterpret_cast<const uint16_t *>(actual.data())[i];
+                int e = reinterpret_cast<const uint16_t *>(expected.data())[i];
+                ASSERT_LE(std::abs(a - e), 1) << "element " << i;
+            }
+            else if (type == kTfLiteInt8)
+            {
+                ASSERT_LE(std::abs(static_cast<int8_t>(actual[i]) - static_cast<int8_t>(expected[i])), 1) << "element " << i;
+            }
+            else
+            {
+                ASSERT_LE(std::abs(actual[i] - expected[i]), 1) << "element " << i;
+            }
+        }
+    }
+};
+
+TEST_F(PreprocessorTest, 01_scalar_reference)
+{
+    // two RGB pixels
+    std::vector<uint8_t> frame = {0, 128, 255, 64, 32, 16};
+
+    PP preprocessor({{127.5f}, {127.5f}, PP::kLayoutHWC});
+    preprocessor.setIsa(PP::kIsaScalar);
+    EXPECT_EQ(preprocessor.getIsa(), PP::kIsaScalar);
+
+    std::vector<float> floats(6);
+    ASSERT_TRUE(preprocessor.convert(frame.data(), 1, 2, 3, kTfLiteFloat32, {0.0f, 0}, floats.data(), 24));
+    for (int i = 0; i < 6; i++)
+    {
+        EXPECT_NEAR(floats[i], (frame[i] - 127.5f) / 127.5f, 1e-6);
+    }
+
+    // per channel mean and stddev
+    PP perChannel({{0.0f, 100.0f, 200.0f}, {1.0f, 2.0f, 4.0f}, PP::kLayoutHWC});
+    perChannel.setIsa(PP::kIsaScalar);
+    ASSERT_TRUE(perChannel.convert(frame.data(), 1, 2, 3, kTfLiteFloat32, {0.0f, 0}, floats.data(), 24));
+    EXPECT_FLOAT_EQ(floats[0], 0.0f);
+    EXPECT_FLOAT_EQ(floats[1], 14.0f);
+    EXPECT_FLOAT_EQ(floats[2], 13.75f);
+    EXPECT_FLOAT_EQ(floats[3], 64.0f);
+    EXPECT_FLOAT_EQ(floats[4], -34.0f);
+    EXPECT_FLOAT_EQ(floats[5], -46.0f);
+
+    // float16 bit patterns of -1, ~0.004, 1 and 0
+    std::vector<uint8_t> halfFrame = {0, 128, 255, 128, 0, 0};
+    PP half({{127.5f}, {127.5f}, PP::kLayoutHWC});
+    half.setIsa(PP::kIsaScalar);
+    std::vector<uint16_t> halves(6);
+    ASSERT_TRUE(half.convert(halfFrame.data(), 1, 2, 3, kTfLiteFloat16, {0.0f, 0}, halves.data(), 12));
+    EXPECT_EQ(halves[0], 0xbc00);
+    EXPECT_EQ(halves[2], 0x3c00);
+    EXPECT_EQ(halves[1], 0x1c04);
+
+    // int8 with scale 1/128 and zero point 0 maps [-1, 1] onto [-128, 127]
+    std::vector<int8_t> int8s(6);
+    ASSERT_TRUE(preprocessor.convert(frame.data(), 1, 2, 3, kTfLiteInt8, {1.0f / 128.0f, 0}, int8s.data(), 6));
+    EXPECT_EQ(int8s[0], -128);
+    EXPECT_EQ(int8s[1], 1);
+    EXPECT_EQ(int8s[2], 127);
+    EXPECT_EQ(int8s[3], -64);
+
+    // uint8 without normalization and with an identity quantization is a copy
+    PP raw({{}, {}, PP::kLayoutHWC});
+    std::vector<uint8_t> copy(6);
+    ASSERT_TRUE(raw.convert(frame.data(), 1, 2, 3, kTfLiteUInt8, {1.0f, 0}, copy.data(), 6));
+    EXPECT_EQ(copy, frame);
+}
+
+TEST_F(PreprocessorTest, 02_vector_kernels_match_scalar)
+{
+    const TfLiteType types[] = {kTfLiteFloat32, kTfLiteFloat16, kTfLiteInt8, kTfLiteUInt8};
+    const TfLiteQuantizationParams quantizations[] = {{0.0f, 0}, {0.0f, 0}, {0.0078125f, -1}, {0.02f, 3}};
+    const int shapes[][3] = {{17, 23, 3}, {16, 16, 4}, {5, 7, 1}, {9, 31, 2}, {1, 1, 3}};
+    const PP::Layout layouts[] = {PP::kLayoutHWC, PP::kLayoutCHW};
+
+    int tested = 0;
+    for (PP::Isa isa : {PP::kIsaSSE2, PP::kIsaAVX2, PP::kIsaNEON})
+    {
+        for (auto layout : layouts)
+        {
+            for (const auto &shape : shapes)
+            {
+                int height = shape[0], width = shape[1], channels = shape[2];
+                std::vector<uint8_t> frame = makeFrame(height, width, channels);
+                std::vector<float> mean(channels), stddev(channels);
+                for (int c = 0; c < channels; c++)
+                {
+                    mean[c] = 100.0f + 10.0f * c;
+                    stddev[c] = 50.0f + 3.0f * c;
+                }
+
+                PP reference({mean, stddev, layout});
+                reference.setIsa(PP::kIsaScalar);
+                PP preprocessor({mean, stddev, layout});
+                preprocessor.setIsa(isa);
+                if (preprocessor.getIsa() != isa)
+                {
+                    continue;
+                }
+
+                for (int t = 0; t < 4; t++)
+                {
+                    size_t bytes = frame.size() * getElementSize(types[t]);
+                    std::vector<uint8_t> expected(bytes), actual(bytes);
+                    ASSERT_TRUE(reference.convert(frame.data(), height, width, channels, types[t], quantizations[t], expected.data(), bytes));
+                    ASSERT_TRUE(preprocessor.convert(frame.data(), height, width, channels, types[t], quantizations[t], actual.data(), bytes));
+                    SCOPED_TRACE(testing::Message() << "isa " << isa << " layout " << layout << " type " << types[t]
+                                                    << " shape " << height << "x" << width << "x" << channels);
+                    expectClose(types[t], actual, expected);
+                    tested++;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(PP::getBestIsa() == PP::kIsaScalar, tested == 0);
+}
+
+TEST_F(PreprocessorTest, 03_chw_layout)
+{
+    std::vector<uint8_t> frame = makeFrame(3, 5, 3);
+    PP hwc({{10.0f, 20.0f, 30.0f}, {2.0f}, PP::kLayoutHWC});
+    PP chw({{10.0f, 20.0f, 30.0f}, {2.0f}, PP::kLayoutCHW});
+
+    std::vector<float> interleaved(frame.size()), planar(frame.size());
+    ASSERT_TRUE(hwc.convert(frame.data(), 3, 5, 3, kTfLiteFloat32, {0.0f, 0}, interleaved.data(), frame.size() * 4));
+    ASSERT_TRUE(chw.convert(frame.data(), 3, 5, 3, kTfLiteFloat32, {0.0f, 0}, planar.data(), frame.size() * 4));
+    for (int c = 0; c < 3; c++)
+    {
+        for (int i = 0; i < 15; i++)
+        {
+            EXPECT_FLOAT_EQ(planar[c * 15 + i], interleaved[i * 3 + c]);
+        }
+    }
+}
+
+TEST_F(PreprocessorTest, 04_fill_input_tensor)
+{
+    std::string model_path = std::string(AIF_INSTALL_DIR) + std::string("/model/face_detection_short_range.tflite");
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
+    ASSERT_TRUE(model != nullptr);
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(tflite::InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+    ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+
+    const TfLiteTensor *input = interpreter->input_tensor(0);
+    ASSERT_EQ(input->dims->size, 4);
+    int height = input->dims->data[1], width = input->dims->data[2], channels = input->dims->data[3];
+    std::vector<uint8_t> frame = makeFrame(height, width, channels);
+
+    PP preprocessor({{127.5f}, {127.5f}, PP::kLayoutHWC});
+    ASSERT_TRUE(preprocessor.fill(frame.data(), height, width, channels, *interpreter));
+    ASSERT_EQ(input->type, kTfLiteFloat32);
+    const float *values = interpreter->typed_input_tensor<float>(0);
+    for (size_t i = 0; i < frame.size(); i++)
+    {
+        ASSERT_NEAR(values[i], (frame[i] - 127.5f) / 127.5f, 1e-5);
+    }
+    EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+
+    // a frame of another size or a tensor of the other layout is refused
+    EXPECT_FALSE(preprocessor.fill(frame.data(), height / 2, width, channels, *interpreter));
+    PP planar({{127.5f}, {127.5f}, PP::kLayoutCHW});
+    EXPECT_FALSE(planar.fill(frame.data(), height, width, channels, *interpreter));
+    EXPECT_FALSE(preprocessor.fill(frame.data(), height, width, channels, *interpreter, 1));
+}
+
+TEST_F(PreprocessorTest, 05_invalid_arguments)
+{
+    std::vector<uint8_t> frame = makeFrame(2, 2, 3);
+    std::vector<float> floats(12);
+
+    PP preprocessor({{}, {}, PP::kLayoutHWC});
+    EXPECT_FALSE(preprocessor.convert(nullptr, 2, 2, 3, kTfLiteFloat32, {0.0f, 0}, floats.data(), 48));
+    EXPECT_FALSE(preprocessor.convert(frame.data(), 2, 2, 3, kTfLiteFloat32, {0.0f, 0}, floats.data(), 44));
+    EXPECT_FALSE(preprocessor.convert(frame.data(), 2, 2, 3, kTfLiteInt32, {0.0f, 0}, floats.data(), 48));
+    EXPECT_FALSE(preprocessor.convert(frame.data(), 2, 2, 3, kTfLiteInt8, {0.0f, 0}, floats.data(), 12));
+    EXPECT_FALSE(preprocessor.convert(frame.data(), 1, 1, 12, kTfLiteFloat32, {0.0f, 0}, floats.data(), 48));
+
+    PP zeroStddev({{}, {0.0f}, PP::kLayoutHWC});
+    EXPECT_FALSE(zeroStddev.convert(frame.data(), 2, 2, 3, kTfLiteFloat32, {0.0f, 0}, floats.data(), 48));
+    PP twoMeans({{1.0f, 2.0f}, {}, PP::kLayoutHWC});
+    EXPECT_FALSE(twoMeans.convert(frame.data(), 2, 2, 3, kTfLiteFloat32, {0.0f, 0}, floats.data(), 48));
+}